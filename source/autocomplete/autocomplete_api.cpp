@@ -173,8 +173,8 @@ static void update_quality(std::vector<Autocomplete<nt::idx_t>::fl_quality>& ac_
 static std::unordered_set<std::string> get_main_stop_areas(const navitia::type::Data& d) {
     std::unordered_set<std::string> result;
     for (const auto& admin : d.geo_ref->admins) {
-        for (const auto& sa : admin->main_stop_areas) {
-            result.insert(sa->uri);
+        for (const auto& sa_uri : admin->main_stop_area_uris) {
+            result.insert(sa_uri);
         }
     }
     return result;
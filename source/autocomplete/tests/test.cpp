@@ -619,7 +619,7 @@ BOOST_AUTO_TEST_CASE(autocomplete_main_stop_area_test) {
     ad->postal_codes.push_back("29000");
     ad->idx = 0;
     b.data->geo_ref->admins.push_back(ad);
-    ad->main_stop_areas.push_back(b.data->pt_data->stop_areas_map["Luther King"]);
+    ad->main_stop_area_uris.push_back("Luther King");
     b.manage_admin();
     b.build_autocomplete();
 
@@ -32,6 +32,7 @@ www.navitia.io
 
 #include "conf.h"
 #include "ed_reader.h"
+#include "type/flat_nav.h"
 #include "type/meta_data.h"
 #include "utils/exception.h"
 #include "utils/functions.h"
@@ -409,6 +410,25 @@ int ed2nav(int argc, const char* argv[]) {
         LOG4CPLUS_ERROR(logger, "Exiting ed2nav with errors");
         return 1;
     }
+
+    // written after the .nav: a kraken loading the new .nav along the
+    // previous flat nav ignores the latter
+    const std::string flat_output = navitia::type::flat_nav_filename(output);
+    // only saved in the flat nav, kraken searching the direct paths without them otherwise
+    LOG4CPLUS_INFO(logger, "Building the contraction hierarchies ...");
+    data.geo_ref->build_contraction_hierarchies();
+    LOG4CPLUS_INFO(logger, "Begin to save flat nav " << flat_output << " ...");
+    try {
+        data.save_flat_nav(flat_output + ".temp");
+    } catch (const navitia::exception& e) {
+        LOG4CPLUS_ERROR(logger, "Unable to save " << flat_output << ": " << e.what());
+        LOG4CPLUS_ERROR(logger, "Exiting ed2nav with errors");
+        return 1;
+    }
+    if (!rename_file(flat_output + ".temp", flat_output)) {
+        LOG4CPLUS_ERROR(logger, "Exiting ed2nav with errors");
+        return 1;
+    }
     save = (pt::microsec_clock::local_time() - start).total_milliseconds();
 
     LOG4CPLUS_INFO(logger, "Computing times");
@@ -72,10 +72,12 @@ struct Admin : nt::Header, nt::Nameable {
     nt::GeographicalCoord coord;
     multi_polygon_type boundary;
     std::vector<const Admin*> admin_list;
-    std::vector<const nt::StopArea*> main_stop_areas;
+    // uris of the stop areas rather than pointers, as the admins are
+    // shared by the successive realtime data (see Data::clone_from)
+    std::vector<std::string> main_stop_area_uris;
 
     // TODO ODT NTFSv0.3: remove that when we stop to support NTFSv0.1
-    std::vector<const nt::StopPoint*> odt_stop_points;  // zone odt stop points for the admin
+    std::vector<std::string> odt_stop_point_uris;  // zone odt stop points for the admin
     Postal_codes postal_codes;
 
     Admin() : level(-1) {}
@@ -92,8 +94,8 @@ struct Admin : nt::Header, nt::Nameable {
     std::string postal_codes_to_string() const;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
-        ar& idx& level& from_original_dataset& insee& name& uri& coord& admin_list& main_stop_areas& label&
-            odt_stop_points& postal_codes;
+        ar& idx& level& from_original_dataset& insee& name& uri& coord& admin_list& main_stop_area_uris& label&
+            odt_stop_point_uris& postal_codes;
     }
 };
 
@@ -30,10 +30,12 @@ www.navitia.io
 
 #include "astar_path_finder.h"
 
+#include "georef/street_graph.h"
 #include "visitor.h"
 
 #include <boost/graph/astar_search.hpp>
 #include <boost/graph/filtered_graph.hpp>
+#include <boost/optional.hpp>
 
 namespace navitia {
 namespace georef {
@@ -74,6 +76,56 @@ void AstarPathFinder::start_distance_or_target_astar(const navitia::time_duratio
     }
 }
 
+std::pair<navitia::time_duration, ProjectionData::Direction> AstarPathFinder::start_distance_or_target_hierarchy(
+    const ContractionHierarchy& hierarchy,
+    const navitia::time_duration& radius,
+    const ProjectionData& destination) {
+    const std::pair<navitia::time_duration, ProjectionData::Direction> not_found{bt::pos_infin, source_e};
+    if (!starting_edge.found || !destination.found) {
+        return not_found;
+    }
+    computation_launch = true;
+
+    // the hierarchy holds the durations of the edges, not divided by the speed factor
+    std::vector<ContractionHierarchyQuery::Endpoint> sources;
+    for (const auto v : {starting_edge[source_e], starting_edge[target_e]}) {
+        if (distances[v] != bt::pos_infin) {
+            sources.push_back({v, ContractionHierarchy::edge_ticks(distances[v], speed_factor)});
+        }
+    }
+    const auto ends = get_target_ends(destination);
+    std::vector<ContractionHierarchyQuery::Endpoint> targets;
+    for (const auto& end : ends) {
+        targets.push_back({destination[end.first], ContractionHierarchy::edge_ticks(end.second, speed_factor)});
+    }
+
+    const auto path = hierarchy_query.shortest_path(hierarchy, sources, targets,
+                                                    ContractionHierarchy::edge_ticks(radius, speed_factor));
+    if (path.empty()) {
+        return not_found;
+    }
+    const auto combiner = SpeedDistanceCombiner(speed_factor);
+    for (size_t i = 1; i < path.size(); ++i) {
+        boost::optional<navitia::time_duration> duration;
+        for (const auto& e : boost::make_iterator_range(boost::out_edges(path[i - 1], geo_ref.graph))) {
+            if (boost::target(e, geo_ref.graph) == path[i] && (!duration || geo_ref.graph[e].duration < *duration)) {
+                duration = geo_ref.graph[e].duration;
+            }
+        }
+        if (!duration) {
+            throw navitia::exception("impossible to find an edge");
+        }
+        predecessors[path[i]] = path[i - 1];
+        distances[path[i]] = combiner(distances[path[i - 1]], *duration);
+    }
+    for (const auto& end : ends) {
+        if (destination[end.first] == path.back()) {
+            return {distances[path.back()] + end.second, end.first};
+        }
+    }
+    return not_found;
+}
+
 /**
  * Launch an astar without initializing the data structure
  * Warning, it modifies the distances and the predecessors
@@ -90,14 +142,23 @@ void AstarPathFinder::astar(const std::array<georef::vertex_t, 2>& origin_vertex
                         / boost::two_bit_color_map<>::elements_per_char,
               0);
 
-    // we filter the graph to only use certain mean of transport
-    using filtered_graph = boost::filtered_graph<georef::Graph, boost::keep_all, TransportationModeFilter>;
-    auto g = filtered_graph(geo_ref.graph, {}, TransportationModeFilter(mode, geo_ref));
-    auto weight_map = boost::get(&Edge::duration, geo_ref.graph);
+    auto filter = TransportationModeFilter(mode, geo_ref);
     auto combiner = SpeedDistanceCombiner(speed_factor);
 
-    astar_shortest_paths_no_init_with_heap(g, origin_vertexes.front(), origin_vertexes.back(), heuristic, visitor,
-                                           weight_map, combiner);
+    // we filter the graph to only use certain mean of transport
+    // the compact street graph is searched unless the graph has been modified since its build
+    if (geo_ref.street_graph && geo_ref.street_graph->is_built_from(geo_ref.graph)) {
+        const StreetGraph::View g(*geo_ref.street_graph, filter.acceptable_modes);
+        auto weight_map = g.duration_map();
+        astar_shortest_paths_no_init_with_heap(g, origin_vertexes.front(), origin_vertexes.back(), heuristic, visitor,
+                                               weight_map, combiner);
+    } else {
+        using filtered_graph = boost::filtered_graph<georef::Graph, boost::keep_all, TransportationModeFilter>;
+        auto g = filtered_graph(geo_ref.graph, {}, filter);
+        auto weight_map = boost::get(&Edge::duration, geo_ref.graph);
+        astar_shortest_paths_no_init_with_heap(g, origin_vertexes.front(), origin_vertexes.back(), heuristic, visitor,
+                                               weight_map, combiner);
+    }
 }
 
 template <class Graph, class WeightMap, class Compare>
@@ -109,16 +170,26 @@ void AstarPathFinder::astar_shortest_paths_no_init_with_heap(const Graph& g,
                                                              const WeightMap& weight,
                                                              const SpeedDistanceCombiner& combine,
                                                              const Compare& compare) {
+    auto visit = [&](auto& Q) {
+        using Queue = typename std::remove_reference<decltype(Q)>::type;
+        boost::detail::astar_bfs_visitor<astar_distance_heuristic, astar_distance_or_target_visitor, Queue,
+                                         predecessor_map, duration_map, duration_map, WeightMap,
+                                         boost::two_bit_color_map<>, SpeedDistanceCombiner, Compare>
+            bfs_vis(h, vis, Q, predecessor_map(&predecessors[0]), duration_map(&costs[0]), duration_map(&distances[0]),
+                    weight, color, combine, compare, navitia::seconds(0));
+
+        breadth_first_visit(g, &s_begin, &s_end, Q, bfs_vis, color);
+    };
+
+    // the radix heap always orders by increasing costs, as the default compare
+    if (priority_queue == PriorityQueue_e::radix_heap) {
+        radix_heap.reset(&costs[0]);
+        visit(radix_heap);
+        return;
+    }
     using MutableQueue = boost::d_ary_heap_indirect<vertex_t, 4, vertex_t*, navitia::time_duration*, Compare>;
     MutableQueue Q(&costs[0], &index_in_heap_map[0], compare);
-
-    boost::detail::astar_bfs_visitor<astar_distance_heuristic, astar_distance_or_target_visitor, MutableQueue,
-                                     vertex_t*, navitia::time_duration*, navitia::time_duration*, WeightMap,
-                                     boost::two_bit_color_map<>, SpeedDistanceCombiner, Compare>
-        bfs_vis(h, vis, Q, &predecessors[0], &costs[0], &distances[0], weight, color, combine, compare,
-                navitia::seconds(0));
-
-    breadth_first_visit(g, &s_begin, &s_end, Q, bfs_vis, color);
+    visit(Q);
 }
 
 // The cost of a starting edge is the distance from this edge to the projected destination point (distance_to_dest)
@@ -32,6 +32,7 @@ www.navitia.io
 
 #include "path_finder.h"
 #include "visitor.h"
+#include "georef/contraction_hierarchy.h"
 
 #include <boost/graph/astar_search.hpp>
 #include <boost/graph/filtered_graph.hpp>
@@ -71,6 +72,22 @@ public:
                                         const type::GeographicalCoord& dest_projected,
                                         const std::vector<vertex_t>& destinations);
 
+    /**
+     * Search the path to the destination in the contraction hierarchy of
+     * the mode instead of launching an astar.
+     *
+     * The distances and the predecessors are only set along the path.
+     * Returns the duration to the destination and its nearest vertex, as
+     * find_nearest_vertex would after an astar.
+     **/
+    std::pair<navitia::time_duration, ProjectionData::Direction> start_distance_or_target_hierarchy(
+        const ContractionHierarchy& hierarchy,
+        const navitia::time_duration& radius,
+        const ProjectionData& destination);
+
+    // number of vertices settled by the last search in a contraction hierarchy
+    size_t nb_hierarchy_settled() const { return hierarchy_query.nb_settled; }
+
     /**
      * Launch an astar without initializing the data structure
      * Warning, it modifies the distances and the predecessors
@@ -80,6 +97,8 @@ public:
                const astar_distance_or_target_visitor& visitor);
 
 private:
+    ContractionHierarchyQuery hierarchy_query;
+
     template <class Graph, class WeightMap, class Compare = std::less<navitia::time_duration>>
     void astar_shortest_paths_no_init_with_heap(const Graph& g,
                                                 const vertex_t& s_begin,
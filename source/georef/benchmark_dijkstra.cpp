@@ -0,0 +1,145 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "georef/astar_path_finder.h"
+#include "georef/dijkstra_path_finder.h"
+#include "type/data.h"
+#include "utils/init.h"
+#include "utils/timer.h"
+
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace navitia;
+using namespace navitia::georef;
+namespace po = boost::program_options;
+
+namespace {
+
+struct Stats {
+    double duration_s = 0;
+    size_t nb_settled = 0;
+
+    template <typename Search>
+    void measure(const PathFinder& finder, Search search) {
+        const auto begin = std::chrono::steady_clock::now();
+        search();
+        duration_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        for (vertex_t v = 0; v < boost::num_vertices(finder.geo_ref.graph); ++v) {
+            nb_settled += boost::get(finder.color, v) == boost::two_bit_black;
+        }
+    }
+
+    void print(const std::string& name) const {
+        std::cout << name << ": " << duration_s * 1000 << "ms, " << nb_settled << " settled vertices, "
+                  << (duration_s > 0 ? nb_settled / duration_s : 0) << " settled vertices/s" << std::endl;
+    }
+};
+
+const char* queue_name(PriorityQueue_e priority_queue) {
+    return priority_queue == PriorityQueue_e::radix_heap ? "radix heap" : "d-ary heap";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Options of the street network dijkstra benchmark");
+    std::string file;
+    int iterations, radius_minutes;
+
+    // clang-format off
+    desc.add_options()
+            ("help", "Show this message")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"), "Path to data.nav.lz4")
+            ("iterations,i", po::value<int>(&iterations)->default_value(100), "Number of searches by mode")
+            ("radius", po::value<int>(&radius_minutes)->default_value(30),
+                     "Maximal duration of the radius dijkstras in minutes");
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to compare the priority queues of the street network searches" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Data loading: " + file);
+        data.load_nav(file);
+        data.build_proximity_list();
+    }
+    const auto& geo_ref = *data.geo_ref;
+    const auto& graph = geo_ref.graph;
+    const auto radius = navitia::minutes(radius_minutes);
+    const auto max_duration = navitia::hours(24);
+    std::uniform_int_distribution<vertex_t> gen(0, geo_ref.nb_vertex_by_mode - 1);
+
+    for (const auto mode : {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car}) {
+        // the same origins and destinations for both queues
+        std::mt19937 rng(31442);
+        std::vector<std::pair<type::GeographicalCoord, ProjectionData>> pairs;
+        for (int i = 0; i < iterations; ++i) {
+            const auto origin = graph[gen(rng)].coord;
+            const auto destination = graph[gen(rng)].coord;
+            pairs.emplace_back(origin, ProjectionData(destination, geo_ref, mode));
+        }
+
+        std::cout << "Searches by " << mode << std::endl;
+        for (const auto priority_queue : {PriorityQueue_e::d_ary_heap, PriorityQueue_e::radix_heap}) {
+            DijkstraPathFinder dijkstra(geo_ref);
+            dijkstra.priority_queue = priority_queue;
+            AstarPathFinder astar(geo_ref);
+            astar.priority_queue = priority_queue;
+
+            Stats dijkstra_stats, astar_stats;
+            for (const auto& origin_destination : pairs) {
+                const auto& destination = origin_destination.second;
+                dijkstra.init(origin_destination.first, mode, 1);
+                dijkstra_stats.measure(dijkstra, [&]() { dijkstra.start_distance_dijkstra(radius); });
+                astar.init(origin_destination.first, destination.projected, mode, 1);
+                astar_stats.measure(astar, [&]() {
+                    astar.start_distance_or_target_astar(max_duration, destination.projected,
+                                                         {destination[source_e], destination[target_e]});
+                });
+            }
+            dijkstra_stats.print(std::string("  dijkstra of ") + std::to_string(radius_minutes) + "min with "
+                                 + queue_name(priority_queue));
+            astar_stats.print(std::string("  astar with ") + queue_name(priority_queue));
+        }
+    }
+}
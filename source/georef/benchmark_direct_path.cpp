@@ -0,0 +1,200 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "georef/astar_path_finder.h"
+#include "georef/contraction_hierarchy.h"
+#include "type/data.h"
+#include "utils/init.h"
+#include "utils/timer.h"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace navitia;
+using namespace navitia::georef;
+namespace po = boost::program_options;
+
+namespace {
+
+struct Measure {
+    double duration_us = 0;
+    size_t nb_settled = 0;
+    time_duration path_duration = bt::pos_infin;
+};
+
+struct Stats {
+    std::vector<double> durations_us;
+    std::vector<size_t> nb_settled;
+
+    void add(const Measure& measure) {
+        durations_us.push_back(measure.duration_us);
+        nb_settled.push_back(measure.nb_settled);
+    }
+
+    template <typename T>
+    static T median(std::vector<T> values) {
+        if (values.empty()) {
+            return {};
+        }
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        return values[values.size() / 2];
+    }
+    template <typename T>
+    static double mean(const std::vector<T>& values) {
+        double sum = 0;
+        for (const auto& value : values) {
+            sum += value;
+        }
+        return values.empty() ? 0 : sum / values.size();
+    }
+
+    void print(const std::string& name) const {
+        std::cout << name << ": mean " << mean(durations_us) / 1000 << "ms, median " << median(durations_us) / 1000
+                  << "ms, settled vertices: mean " << mean(nb_settled) << ", median " << median(nb_settled)
+                  << std::endl;
+    }
+};
+
+template <typename Search>
+Measure measure(AstarPathFinder& finder,
+                const type::GeographicalCoord& origin,
+                const ProjectionData& destination,
+                type::Mode_e mode,
+                Search search) {
+    finder.init(origin, destination.projected, mode, 1);
+    Measure result;
+    const auto begin = std::chrono::steady_clock::now();
+    const auto nearest = search();
+    const auto path = finder.get_path(destination, nearest);
+    result.duration_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    if (!path.path_items.empty()) {
+        result.path_duration = path.duration;
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Options of the direct path benchmark");
+    std::string file;
+    int iterations;
+    double min_distance, max_distance;
+
+    // clang-format off
+    desc.add_options()
+            ("help", "Show this message")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"),
+                     "Path to data.nav.lz4, with its flat nav holding the contraction hierarchies")
+            ("iterations,i", po::value<int>(&iterations)->default_value(100), "Number of direct paths by mode")
+            ("min_distance", po::value<double>(&min_distance)->default_value(10000),
+                     "Minimal crow fly distance of a direct path in meters")
+            ("max_distance", po::value<double>(&max_distance)->default_value(200000),
+                     "Maximal crow fly distance of a direct path in meters");
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to compare the direct paths by astar and in a contraction hierarchy" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Data loading: " + file);
+        data.load_nav(file);
+        data.build_proximity_list();
+    }
+    auto& geo_ref = *data.geo_ref;
+    if (!geo_ref.get_contraction_hierarchy(type::Mode_e::Car)) {
+        Timer t("No contraction hierarchy in the flat nav, building them");
+        geo_ref.build_contraction_hierarchies();
+    }
+
+    std::mt19937 rng(31442);
+    const auto& graph = geo_ref.graph;
+    AstarPathFinder finder(geo_ref);
+    for (const auto mode : {type::Mode_e::Car, type::Mode_e::Bike}) {
+        const auto* hierarchy = geo_ref.get_contraction_hierarchy(mode);
+        if (!hierarchy) {
+            std::cout << "No contraction hierarchy for " << mode << std::endl;
+            continue;
+        }
+        // as StreetNetwork::get_direct_path, the car arrives on the walking graph
+        const auto dest_mode = mode == type::Mode_e::Car ? type::Mode_e::Walking : mode;
+        const auto max_duration = navitia::hours(24);
+        std::uniform_int_distribution<vertex_t> gen(0, geo_ref.nb_vertex_by_mode - 1);
+
+        Stats astar_stats, hierarchy_stats;
+        size_t nb_different = 0;
+        for (int i = 0; i < iterations; ++i) {
+            type::GeographicalCoord origin, destination_coord;
+            double distance = 0;
+            do {
+                origin = graph[gen(rng)].coord;
+                destination_coord = graph[gen(rng)].coord;
+                distance = origin.distance_to(destination_coord);
+            } while (distance < min_distance || distance > max_distance);
+            const auto destination = ProjectionData(destination_coord, geo_ref, dest_mode);
+
+            auto with_astar = measure(finder, origin, destination, mode, [&]() {
+                finder.start_distance_or_target_astar(max_duration, destination.projected,
+                                                      {destination[source_e], destination[target_e]});
+                return finder.find_nearest_vertex(destination, true);
+            });
+            for (vertex_t v = 0; v < boost::num_vertices(graph); ++v) {
+                with_astar.nb_settled += boost::get(finder.color, v) == boost::two_bit_black;
+            }
+            auto in_hierarchy = measure(finder, origin, destination, mode, [&]() {
+                return finder.start_distance_or_target_hierarchy(*hierarchy, max_duration, destination);
+            });
+            in_hierarchy.nb_settled = finder.nb_hierarchy_settled();
+
+            astar_stats.add(with_astar);
+            hierarchy_stats.add(in_hierarchy);
+            nb_different += with_astar.path_duration != in_hierarchy.path_duration;
+        }
+        std::cout << "Direct paths by " << mode << " between " << min_distance << "m and " << max_distance << "m"
+                  << std::endl;
+        astar_stats.print("  astar");
+        hierarchy_stats.print("  contraction hierarchy");
+        std::cout << "  paths of different durations: " << nb_different << "/" << iterations << std::endl;
+    }
+}
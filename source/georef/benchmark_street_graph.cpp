@@ -0,0 +1,133 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "georef/dijkstra_path_finder.h"
+#include "georef/street_graph.h"
+#include "type/data.h"
+#include "utils/init.h"
+#include "utils/timer.h"
+
+#include <boost/program_options.hpp>
+
+#include <malloc.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace navitia;
+using namespace navitia::georef;
+namespace po = boost::program_options;
+
+namespace {
+
+// bytes allocated on the heap
+size_t heap_size() {
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return static_cast<unsigned int>(mallinfo().uordblks);
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Options of the street graph benchmark");
+    std::string file;
+    int iterations, radius_minutes;
+
+    // clang-format off
+    desc.add_options()
+            ("help", "Show this message")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"), "Path to data.nav.lz4")
+            ("iterations,i", po::value<int>(&iterations)->default_value(100), "Number of dijkstras by mode")
+            ("radius", po::value<int>(&radius_minutes)->default_value(30),
+                     "Maximal duration of the dijkstras in minutes");
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to compare the searches and the memory of the street graph and the boost graph"
+                  << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Data loading: " + file);
+        data.load_nav(file);
+        data.build_proximity_list();
+    }
+    auto& geo_ref = *data.geo_ref;
+    const auto street_graph = geo_ref.street_graph;
+    if (!street_graph) {
+        std::cout << "No street graph built" << std::endl;
+        return 1;
+    }
+
+    // the heap used by a copy of the boost graph, its vertices, out edges and Edge properties
+    {
+        const auto before = heap_size();
+        const Graph copy(geo_ref.graph);
+        const auto graph_size = heap_size() - before;
+        std::cout << "boost graph: " << boost::num_vertices(copy) << " vertices, " << boost::num_edges(copy)
+                  << " edges, " << graph_size / (1024. * 1024.) << "MB" << std::endl;
+        std::cout << "street graph: " << street_graph->memory_size() / (1024. * 1024.) << "MB, "
+                  << 100. * street_graph->memory_size() / graph_size << "% of the boost graph" << std::endl;
+    }
+
+    const auto radius = navitia::minutes(radius_minutes);
+    std::uniform_int_distribution<vertex_t> gen(0, geo_ref.nb_vertex_by_mode - 1);
+    for (const auto mode : {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car}) {
+        std::cout << "Dijkstras of " << radius_minutes << "min by " << mode << std::endl;
+        for (const bool on_street_graph : {false, true}) {
+            // without the street graph, the path finders search the boost graph
+            geo_ref.street_graph = on_street_graph ? street_graph : nullptr;
+            std::mt19937 rng(31442);
+            DijkstraPathFinder finder(geo_ref);
+            double duration_s = 0;
+            for (int i = 0; i < iterations; ++i) {
+                finder.init(geo_ref.graph[gen(rng)].coord, mode, 1);
+                const auto begin = std::chrono::steady_clock::now();
+                finder.start_distance_dijkstra(radius);
+                duration_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            }
+            std::cout << (on_street_graph ? "  street graph: " : "  boost graph: ") << duration_s * 1000 << "ms"
+                      << std::endl;
+        }
+    }
+    geo_ref.street_graph = street_graph;
+}
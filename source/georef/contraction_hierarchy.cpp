@@ -0,0 +1,532 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "georef/contraction_hierarchy.h"
+
+#include "georef/georef.h"
+#include "utils/exception.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace navitia {
+namespace georef {
+
+namespace {
+
+using Arc = ContractionHierarchy::Arc;
+using Label = std::pair<uint64_t, uint32_t>;
+using Queue = std::priority_queue<Label, std::vector<Label>, std::greater<Label>>;
+
+const uint64_t infinite_duration = std::numeric_limits<uint64_t>::max();
+
+// a witness search gives up after this number of settled vertices, adding a useless shortcut at worst
+const size_t max_witness_settled = 100;
+
+// the graph being contracted: the arcs to the contracted vertices are removed
+struct Contraction {
+    std::vector<std::vector<Arc>> out_arcs;
+    std::vector<std::vector<Arc>> in_arcs;
+    std::vector<uint32_t> nb_contracted_neighbours;
+    // buffers of the witness searches, the durations being reset on the reached vertices
+    std::vector<uint64_t> durations;
+    std::vector<uint32_t> reached;
+    std::vector<Label> heap;
+
+    explicit Contraction(size_t nb_vertices)
+        : out_arcs(nb_vertices),
+          in_arcs(nb_vertices),
+          nb_contracted_neighbours(nb_vertices, 0),
+          durations(nb_vertices, infinite_duration) {}
+
+    // between two vertices only the shortest arc is kept
+    static void add_or_shorten(std::vector<Arc>& arcs, const Arc& arc) {
+        for (auto& a : arcs) {
+            if (a.vertex == arc.vertex) {
+                if (arc.duration < a.duration) {
+                    a = arc;
+                }
+                return;
+            }
+        }
+        arcs.push_back(arc);
+    }
+
+    void add_arc(uint32_t u, uint32_t v, uint64_t duration, uint32_t middle) {
+        if (duration > std::numeric_limits<uint32_t>::max()) {
+            throw navitia::exception("duration overflow in the contraction hierarchy");
+        }
+        add_or_shorten(out_arcs[u], Arc{v, middle, uint32_t(duration)});
+        add_or_shorten(in_arcs[v], Arc{u, middle, uint32_t(duration)});
+    }
+
+    // the durations from u not going through v, up to max_duration
+    void witness_search(uint32_t u, uint32_t v, uint64_t max_duration) {
+        for (const auto w : reached) {
+            durations[w] = infinite_duration;
+        }
+        reached.clear();
+        heap.clear();
+        durations[u] = 0;
+        reached.push_back(u);
+        heap.push_back({0, u});
+        size_t nb_settled = 0;
+        while (!heap.empty() && nb_settled < max_witness_settled) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Label>());
+            const auto label = heap.back();
+            heap.pop_back();
+            if (label.first > max_duration) {
+                break;
+            }
+            if (label.first > durations[label.second]) {
+                continue;
+            }
+            ++nb_settled;
+            for (const auto& arc : out_arcs[label.second]) {
+                const auto duration = label.first + arc.duration;
+                if (arc.vertex == v || duration >= durations[arc.vertex]) {
+                    continue;
+                }
+                if (durations[arc.vertex] == infinite_duration) {
+                    reached.push_back(arc.vertex);
+                }
+                durations[arc.vertex] = duration;
+                heap.push_back({duration, arc.vertex});
+                std::push_heap(heap.begin(), heap.end(), std::greater<Label>());
+            }
+        }
+    }
+
+    struct Shortcut {
+        uint32_t source;
+        uint32_t target;
+        uint64_t duration;
+    };
+
+    // the shortcuts keeping the shortest paths through v once contracted
+    std::vector<Shortcut> shortcuts(uint32_t v) {
+        std::vector<Shortcut> result;
+        uint64_t max_out_duration = 0;
+        for (const auto& out : out_arcs[v]) {
+            max_out_duration = std::max<uint64_t>(max_out_duration, out.duration);
+        }
+        for (const auto& in : in_arcs[v]) {
+            witness_search(in.vertex, v, in.duration + max_out_duration);
+            for (const auto& out : out_arcs[v]) {
+                const uint64_t duration = uint64_t(in.duration) + out.duration;
+                if (out.vertex != in.vertex && durations[out.vertex] > duration) {
+                    result.push_back({in.vertex, out.vertex, duration});
+                }
+            }
+        }
+        return result;
+    }
+
+    // the vertices adding few shortcuts and with few contracted neighbours are contracted first
+    int priority(uint32_t v, size_t nb_shortcuts) const {
+        const int edge_difference = int(nb_shortcuts) - int(out_arcs[v].size() + in_arcs[v].size());
+        return edge_difference + int(nb_contracted_neighbours[v]);
+    }
+
+    void contract(uint32_t v, const std::vector<Shortcut>& v_shortcuts) {
+        auto remove_arcs_to_v = [v](std::vector<Arc>& arcs) {
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [v](const Arc& a) { return a.vertex == v; }),
+                       arcs.end());
+        };
+        for (const auto& in : in_arcs[v]) {
+            remove_arcs_to_v(out_arcs[in.vertex]);
+            ++nb_contracted_neighbours[in.vertex];
+        }
+        for (const auto& out : out_arcs[v]) {
+            remove_arcs_to_v(in_arcs[out.vertex]);
+            ++nb_contracted_neighbours[out.vertex];
+        }
+        for (const auto& shortcut : v_shortcuts) {
+            add_arc(shortcut.source, shortcut.target, shortcut.duration, v);
+        }
+    }
+};
+
+void append_arcs(std::vector<uint32_t>& offsets, std::vector<Arc>& arcs, std::vector<Arc>&& vertex_arcs) {
+    offsets.push_back(arcs.size());
+    arcs.insert(arcs.end(), vertex_arcs.begin(), vertex_arcs.end());
+    vertex_arcs = std::vector<Arc>();
+}
+
+const Arc* find_arc(const type::FlatArray<uint32_t>& offsets,
+                    const type::FlatArray<Arc>& arcs,
+                    uint32_t from,
+                    uint32_t to) {
+    for (auto i = offsets[from]; i < offsets[from + 1]; ++i) {
+        if (arcs[i].vertex == to) {
+            return &arcs[i];
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+const uint32_t ContractionHierarchy::no_vertex;
+
+ContractionHierarchy::ContractionHierarchy(const Graph& graph,
+                                           size_t nb_vertices_by_layer,
+                                           const flat_enum_map<type::Mode_e, bool>& allowed_modes) {
+    const size_t nb_vertices = boost::num_vertices(graph);
+    if (nb_vertices >= no_vertex || nb_vertices_by_layer == 0) {
+        throw navitia::exception("unable to build a contraction hierarchy on " + std::to_string(nb_vertices)
+                                 + " vertices");
+    }
+    // as in TransportationModeFilter, the layer l holds the vertices of the mode l
+    auto is_allowed = [&](vertex_t v) { return allowed_modes[type::Mode_e(v / nb_vertices_by_layer)]; };
+
+    Contraction contraction(nb_vertices);
+    for (vertex_t u = 0; u < nb_vertices; ++u) {
+        if (!is_allowed(u)) {
+            continue;
+        }
+        for (const auto& e : boost::make_iterator_range(boost::out_edges(u, graph))) {
+            const auto v = boost::target(e, graph);
+            if (v != u && is_allowed(v)) {
+                contraction.add_arc(u, v, edge_ticks(graph[e].duration, 1.f), no_vertex);
+            }
+        }
+    }
+
+    using Priority = std::pair<int, uint32_t>;
+    std::priority_queue<Priority, std::vector<Priority>, std::greater<Priority>> order;
+    for (vertex_t v = 0; v < nb_vertices; ++v) {
+        if (is_allowed(v)) {
+            order.push({contraction.priority(v, contraction.shortcuts(v).size()), v});
+        }
+    }
+    std::vector<std::vector<Arc>> up(nb_vertices);
+    std::vector<std::vector<Arc>> down(nb_vertices);
+    while (!order.empty()) {
+        const auto v = order.top().second;
+        order.pop();
+        // the priority may have grown with the contraction of the neighbours
+        const auto v_shortcuts = contraction.shortcuts(v);
+        const int priority = contraction.priority(v, v_shortcuts.size());
+        if (!order.empty() && priority > order.top().first) {
+            order.push({priority, v});
+            continue;
+        }
+        contraction.contract(v, v_shortcuts);
+        // the remaining neighbours are contracted after v
+        up[v] = std::move(contraction.out_arcs[v]);
+        down[v] = std::move(contraction.in_arcs[v]);
+        contraction.out_arcs[v] = {};
+        contraction.in_arcs[v] = {};
+    }
+
+    owned_up_offsets.reserve(nb_vertices + 1);
+    owned_down_offsets.reserve(nb_vertices + 1);
+    for (vertex_t v = 0; v < nb_vertices; ++v) {
+        append_arcs(owned_up_offsets, owned_up_arcs, std::move(up[v]));
+        append_arcs(owned_down_offsets, owned_down_arcs, std::move(down[v]));
+    }
+    if (owned_up_arcs.size() >= no_vertex || owned_down_arcs.size() >= no_vertex) {
+        throw navitia::exception("too many arcs in the contraction hierarchy");
+    }
+    owned_up_offsets.push_back(owned_up_arcs.size());
+    owned_down_offsets.push_back(owned_down_arcs.size());
+    up_offsets = type::FlatArray<uint32_t>(owned_up_offsets);
+    up_arcs = type::FlatArray<Arc>(owned_up_arcs);
+    down_offsets = type::FlatArray<uint32_t>(owned_down_offsets);
+    down_arcs = type::FlatArray<Arc>(owned_down_arcs);
+}
+
+std::shared_ptr<const ContractionHierarchy> ContractionHierarchy::from_flat(
+    const std::shared_ptr<const type::FlatNav>& flat_nav,
+    const std::string& name,
+    size_t nb_vertices) {
+    log4cplus::Logger logger = log4cplus::Logger::getInstance("log");
+    const auto up_offsets = flat_nav->get<uint32_t>(name + ".up_offsets");
+    const auto up_arcs = flat_nav->get<Arc>(name + ".up_arcs");
+    const auto down_offsets = flat_nav->get<uint32_t>(name + ".down_offsets");
+    const auto down_arcs = flat_nav->get<Arc>(name + ".down_arcs");
+    if (!up_offsets || !up_arcs || !down_offsets || !down_arcs || up_offsets->size() != nb_vertices + 1
+        || down_offsets->size() != nb_vertices + 1 || (*up_offsets)[nb_vertices] != up_arcs->size()
+        || (*down_offsets)[nb_vertices] != down_arcs->size()) {
+        LOG4CPLUS_WARN(logger, "Contraction hierarchy " << name << " not found in the flat nav");
+        return nullptr;
+    }
+    std::shared_ptr<ContractionHierarchy> hierarchy(new ContractionHierarchy());
+    hierarchy->up_offsets = *up_offsets;
+    hierarchy->up_arcs = *up_arcs;
+    hierarchy->down_offsets = *down_offsets;
+    hierarchy->down_arcs = *down_arcs;
+    hierarchy->flat_nav = flat_nav;
+    LOG4CPLUS_INFO(logger, "Contraction hierarchy " << name << " mapped with " << hierarchy->nb_arcs() << " arcs");
+    return hierarchy;
+}
+
+void ContractionHierarchy::save_flat(type::FlatNavWriter& writer, const std::string& name) const {
+    writer.add(name + ".up_offsets", up_offsets);
+    writer.add(name + ".up_arcs", up_arcs);
+    writer.add(name + ".down_offsets", down_offsets);
+    writer.add(name + ".down_arcs", down_arcs);
+}
+
+const ContractionHierarchy::Arc* ContractionHierarchy::find_up_arc(uint32_t u, uint32_t v) const {
+    return find_arc(up_offsets, up_arcs, u, v);
+}
+
+const ContractionHierarchy::Arc* ContractionHierarchy::find_down_arc(uint32_t v, uint32_t u) const {
+    return find_arc(down_offsets, down_arcs, v, u);
+}
+
+uint32_t ContractionHierarchy::edge_ticks(const navitia::time_duration& duration, float speed_factor) {
+    if (duration.is_pos_infinity()) {
+        return std::numeric_limits<uint32_t>::max();
+    }
+    const double ticks = duration.ticks() * double(speed_factor);
+    return uint32_t(std::min<double>(std::max(ticks, 0.), std::numeric_limits<uint32_t>::max()));
+}
+
+void ContractionHierarchyQuery::Search::reset(size_t nb_vertices) {
+    if (durations.size() != nb_vertices) {
+        durations.assign(nb_vertices, infinite_duration);
+        parents.assign(nb_vertices, ContractionHierarchy::no_vertex);
+        parent_arcs.assign(nb_vertices, ContractionHierarchy::no_vertex);
+    } else {
+        for (const auto v : reached) {
+            durations[v] = infinite_duration;
+        }
+    }
+    reached.clear();
+    queue = Queue();
+}
+
+void ContractionHierarchyQuery::Search::reach(uint32_t v, uint64_t duration, uint32_t parent, uint32_t parent_arc) {
+    if (durations[v] == infinite_duration) {
+        reached.push_back(v);
+    }
+    durations[v] = duration;
+    parents[v] = parent;
+    parent_arcs[v] = parent_arc;
+    queue.push({duration, v});
+}
+
+std::vector<uint32_t> ContractionHierarchyQuery::shortest_path(const ContractionHierarchy& hierarchy,
+                                                               const std::vector<Endpoint>& sources,
+                                                               const std::vector<Endpoint>& targets,
+                                                               uint32_t max_duration) {
+    const auto nb_vertices = hierarchy.nb_vertices();
+    nb_settled = 0;
+    forward.reset(nb_vertices);
+    backward.reset(nb_vertices);
+    auto start = [&](Search& search, const std::vector<Endpoint>& endpoints) {
+        for (const auto& endpoint : endpoints) {
+            if (endpoint.first < nb_vertices && endpoint.second <= max_duration
+                && endpoint.second < search.durations[endpoint.first]) {
+                search.reach(endpoint.first, endpoint.second, endpoint.first, ContractionHierarchy::no_vertex);
+            }
+        }
+    };
+    start(forward, sources);
+    start(backward, targets);
+
+    uint64_t best = infinite_duration;
+    uint32_t meeting = ContractionHierarchy::no_vertex;
+    auto settle = [&](Search& search, const Search& other, const type::FlatArray<uint32_t>& offsets,
+                      const type::FlatArray<ContractionHierarchy::Arc>& arcs) {
+        const auto label = search.queue.top();
+        search.queue.pop();
+        const auto v = label.second;
+        if (label.first > search.durations[v]) {
+            return;
+        }
+        ++nb_settled;
+        if (other.durations[v] != infinite_duration && label.first + other.durations[v] < best) {
+            best = label.first + other.durations[v];
+            meeting = v;
+        }
+        for (auto i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const auto& arc = arcs[i];
+            const auto duration = label.first + arc.duration;
+            if (duration <= max_duration && duration < search.durations[arc.vertex]) {
+                search.reach(arc.vertex, duration, v, i);
+            }
+        }
+    };
+    while (true) {
+        // a search stops once it cannot find a shorter path
+        const bool forward_done = forward.queue.empty() || forward.queue.top().first >= best;
+        const bool backward_done = backward.queue.empty() || backward.queue.top().first >= best;
+        if (forward_done && backward_done) {
+            break;
+        }
+        if (backward_done || (!forward_done && forward.queue.top().first <= backward.queue.top().first)) {
+            settle(forward, backward, hierarchy.up_offsets, hierarchy.up_arcs);
+        } else {
+            settle(backward, forward, hierarchy.down_offsets, hierarchy.down_arcs);
+        }
+    }
+    if (meeting == ContractionHierarchy::no_vertex || best > max_duration) {
+        return {};
+    }
+
+    // the arcs up from the source to the meeting vertex, then down to the target
+    struct Hop {
+        uint32_t from;
+        uint32_t to;
+        uint32_t middle;
+    };
+    std::vector<Hop> hops;
+    uint32_t v = meeting;
+    for (; forward.parents[v] != v; v = forward.parents[v]) {
+        hops.push_back({forward.parents[v], v, hierarchy.up_arcs[forward.parent_arcs[v]].middle});
+    }
+    std::reverse(hops.begin(), hops.end());
+    std::vector<uint32_t> path{v};
+    for (v = meeting; backward.parents[v] != v; v = backward.parents[v]) {
+        hops.push_back({v, backward.parents[v], hierarchy.down_arcs[backward.parent_arcs[v]].middle});
+    }
+
+    // a shortcut is replaced by the arcs of the vertex it bypasses, contracted before its ends
+    std::vector<Hop> to_unpack;
+    for (const auto& hop : hops) {
+        to_unpack.push_back(hop);
+        while (!to_unpack.empty()) {
+            const auto current = to_unpack.back();
+            to_unpack.pop_back();
+            if (current.middle == ContractionHierarchy::no_vertex) {
+                path.push_back(current.to);
+                continue;
+            }
+            const auto* first = hierarchy.find_down_arc(current.middle, current.from);
+            const auto* second = hierarchy.find_up_arc(current.middle, current.to);
+            if (!first || !second) {
+                throw navitia::exception("inconsistent contraction hierarchy");
+            }
+            to_unpack.push_back({current.middle, current.to, second->middle});
+            to_unpack.push_back({current.from, current.middle, first->middle});
+        }
+    }
+    return path;
+}
+
+const std::vector<ContractionHierarchyUpwardSearch::Endpoint>& ContractionHierarchyUpwardSearch::search(
+    const ContractionHierarchy& hierarchy,
+    Direction direction,
+    const std::vector<Endpoint>& endpoints,
+    uint32_t max_duration) {
+    const auto nb_vertices = hierarchy.nb_vertices();
+    if (durations.size() != nb_vertices) {
+        durations.assign(nb_vertices, infinite_duration);
+    } else {
+        for (const auto v : reached) {
+            durations[v] = infinite_duration;
+        }
+    }
+    reached.clear();
+    settled.clear();
+    queue = Queue();
+
+    auto reach = [&](uint32_t v, uint64_t duration) {
+        if (duration > max_duration || duration >= durations[v]) {
+            return;
+        }
+        if (durations[v] == infinite_duration) {
+            reached.push_back(v);
+        }
+        durations[v] = duration;
+        queue.push({duration, v});
+    };
+    for (const auto& endpoint : endpoints) {
+        if (endpoint.first < nb_vertices) {
+            reach(endpoint.first, endpoint.second);
+        }
+    }
+
+    const bool forward = direction == Direction::Forward;
+    // the arcs followed going up, and the ones a vertex can be reached sooner by from above
+    const auto& offsets = forward ? hierarchy.up_offsets : hierarchy.down_offsets;
+    const auto& arcs = forward ? hierarchy.up_arcs : hierarchy.down_arcs;
+    const auto& stall_offsets = forward ? hierarchy.down_offsets : hierarchy.up_offsets;
+    const auto& stall_arcs = forward ? hierarchy.down_arcs : hierarchy.up_arcs;
+    while (!queue.empty()) {
+        const auto label = queue.top();
+        queue.pop();
+        const auto v = label.second;
+        if (label.first > durations[v]) {
+            continue;
+        }
+        bool stalled = false;
+        for (auto i = stall_offsets[v]; i < stall_offsets[v + 1] && !stalled; ++i) {
+            const auto& arc = stall_arcs[i];
+            stalled = durations[arc.vertex] != infinite_duration
+                      && durations[arc.vertex] + arc.duration < label.first;
+        }
+        if (stalled) {
+            continue;
+        }
+        settled.push_back({v, uint32_t(label.first)});
+        for (auto i = offsets[v]; i < offsets[v + 1]; ++i) {
+            reach(arcs[i].vertex, label.first + arcs[i].duration);
+        }
+    }
+    return settled;
+}
+
+ContractionHierarchyBuckets::ContractionHierarchyBuckets(const std::vector<std::vector<Endpoint>>& settled_by_target) {
+    size_t nb_entries = 0;
+    for (const auto& settled : settled_by_target) {
+        nb_entries += settled.size();
+    }
+    entries.reserve(nb_entries);
+    for (uint32_t target = 0; target < settled_by_target.size(); ++target) {
+        for (const auto& endpoint : settled_by_target[target]) {
+            entries.push_back({endpoint.first, target, endpoint.second});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return std::tie(a.vertex, a.target) < std::tie(b.vertex, b.target);
+    });
+}
+
+void ContractionHierarchyBuckets::scan(const std::vector<Endpoint>& settled, std::vector<uint64_t>& durations) const {
+    for (const auto& endpoint : settled) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), endpoint.first,
+                                   [](const Entry& entry, uint32_t vertex) { return entry.vertex < vertex; });
+        for (; it != entries.end() && it->vertex == endpoint.first; ++it) {
+            const uint64_t duration = uint64_t(endpoint.second) + it->duration;
+            if (duration < durations[it->target]) {
+                durations[it->target] = duration;
+            }
+        }
+    }
+}
+
+}  // namespace georef
+}  // namespace navitia
@@ -0,0 +1,245 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "georef/georef_types.h"
+#include "type/flat_nav.h"
+#include "type/time_duration.h"
+#include "type/type_interfaces.h"
+#include "utils/flat_enum_map.h"
+
+#include <boost/utility.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace navitia {
+namespace georef {
+
+/**
+ * Contraction hierarchy of the street network of a mode, to find its
+ * shortest paths much faster than the A* on long distances.
+ *
+ * The vertices of the Graph in the layers of the mode are contracted one by
+ * one, the least important first: the shortest paths through a contracted
+ * vertex are kept by shortcuts between its neighbours.  Each vertex keeps
+ * its arcs to the vertices contracted after it (upward arcs) and the arcs
+ * from them (downward arcs).  A bidirectional search only going up the
+ * hierarchy then finds a shortest path settling a few hundreds of vertices,
+ * instead of the millions settled by the A* for a long car trip.
+ *
+ * The durations are the ones of the edges in ticks of time_duration, a
+ * speed factor scaling all of them.
+ *
+ * It is built by ed2nav and saved in the flat nav (see
+ * GeoRef::build_contraction_hierarchies), kraken using it in place.
+ */
+class ContractionHierarchy : boost::noncopyable {
+public:
+    static const uint32_t no_vertex = std::numeric_limits<uint32_t>::max();
+
+    struct Arc {
+        // the other end of the arc, contracted after this vertex
+        uint32_t vertex;
+        // the vertex bypassed by a shortcut, no_vertex for an edge of the Graph
+        uint32_t middle;
+        // in ticks of navitia::time_duration
+        uint32_t duration;
+    };
+
+    // the arcs of the vertex v are from offsets[v] to offsets[v + 1]
+    type::FlatArray<uint32_t> up_offsets;
+    type::FlatArray<Arc> up_arcs;
+    type::FlatArray<uint32_t> down_offsets;
+    type::FlatArray<Arc> down_arcs;
+
+    /*
+     * Contract the Graph restricted to the layers of the allowed modes, a
+     * layer holding nb_vertices_by_layer vertices (see GeoRef::init)
+     */
+    ContractionHierarchy(const Graph& graph,
+                         size_t nb_vertices_by_layer,
+                         const flat_enum_map<type::Mode_e, bool>& allowed_modes);
+
+    /*
+     * The hierarchy saved under name in the flat nav, used in place.
+     *
+     * Returns null if it is missing or has not nb_vertices vertices.
+     */
+    static std::shared_ptr<const ContractionHierarchy> from_flat(const std::shared_ptr<const type::FlatNav>& flat_nav,
+                                                                 const std::string& name,
+                                                                 size_t nb_vertices);
+
+    // add the hierarchy under name to the flat nav
+    void save_flat(type::FlatNavWriter& writer, const std::string& name) const;
+
+    size_t nb_vertices() const { return up_offsets.empty() ? 0 : up_offsets.size() - 1; }
+    size_t nb_arcs() const { return up_arcs.size() + down_arcs.size(); }
+
+    // the upward arc from u to v, null if none
+    const Arc* find_up_arc(uint32_t u, uint32_t v) const;
+    // the downward arc to v from u, null if none
+    const Arc* find_down_arc(uint32_t v, uint32_t u) const;
+
+    // a duration at the speed factor in ticks of the durations of the hierarchy, saturated
+    static uint32_t edge_ticks(const navitia::time_duration& duration, float speed_factor);
+
+private:
+    std::vector<uint32_t> owned_up_offsets;
+    std::vector<Arc> owned_up_arcs;
+    std::vector<uint32_t> owned_down_offsets;
+    std::vector<Arc> owned_down_arcs;
+    std::shared_ptr<const type::FlatNav> flat_nav;
+
+    ContractionHierarchy() = default;
+};
+
+/*
+ * Bidirectional search of a shortest path in a contraction hierarchy.
+ *
+ * Its buffers are kept from a search to the next, only the vertices reached
+ * by a search being reset, so a path finder keeps its own.
+ */
+class ContractionHierarchyQuery {
+public:
+    // a vertex of the Graph with the duration to reach it, or from it, in ticks
+    using Endpoint = std::pair<uint32_t, uint32_t>;
+
+    // number of vertices settled by the last search
+    size_t nb_settled = 0;
+
+    /*
+     * The vertices of the Graph of a shortest path from a source to a
+     * target not longer than max_duration, empty if there is none
+     */
+    std::vector<uint32_t> shortest_path(const ContractionHierarchy& hierarchy,
+                                        const std::vector<Endpoint>& sources,
+                                        const std::vector<Endpoint>& targets,
+                                        uint32_t max_duration);
+
+private:
+    using Label = std::pair<uint64_t, uint32_t>;
+    using Queue = std::priority_queue<Label, std::vector<Label>, std::greater<Label>>;
+
+    struct Search {
+        std::vector<uint64_t> durations;
+        // the vertex the search reached a vertex from, itself for an endpoint
+        std::vector<uint32_t> parents;
+        // the arc it has been reached by
+        std::vector<uint32_t> parent_arcs;
+        std::vector<uint32_t> reached;
+        Queue queue;
+
+        void reset(size_t nb_vertices);
+        void reach(uint32_t v, uint64_t duration, uint32_t parent, uint32_t parent_arc);
+    };
+    Search forward;
+    Search backward;
+};
+
+/*
+ * Search going up a contraction hierarchy from some vertices, settling all
+ * the vertices it reaches within a duration.
+ *
+ * The upward search spaces of a source and a target meet on the top vertex
+ * of their shortest path, which is what the many-to-many searches use (see
+ * ContractionHierarchyBuckets).  A vertex reached sooner from a vertex above
+ * it is stalled: its duration is not the shortest, so it is neither
+ * expanded nor returned.
+ *
+ * As the query, its buffers are kept from a search to the next.
+ */
+class ContractionHierarchyUpwardSearch {
+public:
+    using Endpoint = ContractionHierarchyQuery::Endpoint;
+    enum class Direction { Forward, Backward };
+
+    /*
+     * The vertices settled going up from the endpoints, with their duration
+     * from the endpoints (Forward) or to them (Backward), not longer than
+     * max_duration
+     */
+    const std::vector<Endpoint>& search(const ContractionHierarchy& hierarchy,
+                                        Direction direction,
+                                        const std::vector<Endpoint>& endpoints,
+                                        uint32_t max_duration);
+
+private:
+    using Label = std::pair<uint64_t, uint32_t>;
+    using Queue = std::priority_queue<Label, std::vector<Label>, std::greater<Label>>;
+
+    std::vector<uint64_t> durations;
+    std::vector<uint32_t> reached;
+    std::vector<Endpoint> settled;
+    Queue queue;
+};
+
+/*
+ * Durations from many sources to many targets in a contraction hierarchy.
+ *
+ * The vertices settled by the backward search of each target are sorted in
+ * buckets, one per vertex.  The durations from a source to all the targets
+ * are then given by a forward search from the source scanning the buckets
+ * of the vertices it settles, instead of a query per target.
+ */
+class ContractionHierarchyBuckets {
+public:
+    using Endpoint = ContractionHierarchyQuery::Endpoint;
+
+    // the vertices settled by the backward search of each target, by index of target
+    explicit ContractionHierarchyBuckets(const std::vector<std::vector<Endpoint>>& settled_by_target);
+
+    /*
+     * Lower the durations to each target, by index of target, with the paths
+     * through the vertices settled by the forward search of a source
+     */
+    void scan(const std::vector<Endpoint>& settled, std::vector<uint64_t>& durations) const;
+
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        uint32_t vertex;
+        uint32_t target;
+        uint32_t duration;
+    };
+    // sorted by vertex
+    std::vector<Entry> entries;
+};
+
+}  // namespace georef
+}  // namespace navitia
@@ -31,10 +31,13 @@ www.navitia.io
 #include "dijkstra_path_finder.h"
 
 #include "georef/georef.h"
+#include "georef/street_graph.h"
 #include "utils/logger.h"
 
 #include <boost/graph/dijkstra_shortest_paths.hpp>
 
+#include <algorithm>
+
 namespace navitia {
 namespace georef {
 
@@ -83,29 +86,31 @@ boost::container::flat_map<K, georef::RoutingElement> DijkstraPathFinder::start_
     start_distance_dijkstra(radius);
 
     for (const auto& dest : projection_found_dests) {
-        // if our two points are projected on the same edge the
-        // Dijkstra won't give us the correct value we need to handle
-        // this case separately
-        auto& projection = dest.second;
-        auto& id = dest.first;
-        navitia::time_duration duration;
-        if (is_projected_on_same_edge(starting_edge, projection)) {
-            // We calculate the duration for going to the edge, then to
-            // the projected destination on the edge and finally to the
-            // destination
-            duration = path_duration_on_same_edge(starting_edge, projection);
-        } else {
-            duration = find_nearest_vertex(projection, true).first;
-        }
-        if (duration <= radius) {
-            result[id] = georef::RoutingElement(duration, georef::RoutingStatus_e::reached);
-        } else {
-            result[id] = georef::RoutingElement(navitia::time_duration(), georef::RoutingStatus_e::unreached);
-        }
+        result[dest.first] = get_routing_element(radius, dest.second);
     }
     return result;
 }
 
+georef::RoutingElement DijkstraPathFinder::get_routing_element(const navitia::time_duration& radius,
+                                                               const ProjectionData& projection) const {
+    // if our two points are projected on the same edge the
+    // Dijkstra won't give us the correct value we need to handle
+    // this case separately
+    navitia::time_duration duration;
+    if (is_projected_on_same_edge(starting_edge, projection)) {
+        // We calculate the duration for going to the edge, then to
+        // the projected destination on the edge and finally to the
+        // destination
+        duration = path_duration_on_same_edge(starting_edge, projection);
+    } else {
+        duration = find_nearest_vertex(projection, true).first;
+    }
+    if (duration <= radius) {
+        return georef::RoutingElement(duration, georef::RoutingStatus_e::reached);
+    }
+    return georef::RoutingElement(navitia::time_duration(), georef::RoutingStatus_e::unreached);
+}
+
 std::vector<std::pair<type::idx_t, type::GeographicalCoord>> DijkstraPathFinder::crow_fly_find_nearest_stop_points(
     const navitia::time_duration& max_duration,
     const proximitylist::ProximityList<type::idx_t>& pl) {
@@ -182,12 +187,7 @@ struct ProjectionGetterOnCoords {
     const type::Mode_e mode = type::Mode_e::Walking;
     ProjectionGetterOnCoords(const GeoRef& georef, const type::Mode_e mode) : georef(georef), mode(mode) {}
     const georef::ProjectionData operator()(const type::GeographicalCoord& coord) const {
-        try {
-            const auto& projection = georef.projected_coords.at(coord);
-            return projection[mode];
-        } catch (std::out_of_range&) {
-            return georef::ProjectionData{coord, georef, mode};
-        }
+        return georef.project(coord, mode);
     }
 };
 
@@ -203,6 +203,25 @@ DijkstraPathFinder::get_duration_with_dijkstra(const navitia::time_duration& rad
                                                 ProjectionGetterOnCoords>(radius, dest_coords, projection_getter);
 }
 
+std::vector<georef::RoutingElement> DijkstraPathFinder::get_duration_with_dijkstra(
+    const navitia::time_duration& radius,
+    const std::vector<ProjectionData>& destinations) {
+    std::vector<georef::RoutingElement> result(
+        destinations.size(), georef::RoutingElement(navitia::time_duration(), georef::RoutingStatus_e::unknown));
+    if (std::none_of(destinations.begin(), destinations.end(), [](const ProjectionData& p) { return p.found; })) {
+        return result;
+    }
+
+    start_distance_dijkstra(radius);
+
+    for (size_t i = 0; i < destinations.size(); ++i) {
+        if (destinations[i].found) {
+            result[i] = get_routing_element(radius, destinations[i]);
+        }
+    }
+    return result;
+}
+
 template <class Visitor>
 void DijkstraPathFinder::dijkstra(const std::array<georef::vertex_t, 2>& origin_vertexes, const Visitor& visitor) {
     // Note: the predecessors have been updated in init
@@ -213,14 +232,23 @@ void DijkstraPathFinder::dijkstra(const std::array<georef::vertex_t, 2>& origin_
                         / boost::two_bit_color_map<>::elements_per_char,
               0);
 
-    // we filter the graph to only use certain mean of transport
-    using filtered_graph = boost::filtered_graph<georef::Graph, boost::keep_all, TransportationModeFilter>;
-    auto const g = filtered_graph(geo_ref.graph, {}, TransportationModeFilter(mode, geo_ref));
-    auto const weight_map = boost::get(&Edge::duration, geo_ref.graph);
+    auto const filter = TransportationModeFilter(mode, geo_ref);
     auto const combiner = SpeedDistanceCombiner(speed_factor);  // we multiply the edge duration by a speed factor
 
-    dijkstra_shortest_paths_no_init_with_heap(g, origin_vertexes.front(), origin_vertexes.back(), visitor, weight_map,
-                                              combiner);
+    // we filter the graph to only use certain mean of transport
+    // the compact street graph is searched unless the graph has been modified since its build
+    if (geo_ref.street_graph && geo_ref.street_graph->is_built_from(geo_ref.graph)) {
+        const StreetGraph::View g(*geo_ref.street_graph, filter.acceptable_modes);
+        auto const weight_map = g.duration_map();
+        dijkstra_shortest_paths_no_init_with_heap(g, origin_vertexes.front(), origin_vertexes.back(), visitor,
+                                                  weight_map, combiner);
+    } else {
+        using filtered_graph = boost::filtered_graph<georef::Graph, boost::keep_all, TransportationModeFilter>;
+        auto const g = filtered_graph(geo_ref.graph, {}, filter);
+        auto const weight_map = boost::get(&Edge::duration, geo_ref.graph);
+        dijkstra_shortest_paths_no_init_with_heap(g, origin_vertexes.front(), origin_vertexes.back(), visitor,
+                                                  weight_map, combiner);
+    }
 }
 
 std::pair<navitia::time_duration, ProjectionData::Direction> DijkstraPathFinder::update_path(
@@ -280,15 +308,25 @@ void DijkstraPathFinder::dijkstra_shortest_paths_no_init_with_heap(const Graph&
                                                                    const WeightMap& weight,
                                                                    const SpeedDistanceCombiner& combine,
                                                                    const Compare& compare) {
+    auto visit = [&](auto& Q) {
+        using Queue = typename std::remove_reference<decltype(Q)>::type;
+        boost::detail::dijkstra_bfs_visitor<DijkstraVisitor, Queue, WeightMap, predecessor_map, duration_map,
+                                            SpeedDistanceCombiner, Compare>
+            bfs_vis(visitor, Q, weight, predecessor_map(&predecessors[0]), duration_map(&distances[0]), combine,
+                    compare, navitia::seconds(0));
+
+        breadth_first_visit(g, &s_begin, &s_end, Q, bfs_vis, color);
+    };
+
+    // the radix heap always orders by increasing durations, as the default compare
+    if (priority_queue == PriorityQueue_e::radix_heap) {
+        radix_heap.reset(&distances[0]);
+        visit(radix_heap);
+        return;
+    }
     using MutableQueue = boost::d_ary_heap_indirect<vertex_t, 4, vertex_t*, navitia::time_duration*, Compare>;
-
     MutableQueue Q(&distances[0], &index_in_heap_map[0], compare);
-
-    boost::detail::dijkstra_bfs_visitor<DijkstraVisitor, MutableQueue, WeightMap, vertex_t*, navitia::time_duration*,
-                                        SpeedDistanceCombiner, Compare>
-        bfs_vis(visitor, Q, weight, &predecessors[0], &distances[0], combine, compare, navitia::seconds(0));
-
-    breadth_first_visit(g, &s_begin, &s_end, Q, bfs_vis, color);
+    visit(Q);
 }
 
 }  // namespace georef
@@ -59,6 +59,13 @@ public:
         const navitia::time_duration& radius,
         const std::vector<type::GeographicalCoord>& dest_coords);
 
+    /**
+     * Same with destinations already projected in the layer of the mode, the
+     * durations being in the order of the destinations
+     **/
+    std::vector<georef::RoutingElement> get_duration_with_dijkstra(const navitia::time_duration& radius,
+                                                                   const std::vector<ProjectionData>& destinations);
+
     /**
      * Launch a dijkstra without initializing the data structure
      * Warning, it modifies the distances and the predecessors
@@ -76,6 +83,10 @@ public:
     navitia::time_duration get_distance(type::idx_t target_idx);
 
 private:
+    // the duration to a destination once the dijkstra has been launched
+    georef::RoutingElement get_routing_element(const navitia::time_duration& radius,
+                                               const ProjectionData& projection) const;
+
     template <typename K, typename U, typename G>
     boost::container::flat_map<K, georef::RoutingElement> start_dijkstra_and_fill_duration_map(
         const navitia::time_duration& radius,
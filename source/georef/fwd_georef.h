@@ -33,6 +33,7 @@ www.navitia.io
 namespace navitia {
 namespace georef {
 
+class ContractionHierarchy;
 struct GeoRef;
 struct HouseNumber;
 struct POI;
@@ -40,6 +41,7 @@ struct POIType;
 struct Path;
 struct PathItem;
 struct ProjectionData;
+struct StreetGraph;
 struct Vertex;
 struct Way;
 
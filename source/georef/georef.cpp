@@ -29,6 +29,9 @@ www.navitia.io
 */
 
 #include "georef.h"
+#include "georef/contraction_hierarchy.h"
+#include "georef/path_finder.h"
+#include "georef/street_graph.h"
 
 #include "type/stop_area.h"
 #include "type/stop_point.h"
@@ -45,6 +48,8 @@ www.navitia.io
 #include <boost/range/algorithm/sort.hpp>
 
 #include <array>
+#include <future>
+#include <sstream>
 #include <unordered_map>
 
 using navitia::type::idx_t;
@@ -335,6 +340,15 @@ void ProjectionData::init(const type::GeographicalCoord& coord, const GeoRef& sn
     this->real_coord = coord;
 }
 
+// the direct paths of these modes are searched in a contraction hierarchy when built
+static const std::array<nt::Mode_e, 2> contraction_hierarchy_modes{{nt::Mode_e::Car, nt::Mode_e::Bike}};
+
+static std::string contraction_hierarchy_name(nt::Mode_e mode) {
+    std::stringstream ss;
+    ss << "georef.hierarchy." << mode;
+    return ss.str();
+}
+
 static bool is_sn_edge(const GeoRef& georef, const edge_t& e) {
     switch (georef.get_caracteristic(e)) {
         case PathItem::TransportCaracteristic::Walk:
@@ -373,9 +387,11 @@ void GeoRef::init() {
         }
     }
     offsets[nt::Mode_e::CarNoPark] = offsets[nt::Mode_e::Car];
+    street_graph.reset();
+    contraction_hierarchies = {};
 }
 
-void GeoRef::build_proximity_list() {
+void GeoRef::build_proximity_list(const std::shared_ptr<const type::FlatNav>& flat_nav) {
     pl_walking.clear();
     pl_bike.clear();
     pl_car.clear();
@@ -383,31 +399,105 @@ void GeoRef::build_proximity_list() {
 
     auto log = log4cplus::Logger::getInstance("GeoRef::build_proximity_list");
 
-    auto build_sn_pl = [this](proximitylist::ProximityList<vertex_t>& sn_pl, nt::idx_t offset) {
+    auto build_sn_pl = [this, &flat_nav](proximitylist::ProximityList<vertex_t>& sn_pl, nt::idx_t offset,
+                                         const std::string& name) {
+        std::vector<vertex_t> vertices;
         for (vertex_t v = offset; v < nb_vertex_by_mode + offset; ++v) {
             if (boost::algorithm::none_of(boost::out_edges(v, graph),
                                           [=](const auto& e) { return is_sn_edge(*this, e); })) {
                 continue;
             }
+            vertices.push_back(v);
+        }
+        // a flat nav not matching the graph would give vertices out of it
+        if (flat_nav && sn_pl.build_from_flat(flat_nav, name, vertices.size())) {
+            return;
+        }
+        for (const vertex_t v : vertices) {
             sn_pl.add(graph[v].coord, v);
         }
         sn_pl.build();
     };
 
-    LOG4CPLUS_INFO(log, "Building Proximity list for walking graph");
-    build_sn_pl(pl_walking, offsets[nt::Mode_e::Walking]);
+    // the lists are independent, each one is built in its own thread
+    LOG4CPLUS_INFO(log, "Building Proximity list for walking, bike and car graphs");
+    auto walking = std::async(std::launch::async,
+                              [&]() { build_sn_pl(pl_walking, offsets[nt::Mode_e::Walking], "georef.walking"); });
+    auto bike =
+        std::async(std::launch::async, [&]() { build_sn_pl(pl_bike, offsets[nt::Mode_e::Bike], "georef.bike"); });
+    auto car = std::async(std::launch::async, [&]() { build_sn_pl(pl_car, offsets[nt::Mode_e::Car], "georef.car"); });
+
+    LOG4CPLUS_INFO(log, "Building Proximity list for POIs");
+    if (!flat_nav || !poi_proximity_list.build_from_flat(flat_nav, "georef.pois", pois.size())) {
+        for (const POI* poi : pois) {
+            poi_proximity_list.add(poi->coord, poi->idx);
+        }
+        poi_proximity_list.build();
+    }
+    // the path finders search the compact graph, built meanwhile
+    build_street_graph();
+    contraction_hierarchies = {};
+    if (flat_nav) {
+        for (const auto mode : contraction_hierarchy_modes) {
+            contraction_hierarchies[mode] = ContractionHierarchy::from_flat(
+                flat_nav, contraction_hierarchy_name(mode), boost::num_vertices(graph));
+        }
+    }
+    walking.get();
+    bike.get();
+    car.get();
+}
+
+void GeoRef::build_street_graph() {
+    auto log = log4cplus::Logger::getInstance("GeoRef::build_street_graph");
+    street_graph.reset();
+    if (!StreetGraph::can_be_built(graph, nb_vertex_by_mode)) {
+        LOG4CPLUS_WARN(log, "no street graph, the " << boost::num_vertices(graph) << " vertices of the graph are not in "
+                                                    << "layers of " << nb_vertex_by_mode << " vertices");
+        return;
+    }
+    street_graph = std::make_shared<const StreetGraph>(graph, nb_vertex_by_mode);
+    LOG4CPLUS_INFO(log, "street graph built with " << street_graph->nb_vertices << " vertices in "
+                                                   << street_graph->nb_layers << " layers and "
+                                                   << street_graph->nb_edges() << " edges in "
+                                                   << street_graph->memory_size() << " bytes");
+}
 
-    LOG4CPLUS_INFO(log, "Building Proximity list for bike graph");
-    build_sn_pl(pl_bike, offsets[nt::Mode_e::Bike]);
+void GeoRef::build_contraction_hierarchies() {
+    auto log = log4cplus::Logger::getInstance("GeoRef::build_contraction_hierarchies");
+    contraction_hierarchies = {};
+    if (!StreetGraph::can_be_built(graph, nb_vertex_by_mode)) {
+        LOG4CPLUS_WARN(log, "no contraction hierarchy, the " << boost::num_vertices(graph)
+                                                             << " vertices of the graph are not in layers of "
+                                                             << nb_vertex_by_mode << " vertices");
+        return;
+    }
+    for (const auto mode : contraction_hierarchy_modes) {
+        contraction_hierarchies[mode] = std::make_shared<const ContractionHierarchy>(
+            graph, nb_vertex_by_mode, allowed_transportation_mode[mode]);
+        LOG4CPLUS_INFO(log, "contraction hierarchy for " << mode << " built with "
+                                                         << contraction_hierarchies[mode]->nb_arcs() << " arcs");
+    }
+}
 
-    LOG4CPLUS_INFO(log, "Building Proximity list for car graph");
-    build_sn_pl(pl_car, offsets[nt::Mode_e::Car]);
+const ContractionHierarchy* GeoRef::get_contraction_hierarchy(nt::Mode_e mode) const {
+    const auto& hierarchy = contraction_hierarchies[mode];
+    if (!hierarchy || hierarchy->nb_vertices() != boost::num_vertices(graph)) {
+        return nullptr;
+    }
+    return hierarchy.get();
+}
 
-    LOG4CPLUS_INFO(log, "Building Proximity list for POIs");
-    for (const POI* poi : pois) {
-        poi_proximity_list.add(poi->coord, poi->idx);
+void GeoRef::save_flat(type::FlatNavWriter& writer) const {
+    pl_walking.save_flat(writer, "georef.walking");
+    pl_bike.save_flat(writer, "georef.bike");
+    pl_car.save_flat(writer, "georef.car");
+    poi_proximity_list.save_flat(writer, "georef.pois");
+    for (const auto mode : contraction_hierarchy_modes) {
+        if (contraction_hierarchies[mode]) {
+            contraction_hierarchies[mode]->save_flat(writer, contraction_hierarchy_name(mode));
+        }
     }
-    poi_proximity_list.build();
 }
 
 static const Admin* find_city_admin(const std::vector<Admin*>& admins) {
@@ -665,6 +755,14 @@ std::vector<Admin*> GeoRef::find_admins(const type::GeographicalCoord& coord, Ad
     return result;
 }
 
+ProjectionData GeoRef::project(const type::GeographicalCoord& coord, nt::Mode_e mode) const {
+    const auto it = projected_coords.find(coord);
+    if (it != projected_coords.end()) {
+        return it->second[mode];
+    }
+    return ProjectionData{coord, *this, mode};
+}
+
 std::pair<GeoRef::ProjectionByMode, bool> GeoRef::project_stop_point(const type::StopPoint* stop_point) const {
     bool one_proj_found = false;
     ProjectionByMode projections;
@@ -861,6 +959,9 @@ bool GeoRef::add_bss_edges(const type::GeographicalCoord& coord) {
     // time needed to hang the bike back + time to walk between the edges
     edge.duration = dur_between_edges + default_time_bss_putback;
     add_edge(biking_v, walking_v, edge, graph);
+    // the street graph and the contraction hierarchies have to be built again
+    street_graph.reset();
+    contraction_hierarchies = {};
 
     return true;
 }
@@ -896,6 +997,9 @@ bool GeoRef::add_parking_edges(const type::GeographicalCoord& coord) {
     // time needed to park the car + time to walk between the edges
     edge.duration = dur_between_edges + default_time_parking_park;
     add_edge(car_v, walking_v, edge, graph);
+    // the street graph and the contraction hierarchies have to be built again
+    street_graph.reset();
+    contraction_hierarchies = {};
 
     return true;
 }
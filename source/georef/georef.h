@@ -46,6 +46,7 @@ www.navitia.io
 #include <boost/serialization/set.hpp>
 
 #include <map>
+#include <memory>
 #include <set>
 #include <functional>
 
@@ -207,6 +208,13 @@ struct GeoRef {
     /// Graphe pour effectuer le calcul d'itinéraire
     Graph graph;
 
+    /// copy of the graph searched by the path finders to speed them up, built with the proximity lists.
+    /// It adds to the memory of the graph, kept for the paths and projections, about 15% of it
+    std::shared_ptr<const StreetGraph> street_graph;
+
+    /// contraction hierarchies of the car and bike street networks for the direct paths, built by ed2nav
+    flat_enum_map<nt::Mode_e, std::shared_ptr<const ContractionHierarchy>> contraction_hierarchies;
+
     /*
      * We have 3 graphs :
      *  1/ for walking
@@ -238,13 +246,23 @@ struct GeoRef {
         // La désérialisation d'une boost adjacency list ne vide pas le graphe
         // On avait donc une fuite de mémoire
         graph.clear();
+        street_graph.reset();
+        contraction_hierarchies = {};
         ar& ways& way_map& graph& offsets& fl_admin& fl_way& projected_stop_points& admins& admin_map& pois& fl_poi&
             poitypes& poitype_map& poi_map& synonyms& ghostwords& poi_proximity_list& nb_vertex_by_mode;
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
-    /** Construit l'indexe spatial */
-    void build_proximity_list();
+    /** Construit l'indexe spatial, from the lists of the flat nav when given */
+    void build_proximity_list(const std::shared_ptr<const type::FlatNav>& flat_nav = nullptr);
+    /// Build the compact street graph from the graph, to be called once the graph is complete
+    void build_street_graph();
+    /// Build the contraction hierarchies from the graph, to be called once the graph is complete
+    void build_contraction_hierarchies();
+    /// the contraction hierarchy of the direct paths of the mode, null if it has not been built with the graph
+    const ContractionHierarchy* get_contraction_hierarchy(nt::Mode_e mode) const;
+    /// add the proximity lists and the contraction hierarchies to the flat nav
+    void save_flat(type::FlatNavWriter& writer) const;
 
     ///  Construit l'indexe autocomplete à partir des rues
     void build_autocomplete_list();
@@ -279,6 +297,9 @@ struct GeoRef {
      */
     std::pair<ProjectionByMode, bool> project_stop_point(const type::StopPoint* stop_point) const;
 
+    // the projection of the coordinates in the layer of the mode, from projected_coords when it holds them
+    ProjectionData project(const type::GeographicalCoord& coord, nt::Mode_e mode) const;
+
     /** Retourne l'arc (segment) le plus proche
      *
      * Pour le trouver, on cherche le nœud le plus proche, puis pour chaque arc adjacent, on garde le plus proche
@@ -45,7 +45,8 @@ navitia::time_duration PathFinder::crow_fly_duration(const double distance) cons
     return navitia::seconds(distance / double(default_speed[mode_] * speed_factor));
 }
 
-navitia::time_duration PathFinder::path_duration_on_same_edge(const ProjectionData& p1, const ProjectionData& p2) {
+navitia::time_duration PathFinder::path_duration_on_same_edge(const ProjectionData& p1,
+                                                              const ProjectionData& p2) const {
     // Don't compute distance between p1 and p2, instead use distance from one of the vertex, to speed up the process
     // (especially if we use geometries). We make sure to use the distance from the same vertex by checking if p1 and p2
     // are not projected on reversed edges.
@@ -93,13 +94,7 @@ PathFinder::PathFinder(const GeoRef& gref)
     : geo_ref(gref), mode(nt::Mode_e::Walking), color(boost::num_vertices(geo_ref.graph)) {}
 
 void PathFinder::init_start(const type::GeographicalCoord& start_coord, nt::Mode_e mode, const float speed_factor) {
-    computation_launch = false;
-    // we look for the nearest edge from the start coordinate
-    // in the right transport mode (walk, bike, car, ...) (ie offset)
-    this->mode = mode;
-    this->speed_factor = speed_factor;  // the speed factor is the factor we have to multiply the edge cost with
-    this->start_coord = start_coord;
-    starting_edge = ProjectionData(start_coord, this->geo_ref, mode);
+    init_starting_edge(start_coord, mode, speed_factor);
 
     distance_to_entry_point.clear();
     // we initialize the distances to the maximum value
@@ -111,20 +106,18 @@ void PathFinder::init_start(const type::GeographicalCoord& start_coord, nt::Mode
 
     if (starting_edge.found) {
         // durations initializations
-        distances[starting_edge[source_e]] = crow_fly_duration(
-            starting_edge.distances[source_e]);  // for the projection, we use the default walking speed.
-        distances[starting_edge[target_e]] = crow_fly_duration(starting_edge.distances[target_e]);
+        for (const auto& end : get_starting_ends()) {
+            distances[starting_edge[end.first]] = end.second;
+        }
         predecessors[starting_edge[source_e]] = starting_edge[source_e];
         predecessors[starting_edge[target_e]] = starting_edge[target_e];
 
         if (starting_edge[target_e] != starting_edge[source_e]) {  // if we're on a useless edge we do not enhance
-            // small enchancement, if the projection is done on a node, we disable the crow fly
+            // if the projection is done on a node, the other end is reached from it
             if (starting_edge.distances[source_e] < 0.01) {
                 predecessors[starting_edge[target_e]] = starting_edge[source_e];
-                distances[starting_edge[target_e]] = bt::pos_infin;
             } else if (starting_edge.distances[target_e] < 0.01) {
                 predecessors[starting_edge[source_e]] = starting_edge[target_e];
-                distances[starting_edge[source_e]] = bt::pos_infin;
             }
         }
     }
@@ -134,6 +127,58 @@ void PathFinder::init_start(const type::GeographicalCoord& start_coord, nt::Mode
     }
 }
 
+void PathFinder::init_starting_edge(const type::GeographicalCoord& start_coord,
+                                    nt::Mode_e mode,
+                                    const float speed_factor) {
+    init_mode(mode, speed_factor);
+    // we look for the nearest edge from the start coordinate
+    // in the right transport mode (walk, bike, car, ...) (ie offset)
+    this->start_coord = start_coord;
+    starting_edge = ProjectionData(start_coord, this->geo_ref, mode);
+}
+
+void PathFinder::init_mode(nt::Mode_e mode, const float speed_factor) {
+    computation_launch = false;
+    this->mode = mode;
+    this->speed_factor = speed_factor;  // the speed factor is the factor we have to multiply the edge cost with
+    starting_edge = ProjectionData();
+}
+
+std::vector<std::pair<ProjectionData::Direction, navitia::time_duration>> PathFinder::get_starting_ends() const {
+    if (!starting_edge.found) {
+        return {};
+    }
+    // for the projection, we use the default walking speed.
+    const auto to_source = crow_fly_duration(starting_edge.distances[source_e]);
+    const auto to_target = crow_fly_duration(starting_edge.distances[target_e]);
+    if (starting_edge[target_e] != starting_edge[source_e]) {  // if we're on a useless edge we do not enhance
+        // small enchancement, if the projection is done on a node, we disable the crow fly
+        if (starting_edge.distances[source_e] < 0.01) {
+            return {{source_e, to_source}};
+        }
+        if (starting_edge.distances[target_e] < 0.01) {
+            return {{target_e, to_target}};
+        }
+    }
+    return {{source_e, to_source}, {target_e, to_target}};
+}
+
+std::vector<std::pair<ProjectionData::Direction, navitia::time_duration>> PathFinder::get_target_ends(
+    const ProjectionData& target) const {
+    if (!target.found) {
+        return {};
+    }
+    // a target projected on a node is reached on it
+    if (target.distances[source_e] < 0.01) {
+        return {{source_e, navitia::seconds(0)}};
+    }
+    if (target.distances[target_e] < 0.01) {
+        return {{target_e, navitia::seconds(0)}};
+    }
+    return {{source_e, crow_fly_duration(target.distances[source_e])},
+            {target_e, crow_fly_duration(target.distances[target_e])}};
+}
+
 std::pair<navitia::time_duration, ProjectionData::Direction> PathFinder::find_nearest_vertex(
     const ProjectionData& target,
     bool handle_on_node) const {
@@ -31,6 +31,7 @@ www.navitia.io
 #pragma once
 
 #include "georef.h"
+#include "georef/radix_heap.h"
 #include "routing/raptor_utils.h"
 
 #include <boost/graph/two_bit_color_map.hpp>
@@ -46,6 +47,9 @@ const auto target_e = ProjectionData::Direction::Target;
 
 enum class RoutingStatus_e { reached = 0, unreached = 1, unknown = 2 };
 
+// priority queue of the dijkstra and astar searches of the path finders
+enum class PriorityQueue_e { d_ary_heap = 0, radix_heap = 1 };
+
 struct RoutingElement {
     navitia::time_duration time_duration;
     RoutingStatus_e routing_status = RoutingStatus_e::reached;
@@ -138,6 +142,11 @@ public:
     // helper for dijkstra internal heap (to avoid extra alloc)
     std::vector<std::size_t> index_in_heap_map;
 
+    // the radix heap saves most of the heap overhead on the integer durations of the edges
+    PriorityQueue_e priority_queue = PriorityQueue_e::d_ary_heap;
+    // used instead of the d-ary heap when selected (to avoid extra alloc)
+    RadixHeap radix_heap;
+
     // Color map for the dijkstra shortest path (to avoid extra alloc)
     boost::two_bit_color_map<> color;
 
@@ -163,8 +172,25 @@ public:
         const ProjectionData& target,
         bool handle_on_node = false) const;
 
+    /**
+     * Set the starting point and the transportation mode without initializing the buffers of the searches,
+     * for the searches having their own (init_start does it)
+     */
+    void init_starting_edge(const type::GeographicalCoord& start_coord, nt::Mode_e mode, const float speed_factor);
+
+    /// Set the transportation mode without starting point, for the durations to the targets only (get_target_ends)
+    void init_mode(nt::Mode_e mode, const float speed_factor);
+
+    // the ends of the starting edge the searches start from, with the duration to reach them
+    std::vector<std::pair<ProjectionData::Direction, navitia::time_duration>> get_starting_ends() const;
+
+    // the ends of the edge of the target it can be reached from, with the duration from them to the target
+    // (as find_nearest_vertex with handle_on_node)
+    std::vector<std::pair<ProjectionData::Direction, navitia::time_duration>> get_target_ends(
+        const ProjectionData& target) const;
+
     // return the duration between two projection on the same edge
-    navitia::time_duration path_duration_on_same_edge(const ProjectionData& p1, const ProjectionData& p2);
+    navitia::time_duration path_duration_on_same_edge(const ProjectionData& p1, const ProjectionData& p2) const;
 
     // return the real geometry between two projection on the same edge
     type::LineString path_coordinates_on_same_edge(const Edge& e, const ProjectionData& p1, const ProjectionData& p2);
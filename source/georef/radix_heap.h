@@ -0,0 +1,154 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "georef/georef_types.h"
+#include "type/time_duration.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace navitia {
+namespace georef {
+
+/*
+ * Monotone radix heap of vertices, keyed by durations, usable by the
+ * breadth first visits of the dijkstra and the astar instead of the d-ary
+ * heap (see PriorityQueue_e).
+ *
+ * The durations being small non negative integers (in ticks) and the
+ * extracted minimum never decreasing, the vertices are kept in buckets by
+ * the highest bit their key differs from the last minimum: a push is
+ * constant time, and each entry only moves down the 33 buckets, instead of
+ * a sift in the d-ary heap at each push and decrease.
+ *
+ * A decreased key is pushed again, the previous entry becoming stale: an
+ * entry is live while its key is the current one of its vertex.  A key
+ * lower than the last minimum (an astar heuristic not quite consistent
+ * because of the rounding) is handled as the last minimum.
+ *
+ * The buffers are kept from a search to the next.
+ */
+class RadixHeap {
+public:
+    // start an empty heap on the keys, as the d-ary heap the keys are read when pushing
+    void reset(const navitia::time_duration* keys) {
+        this->keys = keys;
+        last = 0;
+        for (auto& bucket : buckets) {
+            bucket.clear();
+        }
+    }
+
+    bool empty() { return !refill(); }
+
+    vertex_t top() {
+        refill();
+        return buckets[0].back().vertex;
+    }
+
+    void pop() {
+        refill();
+        buckets[0].pop_back();
+    }
+
+    void push(vertex_t v) {
+        const auto key = key_of(v);
+        buckets[bucket_of(key)].push_back({key, v});
+    }
+
+    // the key of the vertex has decreased
+    void update(vertex_t v) { push(v); }
+
+private:
+    struct Entry {
+        uint32_t key;
+        vertex_t vertex;
+    };
+
+    const navitia::time_duration* keys = nullptr;
+    uint32_t last = 0;
+    // buckets[0] holds the entries of key last, buckets[i] the ones differing from last on bit i - 1 at most
+    std::array<std::vector<Entry>, 33> buckets;
+
+    uint32_t key_of(vertex_t v) const {
+        const auto ticks = keys[v].ticks();
+        return ticks > 0 ? uint32_t(ticks) : 0;
+    }
+
+    bool is_stale(const Entry& entry) const { return entry.key != key_of(entry.vertex); }
+
+    size_t bucket_of(uint32_t key) const {
+        if (key <= last) {
+            return 0;
+        }
+        return 32 - __builtin_clz(key ^ last);
+    }
+
+    // move the live entries of the lowest key to buckets[0], false if there is none
+    bool refill() {
+        auto& lowest = buckets[0];
+        while (true) {
+            while (!lowest.empty() && is_stale(lowest.back())) {
+                lowest.pop_back();
+            }
+            if (!lowest.empty()) {
+                return true;
+            }
+            size_t i = 1;
+            while (i < buckets.size() && buckets[i].empty()) {
+                ++i;
+            }
+            if (i == buckets.size()) {
+                return false;
+            }
+            auto& bucket = buckets[i];
+            auto end = std::remove_if(bucket.begin(), bucket.end(), [&](const Entry& e) { return is_stale(e); });
+            if (end == bucket.begin()) {
+                bucket.clear();
+                continue;
+            }
+            last = std::min_element(bucket.begin(), end, [](const Entry& a, const Entry& b) {
+                       return a.key < b.key;
+                   })->key;
+            // all the entries go to lower buckets, as they all share the bits of last above bit i - 1
+            for (auto it = bucket.begin(); it != end; ++it) {
+                buckets[bucket_of(it->key)].push_back(*it);
+            }
+            bucket.clear();
+        }
+    }
+};
+
+}  // namespace georef
+}  // namespace navitia
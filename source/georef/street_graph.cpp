@@ -0,0 +1,133 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "georef/street_graph.h"
+
+#include "georef/georef.h"
+#include "utils/exception.h"
+
+#include <limits>
+#include <string>
+
+namespace navitia {
+namespace georef {
+
+namespace {
+
+// an out edge of a vertex of a layer of the Graph
+struct LayerEdge {
+    uint32_t target;
+    uint32_t target_layer;
+    nt::idx_t way_idx;
+    nt::idx_t geom_idx;
+    navitia::time_duration duration;
+
+    bool same_edge(const LayerEdge& other) const {
+        return target == other.target && way_idx == other.way_idx && geom_idx == other.geom_idx;
+    }
+};
+
+}  // namespace
+
+bool StreetGraph::can_be_built(const Graph& g, uint32_t nb_vertices) {
+    const size_t nb_graph_vertices = boost::num_vertices(g);
+    return nb_vertices != 0 && nb_graph_vertices % nb_vertices == 0 && nb_graph_vertices / nb_vertices <= max_nb_layers;
+}
+
+StreetGraph::StreetGraph(const Graph& g, uint32_t nb_vertices) : nb_vertices(nb_vertices) {
+    if (!can_be_built(g, nb_vertices)) {
+        throw navitia::exception("the street graph needs the " + std::to_string(boost::num_vertices(g))
+                                 + " vertices of the graph in layers of " + std::to_string(nb_vertices) + " vertices");
+    }
+    nb_layers = boost::num_vertices(g) / nb_vertices;
+    edge_offsets.reserve(nb_vertices + 1);
+    duration_offsets.reserve(nb_vertices + 1);
+
+    std::vector<std::vector<LayerEdge>> layer_edges(nb_layers);
+    std::vector<size_t> heads(nb_layers);
+    for (uint32_t v = 0; v < nb_vertices; ++v) {
+        edge_offsets.push_back(targets.size());
+        duration_offsets.push_back(durations.size());
+        for (uint32_t layer = 0; layer < nb_layers; ++layer) {
+            layer_edges[layer].clear();
+            heads[layer] = 0;
+            for (const auto& e : boost::make_iterator_range(boost::out_edges(layer * nb_vertices + v, g))) {
+                const auto target = boost::target(e, g);
+                layer_edges[layer].push_back({uint32_t(target % nb_vertices), uint32_t(target / nb_vertices),
+                                              g[e].way_idx, g[e].geom_idx, g[e].duration});
+            }
+        }
+        // The next edge of the first layer is merged with the next edges of
+        // the other layers when they are the same edge, so each layer keeps
+        // the order of its edges
+        while (true) {
+            uint32_t first = 0;
+            while (first < nb_layers && heads[first] == layer_edges[first].size()) {
+                ++first;
+            }
+            if (first == nb_layers) {
+                break;
+            }
+            const auto& edge = layer_edges[first][heads[first]++];
+            uint8_t edge_layers = 1 << first;
+            durations.push_back(edge.duration);
+            if (edge.target_layer != first) {
+                edge_layers |= (edge.target_layer + 1) << 4;
+            } else {
+                for (uint32_t layer = first + 1; layer < nb_layers; ++layer) {
+                    if (heads[layer] == layer_edges[layer].size()) {
+                        continue;
+                    }
+                    const auto& other = layer_edges[layer][heads[layer]];
+                    if (other.target_layer == layer && other.same_edge(edge)) {
+                        edge_layers |= 1 << layer;
+                        durations.push_back(other.duration);
+                        ++heads[layer];
+                    }
+                }
+            }
+            targets.push_back(edge.target);
+            layers.push_back(edge_layers);
+        }
+    }
+    if (durations.size() > std::numeric_limits<uint32_t>::max()) {
+        throw navitia::exception("too many edges for the street graph: " + std::to_string(durations.size()));
+    }
+    edge_offsets.push_back(targets.size());
+    duration_offsets.push_back(durations.size());
+}
+
+size_t StreetGraph::memory_size() const {
+    return (edge_offsets.size() + duration_offsets.size() + targets.size()) * sizeof(uint32_t)
+           + layers.size() * sizeof(uint8_t) + durations.size() * sizeof(navitia::time_duration);
+}
+
+}  // namespace georef
+}  // namespace navitia
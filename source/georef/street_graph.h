@@ -0,0 +1,284 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "georef/georef_types.h"
+#include "type/time_duration.h"
+#include "type/type_interfaces.h"
+#include "utils/flat_enum_map.h"
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/property_map/property_map.hpp>
+
+#include <bitset>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace navitia {
+namespace georef {
+
+/**
+ * Read only, single layer copy of the street network graph searched by the
+ * path finders.
+ *
+ * The Graph has a layer of vertices per transportation mode (walking, bike
+ * and car, see GeoRef::init): the vertex v is the vertex v % nb_vertices of
+ * the layer v / nb_vertices.  Here each vertex is stored once, with its out
+ * edges contiguous in compressed sparse row.  An edge existing in several
+ * layers, i.e. for the same way between the same vertices, is stored once
+ * with the mask of its layers and a duration per layer.  The edges changing
+ * of layer (bss and parking, see GeoRef::add_bss_edges) are stored with
+ * their target layer.
+ *
+ * The searches still see the vertices of the Graph through a View, the
+ * layer being their state, and each layer gets its out edges in the order
+ * of the Graph, so they visit it exactly as the Graph.
+ *
+ * It is built from the Graph once it is complete (see
+ * GeoRef::build_street_graph), the Graph still being used to build the
+ * paths and the projections.  It is only meant to speed up the searches:
+ * it comes in addition to the layers of the Graph and to the proximity
+ * lists per mode, that are all kept, so it increases the memory used by
+ * the georef (see benchmark_street_graph).
+ */
+struct StreetGraph {
+    static constexpr uint32_t max_nb_layers = 4;
+
+    struct EdgeDescriptor {
+        uint32_t source = 0;
+        uint32_t target = 0;
+        uint32_t duration_idx = 0;
+
+        bool operator==(const EdgeDescriptor& other) const {
+            return source == other.source && target == other.target && duration_idx == other.duration_idx;
+        }
+        bool operator!=(const EdgeDescriptor& other) const { return !(*this == other); }
+    };
+
+    uint32_t nb_vertices = 0;
+    uint32_t nb_layers = 0;
+    // for each vertex, its first edge and its first duration
+    std::vector<uint32_t> edge_offsets;
+    std::vector<uint32_t> duration_offsets;
+    // for each edge, its target and its layers: the mask of the layers
+    // having it in the low bits, its target layer + 1 in the high bits if
+    // it changes of layer
+    std::vector<uint32_t> targets;
+    std::vector<uint8_t> layers;
+    // for each edge, its duration in each of its layers
+    std::vector<navitia::time_duration> durations;
+
+    /*
+     * nb_vertices is the number of vertices by layer (GeoRef::nb_vertex_by_mode)
+     * Throws if the vertices of the Graph are not in at most max_nb_layers layers
+     */
+    StreetGraph(const Graph& g, uint32_t nb_vertices);
+
+    // the vertices of the Graph are in at most max_nb_layers layers of nb_vertices vertices
+    static bool can_be_built(const Graph& g, uint32_t nb_vertices);
+
+    // the Graph has been modified since the build if its number of vertices changed
+    bool is_built_from(const Graph& g) const { return boost::num_vertices(g) == size_t(nb_vertices) * nb_layers; }
+
+    // number of edges of the Graph this graph holds
+    size_t nb_edges() const { return durations.size(); }
+
+    // approximate size of the graph in bytes
+    size_t memory_size() const;
+
+    static uint8_t layer_mask(uint8_t edge_layers) { return edge_layers & 0x0f; }
+    static uint32_t target_layer(uint8_t edge_layers, uint32_t source_layer) {
+        return (edge_layers >> 4) == 0 ? source_layer : (edge_layers >> 4) - 1;
+    }
+
+    class View;
+};
+
+/*
+ * Out edges of a vertex of the Graph, restricted to the edges targeting an
+ * allowed layer
+ */
+class StreetOutEdgeIterator : public boost::iterator_facade<StreetOutEdgeIterator,
+                                                            const StreetGraph::EdgeDescriptor,
+                                                            std::forward_iterator_tag> {
+    const StreetGraph* graph = nullptr;
+    uint8_t allowed_layers = 0;
+    uint32_t layer = 0;
+    uint32_t edge_idx = 0;
+    uint32_t end_idx = 0;
+    // first duration of the edge edge_idx
+    uint32_t duration_idx = 0;
+    StreetGraph::EdgeDescriptor edge;
+
+    friend class boost::iterator_core_access;
+
+    static uint32_t nb_edge_layers(uint8_t edge_layers) {
+        return std::bitset<8>(StreetGraph::layer_mask(edge_layers)).count();
+    }
+
+    // moves to the first edge from edge_idx existing in the layer and targeting an allowed layer
+    void settle() {
+        while (edge_idx < end_idx) {
+            const uint8_t edge_layers = graph->layers[edge_idx];
+            const uint8_t mask = StreetGraph::layer_mask(edge_layers);
+            const auto target_layer = StreetGraph::target_layer(edge_layers, layer);
+            if ((mask & (1 << layer)) && (allowed_layers & (1 << target_layer))) {
+                edge.target = target_layer * graph->nb_vertices + graph->targets[edge_idx];
+                // the durations of an edge are by increasing layer
+                edge.duration_idx = duration_idx + std::bitset<8>(mask & ((1 << layer) - 1)).count();
+                return;
+            }
+            duration_idx += nb_edge_layers(edge_layers);
+            ++edge_idx;
+        }
+    }
+    void increment() {
+        duration_idx += nb_edge_layers(graph->layers[edge_idx]);
+        ++edge_idx;
+        settle();
+    }
+    bool equal(const StreetOutEdgeIterator& other) const { return edge_idx == other.edge_idx; }
+    const StreetGraph::EdgeDescriptor& dereference() const { return edge; }
+
+public:
+    StreetOutEdgeIterator() = default;
+    StreetOutEdgeIterator(const StreetGraph& graph, uint8_t allowed_layers, uint32_t source, bool end)
+        : graph(&graph), allowed_layers(allowed_layers), layer(source / graph.nb_vertices) {
+        const auto vertex = source % graph.nb_vertices;
+        edge_idx = graph.edge_offsets[vertex];
+        end_idx = graph.edge_offsets[vertex + 1];
+        duration_idx = graph.duration_offsets[vertex];
+        edge.source = source;
+        if (end) {
+            edge_idx = end_idx;
+        } else {
+            settle();
+        }
+    }
+};
+
+/*
+ * The street graph seen as the Graph restricted to the layers of a
+ * transportation mode, to be searched by the boost algorithms
+ */
+class StreetGraph::View {
+    const StreetGraph* graph;
+    uint8_t allowed_layers = 0;
+
+public:
+    View(const StreetGraph& graph, const flat_enum_map<type::Mode_e, bool>& acceptable_modes) : graph(&graph) {
+        // as in TransportationModeFilter, the layer l holds the vertices of the mode l
+        for (uint32_t layer = 0; layer < graph.nb_layers; ++layer) {
+            if (acceptable_modes[type::Mode_e(layer)]) {
+                allowed_layers |= 1 << layer;
+            }
+        }
+    }
+
+    std::pair<StreetOutEdgeIterator, StreetOutEdgeIterator> out_edges(uint32_t v) const {
+        return {StreetOutEdgeIterator(*graph, allowed_layers, v, false),
+                StreetOutEdgeIterator(*graph, allowed_layers, v, true)};
+    }
+    uint32_t num_vertices() const { return graph->nb_vertices * graph->nb_layers; }
+
+    struct DurationMap {
+        const navitia::time_duration* durations;
+    };
+    DurationMap duration_map() const { return {graph->durations.data()}; }
+};
+
+inline std::pair<StreetOutEdgeIterator, StreetOutEdgeIterator> out_edges(uint32_t v, const StreetGraph::View& g) {
+    return g.out_edges(v);
+}
+inline size_t out_degree(uint32_t v, const StreetGraph::View& g) {
+    const auto edges = g.out_edges(v);
+    return std::distance(edges.first, edges.second);
+}
+inline uint32_t source(const StreetGraph::EdgeDescriptor& e, const StreetGraph::View&) {
+    return e.source;
+}
+inline uint32_t target(const StreetGraph::EdgeDescriptor& e, const StreetGraph::View&) {
+    return e.target;
+}
+inline size_t num_vertices(const StreetGraph::View& g) {
+    return g.num_vertices();
+}
+inline const navitia::time_duration& get(const StreetGraph::View::DurationMap& map,
+                                         const StreetGraph::EdgeDescriptor& e) {
+    return map.durations[e.duration_idx];
+}
+
+/*
+ * The distances and predecessors vectors are given to the boost searches
+ * through these maps, usable with the vertex descriptors of both the Graph
+ * and the street graph.
+ */
+using vertex_index_map = boost::typed_identity_property_map<vertex_t>;
+using duration_map = boost::iterator_property_map<navitia::time_duration*, vertex_index_map>;
+using predecessor_map = boost::iterator_property_map<vertex_t*, vertex_index_map>;
+
+}  // namespace georef
+}  // namespace navitia
+
+namespace boost {
+
+template <>
+struct graph_traits<navitia::georef::StreetGraph::View> {
+    using vertex_descriptor = uint32_t;
+    using edge_descriptor = navitia::georef::StreetGraph::EdgeDescriptor;
+    using out_edge_iterator = navitia::georef::StreetOutEdgeIterator;
+    using directed_category = directed_tag;
+    using edge_parallel_category = allow_parallel_edge_tag;
+    using traversal_category = incidence_graph_tag;
+    using degree_size_type = size_t;
+    using vertices_size_type = size_t;
+    using edges_size_type = size_t;
+    using vertex_iterator = void;
+    using adjacency_iterator = void;
+    using in_edge_iterator = void;
+    using edge_iterator = void;
+
+    static vertex_descriptor null_vertex() { return std::numeric_limits<vertex_descriptor>::max(); }
+};
+
+template <>
+struct property_traits<navitia::georef::StreetGraph::View::DurationMap> {
+    using key_type = navitia::georef::StreetGraph::EdgeDescriptor;
+    using value_type = navitia::time_duration;
+    using reference = const navitia::time_duration&;
+    using category = readable_property_map_tag;
+};
+
+}  // namespace boost
@@ -38,8 +38,12 @@ www.navitia.io
 namespace navitia {
 namespace georef {
 
-StreetNetwork::StreetNetwork(const GeoRef& geo_ref)
-    : geo_ref(geo_ref), departure_path_finder(geo_ref), arrival_path_finder(geo_ref), direct_path_finder(geo_ref) {}
+StreetNetwork::StreetNetwork(const GeoRef& geo_ref, PriorityQueue_e priority_queue)
+    : geo_ref(geo_ref), departure_path_finder(geo_ref), arrival_path_finder(geo_ref), direct_path_finder(geo_ref) {
+    departure_path_finder.priority_queue = priority_queue;
+    arrival_path_finder.priority_queue = priority_queue;
+    direct_path_finder.priority_queue = priority_queue;
+}
 
 void StreetNetwork::init(const type::EntryPoint& start, const boost::optional<const type::EntryPoint&>& end) {
     departure_path_finder.init(start.coordinates, start.streetnetwork_params.mode,
@@ -137,9 +141,14 @@ Path StreetNetwork::get_direct_path(const type::EntryPoint& origin, const type::
     direct_path_finder.init(origin.coordinates, dest_edge.projected, origin.streetnetwork_params.mode,
                             origin.streetnetwork_params.speed_factor);
 
-    direct_path_finder.start_distance_or_target_astar(max_dur, dest_edge.projected,
-                                                      {dest_edge[source_e], dest_edge[target_e]});
-    const auto dest_vertex = direct_path_finder.find_nearest_vertex(dest_edge, true);
+    std::pair<navitia::time_duration, ProjectionData::Direction> dest_vertex;
+    if (const auto* hierarchy = geo_ref.get_contraction_hierarchy(origin.streetnetwork_params.mode)) {
+        dest_vertex = direct_path_finder.start_distance_or_target_hierarchy(*hierarchy, max_dur, dest_edge);
+    } else {
+        direct_path_finder.start_distance_or_target_astar(max_dur, dest_edge.projected,
+                                                          {dest_edge[source_e], dest_edge[target_e]});
+        dest_vertex = direct_path_finder.find_nearest_vertex(dest_edge, true);
+    }
     const auto res = direct_path_finder.get_path(dest_edge, dest_vertex);
     if (res.duration > max_dur) {
         return Path();
@@ -41,7 +41,7 @@ namespace georef {
 
 /** Structure managing the computation on the streetnetwork */
 struct StreetNetwork {
-    StreetNetwork(const GeoRef& geo_ref);
+    StreetNetwork(const GeoRef& geo_ref, PriorityQueue_e priority_queue = PriorityQueue_e::d_ary_heap);
 
     void init(const type::EntryPoint& start, const boost::optional<const type::EntryPoint&>& end = {});
 
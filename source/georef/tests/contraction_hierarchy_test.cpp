@@ -0,0 +1,292 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_contraction_hierarchy
+#include "georef/contraction_hierarchy.h"
+#include "georef/georef.h"
+#include "georef/path_finder.h"
+#include "georef/street_network.h"
+#include "builder.h"
+#include "type/flat_nav.h"
+#include "utils/functions.h"  // absolute_path function
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <queue>
+#include <random>
+
+using namespace navitia::georef;
+using namespace navitia;
+
+namespace {
+
+/*
+ * A square of side vertices 10 meters apart in each layer, the edges of
+ * the car layer missing on some ways, the durations depending on the
+ * direction
+ */
+void build_square(GraphBuilder& b, size_t side) {
+    for (size_t i = 0; i < side; ++i) {
+        for (size_t j = 0; j < side; ++j) {
+            boost::add_vertex(Vertex(i * 10., j * 10., true), b.geo_ref.graph);
+        }
+    }
+    b.geo_ref.init();
+    const vertex_t nb_vertices = b.geo_ref.nb_vertex_by_mode;
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < side; ++i) {
+        for (size_t j = 0; j < side; ++j) {
+            const vertex_t v = i * side + j;
+            std::vector<vertex_t> neighbours;
+            if (j + 1 < side) {
+                neighbours.push_back(v + 1);
+            }
+            if (i + 1 < side) {
+                neighbours.push_back(v + side);
+            }
+            for (const auto w : neighbours) {
+                for (const auto mode : {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car}) {
+                    const auto offset = b.geo_ref.offsets[mode];
+                    if (mode == type::Mode_e::Car && rng() % 4 == 0) {
+                        continue;
+                    }
+                    // not shorter than at the default speed, as expected by the astar heuristic
+                    const int min_duration = std::ceil(10. / default_speed[mode]);
+                    boost::add_edge(v + offset, w + offset, Edge(v, navitia::seconds(min_duration + rng() % 10)),
+                                    b.geo_ref.graph);
+                    boost::add_edge(w + offset, v + offset, Edge(v, navitia::seconds(min_duration + rng() % 10)),
+                                    b.geo_ref.graph);
+                }
+            }
+        }
+    }
+    BOOST_REQUIRE_EQUAL(boost::num_vertices(b.geo_ref.graph), 3 * nb_vertices);
+}
+
+// the shortest durations in ticks from the sources, on the vertices of the allowed modes
+std::vector<uint64_t> dijkstra(const Graph& graph,
+                               size_t nb_vertices_by_layer,
+                               const flat_enum_map<type::Mode_e, bool>& allowed_modes,
+                               const std::vector<ContractionHierarchyQuery::Endpoint>& sources) {
+    using Label = std::pair<uint64_t, vertex_t>;
+    std::vector<uint64_t> durations(boost::num_vertices(graph), std::numeric_limits<uint64_t>::max());
+    std::priority_queue<Label, std::vector<Label>, std::greater<Label>> queue;
+    for (const auto& source : sources) {
+        durations[source.first] = std::min<uint64_t>(durations[source.first], source.second);
+        queue.push({durations[source.first], source.first});
+    }
+    while (!queue.empty()) {
+        const auto label = queue.top();
+        queue.pop();
+        if (label.first > durations[label.second]) {
+            continue;
+        }
+        for (const auto& e : boost::make_iterator_range(boost::out_edges(label.second, graph))) {
+            const auto target = boost::target(e, graph);
+            const auto duration = label.first + graph[e].duration.ticks();
+            if (allowed_modes[type::Mode_e(target / nb_vertices_by_layer)] && duration < durations[target]) {
+                durations[target] = duration;
+                queue.push({duration, target});
+            }
+        }
+    }
+    return durations;
+}
+
+// the duration of the path from its first to its last vertex on the shortest edges
+uint64_t path_duration(const Graph& graph, const std::vector<uint32_t>& path) {
+    uint64_t result = 0;
+    for (size_t i = 1; i < path.size(); ++i) {
+        uint64_t shortest = std::numeric_limits<uint64_t>::max();
+        for (const auto& e : boost::make_iterator_range(boost::out_edges(path[i - 1], graph))) {
+            if (boost::target(e, graph) == path[i]) {
+                shortest = std::min<uint64_t>(shortest, graph[e].duration.ticks());
+            }
+        }
+        BOOST_REQUIRE(shortest != std::numeric_limits<uint64_t>::max());
+        result += shortest;
+    }
+    return result;
+}
+
+}  // namespace
+
+/*
+ * The shortest paths found in the hierarchy are as short as the ones found
+ * by a dijkstra, from several sources to several targets
+ */
+BOOST_AUTO_TEST_CASE(hierarchy_finds_the_shortest_paths) {
+    GraphBuilder b;
+    const size_t side = 40;
+    build_square(b, side);
+    const auto& graph = b.geo_ref.graph;
+    const auto nb_vertices = b.geo_ref.nb_vertex_by_mode;
+
+    for (const auto mode : {type::Mode_e::Bike, type::Mode_e::Car}) {
+        const auto& allowed_modes = allowed_transportation_mode[mode];
+        const ContractionHierarchy hierarchy(graph, nb_vertices, allowed_modes);
+        BOOST_CHECK_EQUAL(hierarchy.nb_vertices(), boost::num_vertices(graph));
+        // the car reaches the walking layer, as in a direct path
+        const auto target_offset = b.geo_ref.offsets[mode == type::Mode_e::Car ? type::Mode_e::Walking : mode];
+
+        ContractionHierarchyQuery query;
+        std::mt19937 rng(7);
+        size_t nb_found = 0;
+        for (int i = 0; i < 100; ++i) {
+            const std::vector<ContractionHierarchyQuery::Endpoint> sources = {
+                {b.geo_ref.offsets[mode] + rng() % nb_vertices, rng() % 50},
+                {b.geo_ref.offsets[mode] + rng() % nb_vertices, rng() % 50}};
+            const std::vector<ContractionHierarchyQuery::Endpoint> targets = {
+                {target_offset + rng() % nb_vertices, rng() % 50}, {target_offset + rng() % nb_vertices, rng() % 50}};
+            const uint32_t max_duration = i % 10 == 0 ? 500 : 100000;
+
+            const auto durations = dijkstra(graph, nb_vertices, allowed_modes, sources);
+            uint64_t expected = std::numeric_limits<uint64_t>::max();
+            for (const auto& target : targets) {
+                if (durations[target.first] != std::numeric_limits<uint64_t>::max()) {
+                    expected = std::min(expected, durations[target.first] + target.second);
+                }
+            }
+
+            const auto path = query.shortest_path(hierarchy, sources, targets, max_duration);
+            if (expected > max_duration) {
+                BOOST_CHECK(path.empty());
+                continue;
+            }
+            BOOST_REQUIRE(!path.empty());
+            ++nb_found;
+            uint64_t from_source = std::numeric_limits<uint64_t>::max();
+            for (const auto& source : sources) {
+                if (source.first == path.front()) {
+                    from_source = std::min<uint64_t>(from_source, source.second);
+                }
+            }
+            uint64_t to_target = std::numeric_limits<uint64_t>::max();
+            for (const auto& target : targets) {
+                if (target.first == path.back()) {
+                    to_target = std::min<uint64_t>(to_target, target.second);
+                }
+            }
+            BOOST_REQUIRE(from_source != std::numeric_limits<uint64_t>::max());
+            BOOST_REQUIRE(to_target != std::numeric_limits<uint64_t>::max());
+            BOOST_CHECK_EQUAL(from_source + path_duration(graph, path) + to_target, expected);
+            BOOST_CHECK_LT(query.nb_settled, nb_vertices);
+        }
+        BOOST_CHECK_GT(nb_found, 50);
+    }
+}
+
+/*
+ * The direct paths by car and bike found in the hierarchies are as long as
+ * the ones found by the astar
+ */
+BOOST_AUTO_TEST_CASE(direct_path_in_hierarchy) {
+    GraphBuilder b;
+    build_square(b, 30);
+    b.geo_ref.build_proximity_list();
+    type::GeographicalCoord parking;
+    parking.set_xy(101., 152.);
+    BOOST_REQUIRE(b.geo_ref.add_parking_edges(parking));
+    b.geo_ref.build_contraction_hierarchies();
+    BOOST_REQUIRE(b.geo_ref.get_contraction_hierarchy(type::Mode_e::Car));
+    BOOST_REQUIRE(b.geo_ref.get_contraction_hierarchy(type::Mode_e::Bike));
+    BOOST_CHECK(!b.geo_ref.get_contraction_hierarchy(type::Mode_e::Walking));
+    const auto hierarchies = b.geo_ref.contraction_hierarchies;
+
+    StreetNetwork worker(b.geo_ref);
+    type::EntryPoint origin;
+    type::EntryPoint destination;
+    origin.streetnetwork_params.max_duration = navitia::hours(1);
+    destination.streetnetwork_params.max_duration = navitia::hours(1);
+    std::mt19937 rng(3);
+    size_t nb_found = 0;
+    for (const auto mode : {type::Mode_e::Bike, type::Mode_e::Car}) {
+        origin.streetnetwork_params.mode = mode;
+        for (int i = 0; i < 20; ++i) {
+            origin.coordinates.set_xy(rng() % 290, rng() % 290);
+            destination.coordinates.set_xy(rng() % 290, rng() % 290);
+            origin.streetnetwork_params.speed_factor = i % 2 ? 1. : 1.5;
+
+            b.geo_ref.contraction_hierarchies = hierarchies;
+            const auto in_hierarchy = worker.get_direct_path(origin, destination);
+            b.geo_ref.contraction_hierarchies = {};
+            const auto with_astar = worker.get_direct_path(origin, destination);
+
+            BOOST_REQUIRE_EQUAL(in_hierarchy.path_items.empty(), with_astar.path_items.empty());
+            if (with_astar.path_items.empty()) {
+                continue;
+            }
+            ++nb_found;
+            // with a speed factor, the durations are rounded edge by edge
+            const auto difference = in_hierarchy.duration - with_astar.duration;
+            BOOST_CHECK_LE(std::abs(difference.total_milliseconds()), i % 2 ? 0 : 2000);
+        }
+    }
+    BOOST_CHECK_GT(nb_found, 20);
+}
+
+/*
+ * A hierarchy saved in a flat nav is used in place
+ */
+BOOST_AUTO_TEST_CASE(hierarchy_saved_in_flat_nav) {
+    GraphBuilder b;
+    build_square(b, 20);
+    const auto& graph = b.geo_ref.graph;
+    const auto nb_vertices = b.geo_ref.nb_vertex_by_mode;
+    const ContractionHierarchy hierarchy(graph, nb_vertices, allowed_transportation_mode[type::Mode_e::Bike]);
+
+    const std::string flat_nav_path = navitia::absolute_path() + "contraction_hierarchy_test.nav.flat";
+    type::FlatNavWriter writer;
+    hierarchy.save_flat(writer, "hierarchy");
+    writer.write(flat_nav_path, 1, 42);
+    const auto flat_nav = type::FlatNav::open(flat_nav_path);
+
+    BOOST_CHECK(!ContractionHierarchy::from_flat(flat_nav, "other", boost::num_vertices(graph)));
+    BOOST_CHECK(!ContractionHierarchy::from_flat(flat_nav, "hierarchy", boost::num_vertices(graph) + 1));
+    const auto mapped = ContractionHierarchy::from_flat(flat_nav, "hierarchy", boost::num_vertices(graph));
+    BOOST_REQUIRE(mapped);
+    BOOST_CHECK_EQUAL(mapped->nb_arcs(), hierarchy.nb_arcs());
+
+    ContractionHierarchyQuery query;
+    const auto offset = b.geo_ref.offsets[type::Mode_e::Bike];
+    for (vertex_t v = 0; v < nb_vertices; v += 7) {
+        const std::vector<ContractionHierarchyQuery::Endpoint> sources = {{offset + v, 0}};
+        const std::vector<ContractionHierarchyQuery::Endpoint> targets = {{offset + nb_vertices - 1 - v, 0}};
+        const auto expected = query.shortest_path(hierarchy, sources, targets, 100000);
+        const auto found = query.shortest_path(*mapped, sources, targets, 100000);
+        BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+    }
+
+    boost::filesystem::remove(flat_nav_path);
+}
@@ -37,6 +37,7 @@ www.navitia.io
 #include "type/stop_point.h"
 
 #include "georef/street_network.h"
+#include "georef/street_graph.h"
 #include <boost/test/unit_test.hpp>
 
 using namespace navitia::georef;
@@ -140,11 +141,6 @@ BOOST_AUTO_TEST_CASE(djikstra_idempotence) {
     // we have to find a way to get there
     BOOST_REQUIRE_NE(distance, bt::pos_infin);
 
-    std::cout << "distance " << distance << " proj distance to source " << proj.distances[dir::Source]
-              << " proj distance to target " << proj.distances[dir::Target] << " distance to source "
-              << worker.distances[proj[dir::Source]] << " distance to target " << worker.distances[proj[dir::Target]]
-              << std::endl;
-
     // the distance matrix also has to be updated
     BOOST_CHECK(
         worker.distances[proj[dir::Source]]
@@ -233,3 +229,191 @@ BOOST_AUTO_TEST_CASE(astar_init) {
         BOOST_CHECK_THROW(worker.costs.at(worker.starting_edge[dir::Target]), proximitylist::NotFound);
     }
 }
+
+/**
+ * The path finders search the compact street graph once built, they have to
+ * find the same distances and predecessors as on the boost graph
+ *
+ **/
+BOOST_AUTO_TEST_CASE(street_graph_same_results_as_graph) {
+    GraphBuilder b;
+    const size_t square_size = 150;
+    for (size_t i = 0; i < square_size; ++i) {
+        for (size_t j = 0; j < square_size; ++j) {
+            boost::add_vertex(Vertex(i * 10., j * 10., true), b.geo_ref.graph);
+        }
+    }
+    for (size_t i = 0; i < square_size - 1; ++i) {
+        for (size_t j = 0; j < square_size - 1; ++j) {
+            const vertex_t v = i * square_size + j;
+            // various durations to have different shortest paths
+            for (const vertex_t w : {v + 1, v + square_size}) {
+                boost::add_edge(v, w, Edge(0, navitia::seconds(5 + (i * 7 + j * 3) % 11)), b.geo_ref.graph);
+                boost::add_edge(w, v, Edge(0, navitia::seconds(5 + (i * 3 + j * 7) % 13)), b.geo_ref.graph);
+            }
+        }
+    }
+    b.init();
+    BOOST_REQUIRE(b.geo_ref.street_graph);
+    BOOST_REQUIRE(b.geo_ref.street_graph->is_built_from(b.geo_ref.graph));
+    const auto street_graph = b.geo_ref.street_graph;
+
+    type::GeographicalCoord start;
+    start.set_xy(12., 13.);
+    type::GeographicalCoord destination;
+    destination.set_xy(1400., 1300.);
+    const auto dest = ProjectionData(destination, b.geo_ref, type::Mode_e::Walking);
+    BOOST_REQUIRE(dest.found);
+
+    auto dijkstra = [&]() {
+        DijkstraPathFinder worker(b.geo_ref);
+        worker.init(start, type::Mode_e::Walking, 1);
+        worker.start_distance_dijkstra(navitia::hours(10));
+        return computation_results{{}, worker};
+    };
+    auto astar = [&]() {
+        AstarPathFinder worker(b.geo_ref);
+        worker.init(start, dest.projected, type::Mode_e::Walking, 1);
+        worker.start_distance_or_target_astar(navitia::hours(10), dest.projected,
+                                              {dest[dir::Source], dest[dir::Target]});
+        return computation_results{{}, worker};
+    };
+
+    auto dijkstra_on_street_graph = dijkstra();
+    auto astar_on_street_graph = astar();
+
+    // without the street graph, the boost graph is searched
+    b.geo_ref.street_graph.reset();
+    auto dijkstra_on_graph = dijkstra();
+    auto astar_on_graph = astar();
+
+    BOOST_CHECK(dijkstra_on_street_graph == dijkstra_on_graph);
+    BOOST_CHECK(astar_on_street_graph == astar_on_graph);
+    BOOST_CHECK_EQUAL(street_graph->nb_edges(), boost::num_edges(b.geo_ref.graph));
+}
+
+/**
+ * The street graph stores once the edges of several layers, with their
+ * duration in each layer, and the edges changing of layer: the searches
+ * using several layers find the same results as on the boost graph
+ *
+ **/
+BOOST_AUTO_TEST_CASE(street_graph_same_results_as_graph_on_several_layers) {
+    GraphBuilder b;
+    const size_t square_size = 30;
+    for (size_t i = 0; i < square_size; ++i) {
+        for (size_t j = 0; j < square_size; ++j) {
+            boost::add_vertex(Vertex(i * 10., j * 10., true), b.geo_ref.graph);
+        }
+    }
+    b.geo_ref.init();
+    const vertex_t nb_vertices = b.geo_ref.nb_vertex_by_mode;
+    for (size_t i = 0; i < square_size - 1; ++i) {
+        for (size_t j = 0; j < square_size - 1; ++j) {
+            const vertex_t v = i * square_size + j;
+            for (const vertex_t w : {v + 1, v + square_size}) {
+                const auto duration = navitia::seconds(5 + (i * 7 + j * 3) % 11);
+                boost::add_edge(v, w, Edge(v, duration), b.geo_ref.graph);
+                boost::add_edge(w, v, Edge(v, duration), b.geo_ref.graph);
+                boost::add_edge(v + nb_vertices, w + nb_vertices, Edge(v, duration / 3), b.geo_ref.graph);
+                boost::add_edge(w + nb_vertices, v + nb_vertices, Edge(v, duration / 3), b.geo_ref.graph);
+                // some ways are not for the cars
+                if (i % 3 != 0) {
+                    boost::add_edge(v + 2 * nb_vertices, w + 2 * nb_vertices, Edge(v, duration / 10),
+                                    b.geo_ref.graph);
+                }
+            }
+        }
+    }
+    b.geo_ref.build_proximity_list();
+    type::GeographicalCoord bss;
+    bss.set_xy(52., 103.);
+    BOOST_REQUIRE(b.geo_ref.add_bss_edges(bss));
+    type::GeographicalCoord parking;
+    parking.set_xy(201., 152.);
+    BOOST_REQUIRE(b.geo_ref.add_parking_edges(parking));
+    BOOST_REQUIRE(!b.geo_ref.street_graph);
+    b.geo_ref.build_street_graph();
+    BOOST_REQUIRE(b.geo_ref.street_graph);
+    BOOST_CHECK_EQUAL(b.geo_ref.street_graph->nb_layers, 3);
+    BOOST_CHECK_EQUAL(b.geo_ref.street_graph->nb_edges(), boost::num_edges(b.geo_ref.graph));
+    // the edges of the walking and bike layers are stored once
+    BOOST_CHECK_LT(b.geo_ref.street_graph->targets.size(), boost::num_edges(b.geo_ref.graph) * 2 / 3);
+
+    type::GeographicalCoord start;
+    start.set_xy(12., 13.);
+    auto dijkstra = [&](type::Mode_e mode) {
+        DijkstraPathFinder worker(b.geo_ref);
+        worker.init(start, mode, 1);
+        worker.start_distance_dijkstra(navitia::hours(10));
+        return computation_results{{}, worker};
+    };
+
+    const auto street_graph = b.geo_ref.street_graph;
+    for (const auto mode : {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car, type::Mode_e::Bss,
+                            type::Mode_e::CarNoPark}) {
+        b.geo_ref.street_graph = street_graph;
+        auto on_street_graph = dijkstra(mode);
+        // without the street graph, the boost graph is searched
+        b.geo_ref.street_graph.reset();
+        auto on_graph = dijkstra(mode);
+        BOOST_CHECK(on_street_graph == on_graph);
+    }
+}
+
+/**
+ * The dijkstra and the astar using a radix heap find the same durations as
+ * with the d-ary heap, the paths of equal durations possibly differing
+ *
+ **/
+BOOST_AUTO_TEST_CASE(radix_heap_same_durations_as_d_ary_heap) {
+    GraphBuilder b;
+    const size_t square_size = 100;
+    for (size_t i = 0; i < square_size; ++i) {
+        for (size_t j = 0; j < square_size; ++j) {
+            boost::add_vertex(Vertex(i * 10., j * 10., true), b.geo_ref.graph);
+        }
+    }
+    for (size_t i = 0; i < square_size - 1; ++i) {
+        for (size_t j = 0; j < square_size - 1; ++j) {
+            const vertex_t v = i * square_size + j;
+            for (const vertex_t w : {v + 1, v + square_size}) {
+                boost::add_edge(v, w, Edge(0, navitia::seconds(9 + (i * 7 + j * 3) % 11)), b.geo_ref.graph);
+                boost::add_edge(w, v, Edge(0, navitia::seconds(9 + (i * 3 + j * 7) % 13)), b.geo_ref.graph);
+            }
+        }
+    }
+    b.init();
+
+    type::GeographicalCoord start;
+    start.set_xy(12., 13.);
+    type::GeographicalCoord destination;
+    destination.set_xy(901., 703.);
+    const auto dest = ProjectionData(destination, b.geo_ref, type::Mode_e::Walking);
+    BOOST_REQUIRE(dest.found);
+
+    auto dijkstra = [&](PriorityQueue_e priority_queue) {
+        DijkstraPathFinder worker(b.geo_ref);
+        worker.priority_queue = priority_queue;
+        worker.init(start, type::Mode_e::Walking, 1.5);
+        worker.start_distance_dijkstra(navitia::hours(10));
+        return worker.distances;
+    };
+    auto astar = [&](PriorityQueue_e priority_queue) {
+        AstarPathFinder worker(b.geo_ref);
+        worker.priority_queue = priority_queue;
+        worker.init(start, dest.projected, type::Mode_e::Walking, 1);
+        worker.start_distance_or_target_astar(navitia::hours(10), dest.projected,
+                                              {dest[dir::Source], dest[dir::Target]});
+        return worker.find_nearest_vertex(dest, true).first;
+    };
+
+    const auto with_d_ary_heap = dijkstra(PriorityQueue_e::d_ary_heap);
+    const auto with_radix_heap = dijkstra(PriorityQueue_e::radix_heap);
+    BOOST_CHECK_EQUAL_COLLECTIONS(with_radix_heap.begin(), with_radix_heap.end(), with_d_ary_heap.begin(),
+                                  with_d_ary_heap.end());
+
+    const auto astar_with_d_ary_heap = astar(PriorityQueue_e::d_ary_heap);
+    BOOST_CHECK(astar_with_d_ary_heap != bt::pos_infin);
+    BOOST_CHECK_EQUAL(astar(PriorityQueue_e::radix_heap), astar_with_d_ary_heap);
+}
@@ -78,6 +78,30 @@ po::options_description get_options_description(const boost::optional<std::strin
              po::value<bool>()->default_value(*display_contributors) : po::value<bool>()->default_value(false),
          "display all contributors in feed publishers")
         ("GENERAL.raptor_cache_size", po::value<int>()->default_value(10), "maximum number of stored raptor caches")
+        ("GENERAL.raptor_scan_marked_jps_only", po::value<bool>()->default_value(true),
+                                  "at each raptor round, only scan the journey patterns marked at the previous round "
+                                  "instead of sweeping all of them")
+        ("GENERAL.raptor_nb_threads", po::value<int>()->default_value(1),
+                                  "number of threads used by each worker to scan the journey patterns of a raptor round "
+                                  "and to run the raptor second passes, 1 for a sequential computation")
+        ("GENERAL.raptor_cache_prefetch_threads", po::value<int>()->default_value(1),
+                                  "number of threads used to build in background the raptor caches of the current "
+                                  "and next days, 0 to disable the prefetching")
+        ("GENERAL.street_network_matrix_nb_threads", po::value<int>()->default_value(1),
+                                  "number of threads used by each worker to search the origins and destinations of a "
+                                  "street network routing matrix, 1 for a sequential computation")
+        ("GENERAL.street_network_radix_heap", po::value<bool>()->default_value(false),
+                                  "use a radix heap instead of a d-ary heap as priority queue of the street network "
+                                  "dijkstra and astar")
+        ("GENERAL.journey_cache_size", po::value<int>()->default_value(0),
+                                  "maximum number of journeys results kept to answer identical requests, "
+                                  "0 to disable the cache")
+        ("GENERAL.reload_journal_size", po::value<int>()->default_value(10000),
+                                  "maximum number of realtime messages received during a background reload of the data "
+                                  "and replayed on the new data, 0 to reload the data without applying realtime meanwhile")
+        ("GENERAL.data_reclaim_queue_size", po::value<int>()->default_value(2),
+                                  "maximum number of replaced data waiting to be destroyed by a dedicated thread, "
+                                  "0 to destroy them in the thread releasing them")
         ("GENERAL.log_level", po::value<std::string>(), "log level of kraken")
         ("GENERAL.log_format", po::value<std::string>()->default_value("[%D{%y-%m-%d %H:%M:%S,%q}] [%p] [%x] - %m %b:%L  %n"), "log format")
 
@@ -169,6 +193,14 @@ int Configuration::nb_threads() const {
     return size_t(nb_threads);
 }
 
+size_t Configuration::journey_cache_size() const {
+    int journey_cache_size = vm["GENERAL.journey_cache_size"].as<int>();
+    if (journey_cache_size < 0) {
+        throw std::invalid_argument("journey_cache_size must be positive");
+    }
+    return size_t(journey_cache_size);
+}
+
 bool Configuration::is_realtime_enabled() const {
     return this->vm["GENERAL.is_realtime_enabled"].as<bool>();
 }
@@ -264,6 +296,54 @@ size_t Configuration::raptor_cache_size() const {
     return size_t(raptor_cache_size);
 }
 
+bool Configuration::raptor_scan_marked_jps_only() const {
+    return vm["GENERAL.raptor_scan_marked_jps_only"].as<bool>();
+}
+
+size_t Configuration::raptor_nb_threads() const {
+    int raptor_nb_threads = vm["GENERAL.raptor_nb_threads"].as<int>();
+    if (raptor_nb_threads < 1) {
+        throw std::invalid_argument("raptor_nb_threads must be strictly positive");
+    }
+    return size_t(raptor_nb_threads);
+}
+
+size_t Configuration::raptor_cache_prefetch_threads() const {
+    int nb_threads = vm["GENERAL.raptor_cache_prefetch_threads"].as<int>();
+    if (nb_threads < 0) {
+        throw std::invalid_argument("raptor_cache_prefetch_threads must be positive");
+    }
+    return size_t(nb_threads);
+}
+
+size_t Configuration::street_network_matrix_nb_threads() const {
+    int nb_threads = vm["GENERAL.street_network_matrix_nb_threads"].as<int>();
+    if (nb_threads < 1) {
+        throw std::invalid_argument("street_network_matrix_nb_threads must be strictly positive");
+    }
+    return size_t(nb_threads);
+}
+
+bool Configuration::street_network_radix_heap() const {
+    return vm["GENERAL.street_network_radix_heap"].as<bool>();
+}
+
+size_t Configuration::reload_journal_size() const {
+    int size = vm["GENERAL.reload_journal_size"].as<int>();
+    if (size < 0) {
+        throw std::invalid_argument("reload_journal_size must be positive");
+    }
+    return size_t(size);
+}
+
+size_t Configuration::data_reclaim_queue_size() const {
+    int size = vm["GENERAL.data_reclaim_queue_size"].as<int>();
+    if (size < 0) {
+        throw std::invalid_argument("data_reclaim_queue_size must be positive");
+    }
+    return size_t(size);
+}
+
 boost::optional<std::string> Configuration::log_level() const {
     boost::optional<std::string> result;
     if (this->vm.count("GENERAL.log_level") > 0) {
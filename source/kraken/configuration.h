@@ -67,6 +67,14 @@ public:
     int kirin_retry_timeout() const;
     bool display_contributors() const;
     size_t raptor_cache_size() const;
+    bool raptor_scan_marked_jps_only() const;
+    size_t raptor_nb_threads() const;
+    size_t raptor_cache_prefetch_threads() const;
+    size_t street_network_matrix_nb_threads() const;
+    bool street_network_radix_heap() const;
+    size_t journey_cache_size() const;
+    size_t reload_journal_size() const;
+    size_t data_reclaim_queue_size() const;
     int core_file_size_limit() const;
     int slow_request_duration() const;
     boost::optional<std::string> log_level() const;
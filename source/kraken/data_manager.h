@@ -39,11 +39,23 @@ www.navitia.io
 #endif
 
 #include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
 
 #include <memory>
 #include <iostream>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 template <typename Data>
 void data_deleter(const Data* data) {
@@ -55,20 +67,165 @@ void data_deleter(const Data* data) {
 #endif
 }
 
+// Called with the name and the duration in seconds of each stage of a
+// load, possibly from several threads at the same time
+using LoadStageObserver = std::function<void(const std::string&, double)>;
+
+// Called with the duration in seconds of each destruction of a retired data
+using ReclaimObserver = std::function<void(double)>;
+
+/*
+ * Destroys the retired data in a dedicated thread.
+ *
+ * Destroying a data frees millions of objects and releases the memory to
+ * the system, which takes seconds: it must not be done by the request
+ * worker which happens to drop the last reference on it.
+ * At most max_size data wait for their destruction, if the queue is full
+ * the data is destroyed by the caller, so the memory does not pile up.
+ */
+template <typename Data>
+class DataReclaimer {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<const Data*> queue;
+    const size_t max_size;
+    const ReclaimObserver observe;
+    bool stopping = false;
+    std::thread thread;
+
+    void destroy(const Data* data) const {
+        const auto begin = std::chrono::steady_clock::now();
+        data_deleter(data);
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+        LOG4CPLUS_INFO(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger")),
+                       "data destroyed in " << duration.count() << "s");
+        if (observe) {
+            observe(duration.count());
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            condition.wait(lock, [&]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                // stopping and everything has been destroyed
+                return;
+            }
+            const Data* data = queue.front();
+            queue.pop_front();
+            lock.unlock();
+            destroy(data);
+            lock.lock();
+        }
+    }
+
+public:
+    explicit DataReclaimer(size_t max_size, ReclaimObserver observe = {})
+        : max_size(max_size), observe(std::move(observe)) {
+        thread = std::thread([this]() { run(); });
+    }
+    DataReclaimer(const DataReclaimer&) = delete;
+    DataReclaimer& operator=(const DataReclaimer&) = delete;
+
+    // the data still in the queue are destroyed before returning
+    ~DataReclaimer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_one();
+        thread.join();
+    }
+
+    void retire(const Data* data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() < max_size) {
+                queue.push_back(data);
+                condition.notify_one();
+                return;
+            }
+        }
+        LOG4CPLUS_WARN(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger")),
+                       "too many data waiting for their destruction, destroying it in the current thread");
+        destroy(data);
+    }
+};
+
 template <typename Data>
 class DataManager {
+    // if set, the data created from now on are destroyed by it, declared
+    // first since it is used to create current_data
+    std::shared_ptr<DataReclaimer<Data>> reclaimer;
+    // only accessed through boost::atomic_load/atomic_exchange, since it
+    // is swapped by the maintenance thread while the workers read it
     boost::shared_ptr<const Data> current_data;
+    // identifier of the last published data, given by set_data
     std::atomic_size_t data_identifier;
+    // incremented each time a new data is published by set_data
+    std::atomic_size_t generation;
 
 private:
-    boost::shared_ptr<Data> create_data(size_t id) { return boost::shared_ptr<Data>(new Data(id), data_deleter<Data>); }
+    // the deleter keeps the reclaimer alive as long as a data may be given to it
+    std::function<void(const Data*)> create_deleter() const {
+        auto reclaimer = this->reclaimer;
+        if (!reclaimer) {
+            return data_deleter<Data>;
+        }
+        return [reclaimer](const Data* data) { reclaimer->retire(data); };
+    }
 
-    boost::shared_ptr<const Data> create_ptr(const Data* d) {
-        return boost::shared_ptr<const Data>(d, data_deleter<Data>);
+    boost::shared_ptr<Data> create_data() { return create_ptr(new Data()); }
+
+    boost::shared_ptr<Data> create_ptr(Data* d) { return boost::shared_ptr<Data>(d, create_deleter()); }
+    static void run_stage(const std::string& name, const std::function<void()>& stage, const LoadStageObserver& observe) {
+        const auto begin = std::chrono::steady_clock::now();
+        stage();
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+        LOG4CPLUS_INFO(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger")),
+                       "load stage " << name << " done in " << duration.count() << "s");
+        if (observe) {
+            observe(name, duration.count());
+        }
     }
-    bool load_data_nav(boost::shared_ptr<Data>& data, const std::string& filename) {
+
+    // The stages are independent: each one runs in its own thread, the
+    // last one in the calling thread.  The first exception thrown by a
+    // stage is rethrown once they are all done.
+    static void run_stages_concurrently(const std::vector<std::pair<std::string, std::function<void()>>>& stages,
+                                        const LoadStageObserver& observe) {
+        std::vector<std::future<void>> futures;
+        for (size_t i = 0; i + 1 < stages.size(); ++i) {
+            futures.push_back(std::async(std::launch::async, [&, i]() {
+                run_stage(stages[i].first, stages[i].second, observe);
+            }));
+        }
+        std::exception_ptr error;
+        if (!stages.empty()) {
+            try {
+                run_stage(stages.back().first, stages.back().second, observe);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        for (auto& future : futures) {
+            try {
+                future.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    bool load_data_nav(boost::shared_ptr<Data>& data, const std::string& filename, const LoadStageObserver& observe) {
         try {
-            data->load_nav(filename);
+            run_stage("nav", [&]() { data->load_nav(filename); }, observe);
             return true;
         } catch (const navitia::data::data_loading_error&) {
             data->loading = false;
@@ -77,75 +234,156 @@ private:
     }
 
 public:
-    DataManager() : current_data(create_data(0)) { data_identifier = 0; }
+    /*
+     * Per thread view of the published data.
+     *
+     * It keeps a reference on the data and only goes back to the manager
+     * when a new data has been published, so a worker does not touch the
+     * shared reference count on each request.  The held data stays alive
+     * until the next call to get() or release_outdated() following a
+     * publication.
+     */
+    class Snapshot {
+        const DataManager& manager;
+        boost::shared_ptr<const Data> data;
+        size_t generation = 0;
+
+    public:
+        explicit Snapshot(const DataManager& manager) : manager(manager) {}
+
+        const boost::shared_ptr<const Data>& get() {
+            // the generation is read before the data: if a publication
+            // happens in between we get the new data with the old
+            // generation, and will only refresh once more next time
+            const auto current_generation = manager.generation.load(std::memory_order_acquire);
+            if (!data || current_generation != generation) {
+                data = manager.get_data();
+                generation = current_generation;
+            }
+            return data;
+        }
+
+        // drops the held data if another one has been published since, so
+        // that an idle worker does not keep it alive
+        void release_outdated() {
+            if (data && manager.generation.load(std::memory_order_acquire) != generation) {
+                data.reset();
+            }
+        }
+    };
+
+    DataManager() : current_data(create_data()) {
+        data_identifier = 0;
+        generation = 0;
+    }
+
+    /*
+     * From now on, the data created or given to the manager are destroyed
+     * by a dedicated thread, max_size of them waiting at most for their
+     * destruction.  Must be called before the data is shared with other
+     * threads.
+     */
+    void start_reclaimer(size_t max_size, const ReclaimObserver& observe = {}) {
+        reclaimer = std::make_shared<DataReclaimer<Data>>(max_size, observe);
+    }
 
-    void set_data(const Data* d) { set_data(create_ptr(d)); }
-    void set_data(boost::shared_ptr<const Data>&& data) {
+    void set_data(Data* d) { set_data(create_ptr(d)); }
+    void set_data(boost::shared_ptr<Data>&& data) {
         if (!data) {
             throw navitia::exception("Giving a null Data to DataManager::set_data");
         }
-        data->is_connected_to_rabbitmq = current_data->is_connected_to_rabbitmq.load();
-        current_data = std::move(data);
+        // given on publication, so that the identifiers grow in the order
+        // the data are published, whenever their build started
+        data->data_identifier = ++data_identifier;
+        data->is_connected_to_rabbitmq = get_data()->is_connected_to_rabbitmq.load();
+        // the previous data is released after the swap, here if no
+        // request nor snapshot holds it anymore
+        boost::atomic_exchange(&current_data, boost::shared_ptr<const Data>(std::move(data)));
+        generation.fetch_add(1, std::memory_order_release);
     }
-    boost::shared_ptr<const Data> get_data() const { return current_data; }
+    boost::shared_ptr<const Data> get_data() const { return boost::atomic_load(&current_data); }
+    Snapshot get_snapshot() const { return Snapshot(*this); }
     boost::shared_ptr<Data> get_data_clone() {
-        ++data_identifier;
-        auto data = create_data(data_identifier.load());
-        time_it("Clone data: ", [&]() { data->clone_from(*current_data); });
+        auto data = create_data();
+        const auto current = get_data();
+        time_it("Clone data: ", [&]() { data->clone_from(*current); });
         return std::move(data);
     }
 
     bool load(const std::string& filename,
               const boost::optional<std::string>& chaos_database = boost::none,
               const std::vector<std::string>& contributors = {},
-              const size_t raptor_cache_size = 10) {
+              const size_t raptor_cache_size = 10,
+              const LoadStageObserver& observe = {}) {
+        auto data = build_data(filename, chaos_database, contributors, raptor_cache_size, observe);
+        if (!data) {
+            return false;
+        }
+        set_data(std::move(data));
+        return true;
+    }
+
+    /*
+     * Loads and builds a new Data as load does, but without setting it.
+     * It can thus be called from another thread than the one setting the
+     * data.  Returns nullptr if the loading failed.
+     */
+    boost::shared_ptr<Data> build_data(const std::string& filename,
+                                       const boost::optional<std::string>& chaos_database = boost::none,
+                                       const std::vector<std::string>& contributors = {},
+                                       const size_t raptor_cache_size = 10,
+                                       const LoadStageObserver& observe = {}) {
         // Add logger
         log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
 
         // Create new type::Data
-        ++data_identifier;
-        auto data = create_data(data_identifier.load());
+        auto data = create_data();
         data->loading = true;
 
         // load .nav.lz4
-        if (!load_data_nav(data, filename)) {
+        if (!load_data_nav(data, filename, observe)) {
             if (data->last_load_succeeded) {
                 LOG4CPLUS_INFO(logger, "Data loading failed, we keep last loaded data");
             }
-            return false;
+            return nullptr;
         }
 
         // load disruptions from database
+        bool disruptions_loaded = false;
         if (chaos_database != boost::none) {
             // If we catch a bdd broken connection, we do nothing (Just a log),
             // because data is still clean, unlike other cases where we have
             // to reload the data
             try {
-                data->load_disruptions(*chaos_database, contributors);
-                data->build_autocomplete_partial();
+                run_stage("disruptions", [&]() { data->load_disruptions(*chaos_database, contributors); }, observe);
+                disruptions_loaded = true;
             } catch (const navitia::data::disruptions_broken_connection&) {
                 LOG4CPLUS_WARN(logger, "Load data without disruptions");
             } catch (const navitia::data::disruptions_loading_error&) {
                 // Reload data .nav.lz4
                 LOG4CPLUS_ERROR(logger, "Reload data without disruptions: " << filename);
-                data = create_data(data_identifier.load());
-                if (!load_data_nav(data, filename)) {
+                data = create_data();
+                if (!load_data_nav(data, filename, observe)) {
                     LOG4CPLUS_ERROR(logger, "Reload data without disruptions failed...");
-                    return false;
+                    return nullptr;
                 }
             }
         }
 
-        // Build Raptor Data
-        data->build_raptor(raptor_cache_size);
-        data->build_relations();
-        // Build proximity list NN index
-        data->build_proximity_list();
+        // The raptor data, the relations, the proximity lists NN indexes
+        // and the autocomplete each read the loaded data and write their
+        // own structures, thus they are built concurrently
+        std::vector<std::pair<std::string, std::function<void()>>> stages = {
+            {"raptor", [&]() { data->build_raptor(raptor_cache_size); }},
+            {"relations", [&]() { data->build_relations(); }},
+            {"proximity_list", [&]() { data->build_proximity_list(); }},
+        };
+        if (disruptions_loaded) {
+            stages.emplace_back("autocomplete", [&]() { data->build_autocomplete_partial(); });
+        }
+        run_stages_concurrently(stages, observe);
         data->loading = false;
 
-        // Set data
-        set_data(std::move(data));
-
-        return true;
+        return data;
     }
 };
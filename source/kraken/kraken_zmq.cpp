@@ -126,6 +126,11 @@ int main(int argn, char** argv) {
 
     const navitia::Metrics metrics(conf.metrics_binding(), conf.instance_name());
 
+    if (conf.data_reclaim_queue_size() > 0) {
+        data_manager.start_reclaimer(conf.data_reclaim_queue_size(),
+                                     [&metrics](double duration) { metrics.observe_data_reclaim(duration); });
+    }
+
     threads.create_thread(navitia::MaintenanceWorker(data_manager, conf, metrics));
     //
     // Data have been loaded, we can now accept connections
@@ -138,12 +143,18 @@ int main(int argn, char** argv) {
         return 1;
     }
 
+    // shared by all the workers
+    std::unique_ptr<navitia::routing::JourneyCache> journey_cache;
+    if (conf.journey_cache_size() > 0) {
+        journey_cache = std::make_unique<navitia::routing::JourneyCache>(conf.journey_cache_size());
+    }
+
     int nb_threads = conf.nb_threads();
     // Launch pool of worker threads
     LOG4CPLUS_INFO(logger, "starting workers threads");
     for (int thread_nbr = 0; thread_nbr < nb_threads; ++thread_nbr) {
-        threads.create_thread([&context, &data_manager, conf, &metrics, thread_nbr] {
-            return doWork(context, data_manager, conf, metrics, thread_nbr);
+        threads.create_thread([&context, &data_manager, conf, &metrics, thread_nbr, &journey_cache] {
+            return doWork(context, data_manager, conf, metrics, thread_nbr, journey_cache.get());
         });
     }
 
@@ -39,10 +39,13 @@ www.navitia.io
 #include "metrics.h"
 #include "utils/deadline.h"
 #include "type/datetime.h"
+#include "routing/dataraptor.h"
+#include "routing/journey_cache.h"
 
 #include <log4cplus/ndc.h>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/optional/optional_io.hpp>
+#include <cerrno>
 
 static void respond(zmq::socket_t& socket, const std::string& address, const pbnavitia::Response& response) {
     zmq::message_t reply(response.ByteSize());
@@ -63,11 +66,16 @@ static void respond(zmq::socket_t& socket, const std::string& address, const pbn
 }
 
 namespace pt = boost::posix_time;
+
+// an idle worker checks this often whether its data has been replaced
+const long idle_worker_poll_ms = 1000;
+
 inline void doWork(zmq::context_t& context,
                    DataManager<navitia::type::Data>& data_manager,
                    navitia::kraken::Configuration conf,
                    const navitia::Metrics& metrics,
-                   int worker_id) {
+                   int worker_id,
+                   navitia::routing::JourneyCache* journey_cache = nullptr) {
     auto logger = log4cplus::Logger::getInstance("worker");
 
     zmq::socket_t socket(context, ZMQ_REQ);
@@ -75,10 +83,25 @@ inline void doWork(zmq::context_t& context,
     bool run = true;
     auto enable_deadline = conf.enable_request_deadline();
     // Here we create the worker
-    navitia::Worker w(conf);
+    navitia::Worker w(conf, journey_cache);
+    auto data_snapshot = data_manager.get_snapshot();
     z_send(socket, "READY");
     auto slow_request_duration = pt::milliseconds(conf.slow_request_duration());
+    zmq::pollitem_t poll_item{static_cast<void*>(socket), 0, ZMQ_POLLIN, 0};
     while (run) {
+        // while waiting for a request, the replaced data is released
+        try {
+            if (zmq::poll(&poll_item, 1, idle_worker_poll_ms) == 0) {
+                data_snapshot.release_outdated();
+                continue;
+            }
+        } catch (const zmq::error_t& e) {
+            // interrupted by a signal, anything else (the context terminated) stops the worker
+            if (e.num() == EINTR) {
+                continue;
+            }
+            throw;
+        }
         const std::string address = z_recv(socket);
         {
             std::string empty = z_recv(socket);
@@ -125,7 +148,7 @@ inline void doWork(zmq::context_t& context,
         }
 
         LOG4CPLUS_DEBUG(logger, "deadline set to " << deadline.get());
-        const auto data = data_manager.get_data();
+        const auto& data = data_snapshot.get();
         try {
             deadline.check();
             w.dispatch(pb_req, *data);
@@ -152,6 +175,16 @@ inline void doWork(zmq::context_t& context,
         auto end = pt::microsec_clock::universal_time();
         auto duration = end - start;
         metrics.observe_api(api, duration.total_milliseconds() / 1000.0);
+        if (data->dataRaptor && data->dataRaptor->cached_next_st_manager) {
+            auto& cache_manager = *data->dataRaptor->cached_next_st_manager;
+            metrics.set_raptor_cache_memory(cache_manager.cache_memory_size());
+            const auto cache_report = cache_manager.take_report();
+            metrics.add_raptor_cache_calls(cache_report.nb_hits, cache_report.nb_misses, cache_report.build_duration);
+        }
+        if (journey_cache) {
+            const auto journey_cache_report = journey_cache->take_report();
+            metrics.add_journey_cache_calls(journey_cache_report.nb_hits, journey_cache_report.nb_misses);
+        }
         if (duration >= slow_request_duration) {
             LOG4CPLUS_WARN(logger, "slow request! duration: " << duration.total_milliseconds()
                                                               << "ms request: " << pb_req.DebugString());
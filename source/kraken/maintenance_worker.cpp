@@ -34,6 +34,8 @@ www.navitia.io
 #include "make_disruption_from_chaos.h"
 #include "metrics.h"
 #include "realtime.h"
+#include "routing/dataraptor.h"
+#include "type/meta_data.h"
 #include "type/pt_data.h"
 #include "type/task.pb.h"
 #include "type/kirin.pb.h"
@@ -46,6 +48,7 @@ www.navitia.io
 
 #include <chrono>
 #include <csignal>
+#include <functional>
 #include <sys/stat.h>
 #include <thread>
 #include <utility>
@@ -56,19 +59,101 @@ namespace bg = boost::gregorian;
 
 namespace navitia {
 
-void MaintenanceWorker::load_data() {
+boost::shared_ptr<nt::Data> MaintenanceWorker::build_data() const {
     const std::string database = conf.databases_path();
     auto chaos_database = conf.chaos_database();
     auto contributors = conf.rt_topics();
     LOG4CPLUS_INFO(logger, "Loading database from file: " + database);
     auto start = pt::microsec_clock::universal_time();
-    if (this->data_manager.load(database, chaos_database, contributors, conf.raptor_cache_size())) {
-        auto data = data_manager.get_data();
+    auto observe_stage = [&](const std::string& stage, double duration) {
+        this->metrics.observe_data_loading_stage(stage, duration);
+    };
+    auto data =
+        this->data_manager.build_data(database, chaos_database, contributors, conf.raptor_cache_size(), observe_stage);
+    if (data) {
         data->is_realtime_loaded = false;
         data->meta->instance_name = conf.instance_name();
     }
     auto duration = pt::microsec_clock::universal_time() - start;
     this->metrics.observe_data_loading(duration.total_seconds());
+    return data;
+}
+
+void MaintenanceWorker::load_data() {
+    auto data = build_data();
+    if (data) {
+        data_manager.set_data(std::move(data));
+    }
+}
+
+void MaintenanceWorker::start_background_reload() {
+    if (background_reload.valid()) {
+        LOG4CPLUS_INFO(logger, "data already being reloaded, the reload will be done again afterwards");
+        reload_requested = true;
+        return;
+    }
+    if (conf.reload_journal_size() == 0) {
+        this->load_data();
+        this->load_realtime();
+        return;
+    }
+    LOG4CPLUS_INFO(logger, "reloading data in background");
+    reload_journal.clear();
+    reload_journal_nb_messages = 0;
+    reload_journal_overflowed = false;
+    background_reload = std::async(std::launch::async, [this]() { return this->build_data(); });
+}
+
+void MaintenanceWorker::finish_background_reload() {
+    if (!background_reload.valid()
+        || background_reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    boost::shared_ptr<nt::Data> data;
+    try {
+        data = background_reload.get();
+    } catch (const std::exception& e) {
+        LOG4CPLUS_ERROR(logger, "background reload of data failed: " << e.what());
+    }
+    const auto journal = std::move(reload_journal);
+    reload_journal.clear();
+    const auto nb_messages = reload_journal_nb_messages;
+    reload_journal_nb_messages = 0;
+
+    if (reload_journal_overflowed) {
+        reload_journal_overflowed = false;
+        LOG4CPLUS_WARN(logger, "too many realtime messages received during the background reload, "
+                                   << "reloading data without applying realtime meanwhile");
+        this->load_data();
+        this->load_realtime();
+    } else if (data) {
+        LOG4CPLUS_INFO(logger, "replaying " << nb_messages << " realtime messages in " << journal.size()
+                                             << " batches on the reloaded data");
+        bool autocomplete_rebuilding_activated = false;
+        bool replayed = false;
+        for (const auto& envelopes : journal) {
+            // an invalid batch is rejected before any change on data, the next ones can be replayed
+            bool batch_autocomplete_rebuilding_activated = false;
+            if (!apply_rt_in_batch(envelopes, data, batch_autocomplete_rebuilding_activated)) {
+                LOG4CPLUS_WARN(logger, "skipping a batch of " << envelopes.size() << " realtime messages");
+                continue;
+            }
+            autocomplete_rebuilding_activated |= batch_autocomplete_rebuilding_activated;
+            replayed = true;
+        }
+        if (replayed) {
+            // the proximity lists of the new data are already built, and realtime doesn't move stop points
+            rebuild_after_rt(*data, autocomplete_rebuilding_activated, nullptr);
+            data->set_last_rt_data_loaded(pt::microsec_clock::universal_time());
+        }
+        data_manager.set_data(std::move(data));
+        this->load_realtime();
+    }
+
+    if (reload_requested) {
+        reload_requested = false;
+        start_background_reload();
+    }
 }
 
 void MaintenanceWorker::load_realtime() {
@@ -118,6 +203,51 @@ void MaintenanceWorker::load_realtime() {
     channel->DeleteQueue(queue_name);
 }
 
+void MaintenanceWorker::prefetch_raptor_cache() {
+    const size_t nb_threads = conf.raptor_cache_prefetch_threads();
+    if (nb_threads == 0) {
+        return;
+    }
+    if (raptor_cache_prefetching.valid()
+        && raptor_cache_prefetching.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    auto data = data_manager.get_data();
+    const auto today = pt::second_clock::universal_time().date();
+    if (data == prefetched_data.lock() && today == prefetched_date) {
+        return;
+    }
+    prefetched_data = data;
+    prefetched_date = today;
+    if (!data->loaded || !data->dataRaptor || !data->dataRaptor->cached_next_st_manager) {
+        return;
+    }
+    const auto& production_date = data->meta->production_date;
+    if (!production_date.contains(today) && !production_date.contains(today + bg::days(1))) {
+        return;
+    }
+    // today may be the day before the production period, tomorrow being its first day
+    const auto day = (today - production_date.begin()).days();
+    std::vector<routing::CachedNextStopTimeKey> keys;
+    for (const auto& key : routing::CachedNextStopTimeManager::prefetch_keys(day < 0 ? 0 : day)) {
+        if (production_date.contains(production_date.begin() + bg::days(key.from))) {
+            keys.push_back(key);
+        }
+    }
+    auto logger = this->logger;
+    auto prefetch = [data, keys, nb_threads, logger]() {
+        auto start = pt::microsec_clock::universal_time();
+        try {
+            auto nb_built = data->dataRaptor->cached_next_st_manager->prefetch(keys, nb_threads);
+            auto duration = pt::microsec_clock::universal_time() - start;
+            LOG4CPLUS_INFO(logger, nb_built << " raptor caches prefetched in " << duration);
+        } catch (const std::exception& e) {
+            LOG4CPLUS_ERROR(logger, "prefetching of raptor caches failed: " << e.what());
+        }
+    };
+    raptor_cache_prefetching = std::async(std::launch::async, prefetch).share();
+}
+
 void MaintenanceWorker::operator()() {
     LOG4CPLUS_INFO(logger, "Starting background thread");
 
@@ -129,6 +259,7 @@ void MaintenanceWorker::operator()() {
         sleep(10);
     }
     while (true) {
+        this->prefetch_raptor_cache();
         try {
             this->init_rabbitmq();
             this->listen_rabbitmq();
@@ -151,8 +282,7 @@ void MaintenanceWorker::handle_task_in_batch(const std::vector<AmqpClient::Envel
         }
         switch (task.action()) {
             case pbnavitia::RELOAD:
-                this->load_data();
-                this->load_realtime();
+                this->start_background_reload();
                 // For now, we have only one type of task: reload_kraken. We don't want that this command
                 // is executed several times in stride for nothing.
                 return;
@@ -170,58 +300,115 @@ static bool autocomplete_rebuilding_needed(const transit_realtime::FeedEntity& e
                 == transit_realtime::Alert_Effect::Alert_Effect_MODIFIED_SERVICE));
 }
 
-void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes) {
-    boost::shared_ptr<nt::Data> data{};
-    pt::ptime begin = pt::microsec_clock::universal_time();
-    bool autocomplete_rebuilding_activated = false;
-    for (auto& envelope : envelopes) {
+bool MaintenanceWorker::apply_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes,
+                                          boost::shared_ptr<nt::Data>& data,
+                                          bool& autocomplete_rebuilding_activated) {
+    std::vector<transit_realtime::FeedMessage> feed_messages(envelopes.size());
+    size_t nb_entities = 0;
+    for (size_t i = 0; i < envelopes.size(); ++i) {
+        const auto& envelope = envelopes[i];
+        assert(envelope);
         const auto routing_key = envelope->RoutingKey();
         LOG4CPLUS_DEBUG(logger, "realtime info received from " << routing_key);
-        assert(envelope);
-        transit_realtime::FeedMessage feed_message;
-        if (!feed_message.ParseFromString(envelope->Message()->Body())) {
+        if (!feed_messages[i].ParseFromString(envelope->Message()->Body())) {
             LOG4CPLUS_WARN(logger, "protobuf not valid!");
-            return;
+            return false;
         }
-        LOG4CPLUS_TRACE(logger, "received entity: " << feed_message.DebugString());
-        for (const auto& entity : feed_message.entity()) {
-            if (!data) {
-                pt::ptime copy_begin = pt::microsec_clock::universal_time();
-                data = data_manager.get_data_clone();
-                auto duration = pt::microsec_clock::universal_time() - copy_begin;
-                this->metrics.observe_data_cloning(duration.total_seconds());
-                LOG4CPLUS_INFO(logger, "data copied in " << duration);
-            }
-            if (entity.is_deleted()) {
-                LOG4CPLUS_DEBUG(logger, "deletion of disruption " << entity.id());
-                delete_disruption(entity.id(), *data->pt_data, *data->meta);
-            } else if (entity.HasExtension(chaos::disruption)) {
-                LOG4CPLUS_DEBUG(logger, "add/update of disruption " << entity.id());
-                make_and_apply_disruption(entity.GetExtension(chaos::disruption), *data->pt_data, *data->meta);
-            } else if (entity.has_trip_update()) {
-                LOG4CPLUS_DEBUG(logger, "RT trip update" << entity.id());
-                handle_realtime(entity.id(), navitia::from_posix_timestamp(feed_message.header().timestamp()),
-                                entity.trip_update(), *data, conf.is_realtime_add_enabled(),
-                                conf.is_realtime_add_trip_enabled());
-                autocomplete_rebuilding_activated = autocomplete_rebuilding_needed(entity);
-            } else {
-                LOG4CPLUS_WARN(logger, "unsupported gtfs rt feed");
-            }
+        LOG4CPLUS_TRACE(logger, "received entity: " << feed_messages[i].DebugString());
+        nb_entities += feed_messages[i].entity_size();
+    }
+    if (nb_entities == 0) {
+        return true;
+    }
+
+    // only the last state of each disruption of the batch is applied, the
+    // data being cloned, the current data can be used to coalesce them
+    const auto current_data = data_manager.get_data();
+    const auto entities = coalesce_entities(feed_messages, data ? *data : *current_data,
+                                            conf.is_realtime_add_enabled(), conf.is_realtime_add_trip_enabled());
+    if (entities.size() < nb_entities) {
+        LOG4CPLUS_DEBUG(logger, nb_entities - entities.size() << " realtime entities replaced in the same batch");
+        this->metrics.add_coalesced_rt_entities(nb_entities - entities.size());
+    }
+
+    for (const auto& rt_entity : entities) {
+        const auto& entity = *rt_entity.entity;
+        if (!data) {
+            pt::ptime copy_begin = pt::microsec_clock::universal_time();
+            data = data_manager.get_data_clone();
+            auto duration = pt::microsec_clock::universal_time() - copy_begin;
+            this->metrics.observe_data_cloning(duration.total_seconds());
+            LOG4CPLUS_INFO(logger, "data copied in " << duration);
+        }
+        if (entity.is_deleted()) {
+            LOG4CPLUS_DEBUG(logger, "deletion of disruption " << entity.id());
+            delete_disruption(entity.id(), *data->pt_data, *data->meta);
+        } else if (entity.HasExtension(chaos::disruption)) {
+            LOG4CPLUS_DEBUG(logger, "add/update of disruption " << entity.id());
+            make_and_apply_disruption(entity.GetExtension(chaos::disruption), *data->pt_data, *data->meta);
+        } else if (entity.has_trip_update()) {
+            LOG4CPLUS_DEBUG(logger, "RT trip update" << entity.id());
+            handle_realtime(entity.id(), navitia::from_posix_timestamp(rt_entity.feed_message->header().timestamp()),
+                            entity.trip_update(), *data, conf.is_realtime_add_enabled(),
+                            conf.is_realtime_add_trip_enabled());
+            autocomplete_rebuilding_activated = autocomplete_rebuilding_needed(entity);
+        } else {
+            LOG4CPLUS_WARN(logger, "unsupported gtfs rt feed");
         }
     }
-    if (data) {
-        LOG4CPLUS_INFO(logger, "rebuilding relations");
-        data->build_relations();
-        if (autocomplete_rebuilding_activated) {
-            LOG4CPLUS_INFO(logger, "rebuilding autocomplete");
-            data->build_autocomplete_partial();
+    return true;
+}
+
+void MaintenanceWorker::rebuild_after_rt(nt::Data& data,
+                                         bool autocomplete_rebuilding_activated,
+                                         const nt::Data* previous) {
+    auto timed = [&](const std::string& step, const std::function<void()>& fun) {
+        const auto step_begin = pt::microsec_clock::universal_time();
+        fun();
+        const auto step_duration = pt::microsec_clock::universal_time() - step_begin;
+        this->metrics.observe_handle_rt_step(step, step_duration.total_microseconds() / 1e6);
+        LOG4CPLUS_DEBUG(logger, step << " rebuilt in " << step_duration);
+    };
+    LOG4CPLUS_INFO(logger, "rebuilding relations");
+    timed("relations", [&]() { data.build_relations(data.pt_data->modified_meta_vjs); });
+    if (autocomplete_rebuilding_activated) {
+        LOG4CPLUS_INFO(logger, "rebuilding autocomplete");
+        timed("autocomplete", [&]() { data.build_autocomplete_partial(); });
+    }
+    LOG4CPLUS_INFO(logger, "cleaning weak impacts");
+    timed("weak_impacts", [&]() { data.pt_data->clean_weak_impacts(); });
+    LOG4CPLUS_INFO(logger, "rebuilding data raptor");
+    // if data has been cloned from previous, only the modified vjs are rebuilt
+    timed("raptor", [&]() { data.build_raptor(conf.raptor_cache_size(), previous); });
+    if (previous) {
+        timed("proximity_list", [&]() { data.build_proximity_list(); });
+        timed("warmup", [&]() { data.warmup(*previous); });
+    }
+}
+
+void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes) {
+    if (background_reload.valid() && !envelopes.empty() && !reload_journal_overflowed) {
+        // the messages are kept to be replayed on the data being reloaded
+        if (reload_journal_nb_messages + envelopes.size() > conf.reload_journal_size()) {
+            LOG4CPLUS_WARN(logger, "realtime journal of the background reload is full");
+            reload_journal_overflowed = true;
+            reload_journal.clear();
+            reload_journal_nb_messages = 0;
+        } else {
+            reload_journal.push_back(envelopes);
+            reload_journal_nb_messages += envelopes.size();
         }
-        LOG4CPLUS_INFO(logger, "cleaning weak impacts");
-        data->pt_data->clean_weak_impacts();
-        LOG4CPLUS_INFO(logger, "rebuilding data raptor");
-        data->build_raptor(conf.raptor_cache_size());
-        data->build_proximity_list();
-        data->warmup(*data_manager.get_data());
+    }
+
+    boost::shared_ptr<nt::Data> data{};
+    pt::ptime begin = pt::microsec_clock::universal_time();
+    bool autocomplete_rebuilding_activated = false;
+    if (!apply_rt_in_batch(envelopes, data, autocomplete_rebuilding_activated)) {
+        return;
+    }
+    if (data) {
+        const auto current_data = data_manager.get_data();
+        rebuild_after_rt(*data, autocomplete_rebuilding_activated, current_data.get());
         data->set_last_rt_data_loaded(pt::microsec_clock::universal_time());
         data_manager.set_data(std::move(data));
         auto duration = pt::microsec_clock::universal_time() - begin;
@@ -283,6 +470,8 @@ void MaintenanceWorker::listen_rabbitmq() {
     data_manager.get_data()->is_connected_to_rabbitmq = true;
     while (true) {
         boost::this_thread::interruption_point();
+        this->prefetch_raptor_cache();
+        this->finish_background_reload();
         auto now = pt::microsec_clock::universal_time();
         // We don't want to try to load realtime data every second
         if (now > this->next_try_realtime_loading) {
@@ -36,7 +36,9 @@ www.navitia.io
 
 #include <SimpleAmqpClient/SimpleAmqpClient.h>
 
+#include <future>
 #include <memory>
+#include <vector>
 
 namespace navitia {
 
@@ -57,14 +59,73 @@ private:
 
     boost::posix_time::ptime next_try_realtime_loading;
 
+    // background building of the raptor caches, see prefetch_raptor_cache()
+    std::shared_future<void> raptor_cache_prefetching;
+    boost::weak_ptr<const type::Data> prefetched_data;
+    boost::gregorian::date prefetched_date;
+
+    // background reload of the data, see start_background_reload()
+    std::future<boost::shared_ptr<type::Data>> background_reload;
+    // realtime batches received during the background reload, replayed one by one on the new data
+    std::vector<std::vector<AmqpClient::Envelope::ptr_t>> reload_journal;
+    size_t reload_journal_nb_messages = 0;
+    bool reload_journal_overflowed = false;
+    // a reload has been asked during the background one
+    bool reload_requested = false;
+
     void init_rabbitmq();
     void listen_rabbitmq();
 
     void handle_task_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes);
     void handle_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes);
 
+    /*!
+     * Applies the realtime messages on data, that is cloned from the
+     * current data at the first message to apply if it is null.  Returns
+     * false if a message is not valid, the data must then be dropped.
+     * */
+    bool apply_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes,
+                           boost::shared_ptr<type::Data>& data,
+                           bool& autocomplete_rebuilding_activated);
+
+    /*!
+     * Rebuilds the relations, the autocomplete and the raptor data of
+     * data after realtime has been applied on it.  previous is the data
+     * it has been cloned from, or nullptr if it is a newly loaded data.
+     * */
+    void rebuild_after_rt(type::Data& data, bool autocomplete_rebuilding_activated, const type::Data* previous);
+
+    /// Loads and builds a new data, can be called from any thread
+    boost::shared_ptr<type::Data> build_data() const;
+
+    /*!
+     * Reloads the data in another thread, the realtime being still applied
+     * on the current data meanwhile.  The realtime messages received during
+     * the reload are kept in a journal, bounded by the reload_journal_size
+     * parameter, to be replayed on the new data by finish_background_reload.
+     * */
+    void start_background_reload();
+
+    /*!
+     * If the background reload is done, replays the journal on the new
+     * data and sets it.  The batches are replayed as they were received,
+     * an invalid one being skipped like it was on the current data.  If
+     * the journal has overflowed, the data is reloaded again, without
+     * applying realtime meanwhile.
+     * */
+    void finish_background_reload();
+
     void load_realtime();
 
+    /*!
+     * Builds in background the raptor caches most likely to be used
+     * today and tomorrow, so that the first requests don't have to
+     * build them.  Nothing is done if the current data and day have
+     * already been prefetched, or if a prefetching is still running (it
+     * will then be done at a next call).
+     * */
+    void prefetch_raptor_cache();
+
     /*!
      * This function will consume message in batch. It calls
      * AmqpClient::Channel::BasicConsumeMessage(const std::string&, Envelope::ptr_t&, int) to try
@@ -115,6 +115,16 @@ Metrics::Metrics(const boost::optional<std::string>& endpoint, const std::string
                                         .Register(*registry)
                                         .Add({}, create_exponential_buckets(1, 2, 10));
 
+    auto& data_loading_stage_family = prometheus::BuildHistogram()
+                                          .Name("kraken_data_loading_stage_duration_seconds")
+                                          .Help("duration of each stage of the data loading")
+                                          .Labels({{"coverage", coverage}})
+                                          .Register(*registry);
+    for (const auto* stage : {"nav", "disruptions", "raptor", "relations", "proximity_list", "autocomplete"}) {
+        this->data_loading_stage_histograms[stage] =
+            &data_loading_stage_family.Add({{"stage", stage}}, create_exponential_buckets(0.1, 2, 10));
+    }
+
     this->data_cloning_histogram = &prometheus::BuildHistogram()
                                         .Name("kraken_data_cloning_duration_seconds")
                                         .Help("duration of cloning data")
@@ -122,12 +132,80 @@ Metrics::Metrics(const boost::optional<std::string>& endpoint, const std::string
                                         .Register(*registry)
                                         .Add({}, create_exponential_buckets(1, 2, 10));
 
+    this->data_reclaim_histogram = &prometheus::BuildHistogram()
+                                        .Name("kraken_data_reclaim_duration_seconds")
+                                        .Help("duration of the destruction of a replaced data")
+                                        .Labels({{"coverage", coverage}})
+                                        .Register(*registry)
+                                        .Add({}, create_exponential_buckets(0.1, 2, 10));
+
     this->handle_rt_histogram = &prometheus::BuildHistogram()
                                      .Name("kraken_handle_rt_duration_seconds")
                                      .Help("duration for handling disruptions and realtime")
                                      .Labels({{"coverage", coverage}})
                                      .Register(*registry)
                                      .Add({}, create_exponential_buckets(1, 2, 10));
+
+    auto& handle_rt_step_family = prometheus::BuildHistogram()
+                                      .Name("kraken_handle_rt_step_duration_seconds")
+                                      .Help("duration of each step rebuilding the data after realtime")
+                                      .Labels({{"coverage", coverage}})
+                                      .Register(*registry);
+    for (const auto* step : {"relations", "autocomplete", "weak_impacts", "raptor", "proximity_list", "warmup"}) {
+        this->handle_rt_step_histograms[step] =
+            &handle_rt_step_family.Add({{"step", step}}, create_fixed_duration_buckets());
+    }
+
+    this->raptor_cache_memory_gauge = &prometheus::BuildGauge()
+                                           .Name("kraken_raptor_cache_day_memory_bytes")
+                                           .Help("memory used by a day of the raptor next stop times cache")
+                                           .Labels({{"coverage", coverage}})
+                                           .Register(*registry)
+                                           .Add({});
+
+    this->raptor_cache_hits_counter = &prometheus::BuildCounter()
+                                           .Name("kraken_raptor_cache_hits_total")
+                                           .Help("number of raptor queries finding their next stop times cache built")
+                                           .Labels({{"coverage", coverage}})
+                                           .Register(*registry)
+                                           .Add({});
+
+    this->raptor_cache_misses_counter = &prometheus::BuildCounter()
+                                             .Name("kraken_raptor_cache_misses_total")
+                                             .Help("number of raptor queries building their next stop times cache")
+                                             .Labels({{"coverage", coverage}})
+                                             .Register(*registry)
+                                             .Add({});
+
+    this->raptor_cache_build_duration_counter =
+        &prometheus::BuildCounter()
+             .Name("kraken_raptor_cache_build_duration_seconds_total")
+             .Help("time spent building raptor next stop times caches, prefetching included")
+             .Labels({{"coverage", coverage}})
+             .Register(*registry)
+             .Add({});
+
+    this->journey_cache_hits_counter = &prometheus::BuildCounter()
+                                            .Name("kraken_journey_cache_hits_total")
+                                            .Help("number of raptor computations answered by the journey cache")
+                                            .Labels({{"coverage", coverage}})
+                                            .Register(*registry)
+                                            .Add({});
+
+    this->journey_cache_misses_counter = &prometheus::BuildCounter()
+                                              .Name("kraken_journey_cache_misses_total")
+                                              .Help("number of raptor computations not found in the journey cache")
+                                              .Labels({{"coverage", coverage}})
+                                              .Register(*registry)
+                                              .Add({});
+
+    this->coalesced_rt_entities_counter = &prometheus::BuildCounter()
+                                               .Name("kraken_rt_coalesced_entities_total")
+                                               .Help("number of realtime entities not applied because a later entity "
+                                                     "of the same batch replaces them")
+                                               .Labels({{"coverage", coverage}})
+                                               .Register(*registry)
+                                               .Add({});
 }
 
 InFlightGuard Metrics::start_in_flight() const {
@@ -157,6 +235,16 @@ void Metrics::observe_data_loading(double duration) const {
     this->data_loading_histogram->Observe(duration);
 }
 
+void Metrics::observe_data_loading_stage(const std::string& stage, double duration) const {
+    if (!registry) {
+        return;
+    }
+    auto it = this->data_loading_stage_histograms.find(stage);
+    if (it != this->data_loading_stage_histograms.end()) {
+        it->second->Observe(duration);
+    }
+}
+
 void Metrics::observe_data_cloning(double duration) const {
     if (!registry) {
         return;
@@ -164,6 +252,13 @@ void Metrics::observe_data_cloning(double duration) const {
     this->data_cloning_histogram->Observe(duration);
 }
 
+void Metrics::observe_data_reclaim(double duration) const {
+    if (!registry) {
+        return;
+    }
+    this->data_reclaim_histogram->Observe(duration);
+}
+
 void Metrics::observe_handle_rt(double duration) const {
     if (!registry) {
         return;
@@ -171,4 +266,45 @@ void Metrics::observe_handle_rt(double duration) const {
     this->handle_rt_histogram->Observe(duration);
 }
 
+void Metrics::observe_handle_rt_step(const std::string& step, double duration) const {
+    if (!registry) {
+        return;
+    }
+    auto it = this->handle_rt_step_histograms.find(step);
+    if (it != this->handle_rt_step_histograms.end()) {
+        it->second->Observe(duration);
+    }
+}
+
+void Metrics::set_raptor_cache_memory(size_t nb_bytes) const {
+    if (!registry) {
+        return;
+    }
+    this->raptor_cache_memory_gauge->Set(nb_bytes);
+}
+
+void Metrics::add_raptor_cache_calls(size_t nb_hits, size_t nb_misses, double build_duration) const {
+    if (!registry) {
+        return;
+    }
+    this->raptor_cache_hits_counter->Increment(nb_hits);
+    this->raptor_cache_misses_counter->Increment(nb_misses);
+    this->raptor_cache_build_duration_counter->Increment(build_duration);
+}
+
+void Metrics::add_journey_cache_calls(size_t nb_hits, size_t nb_misses) const {
+    if (!registry) {
+        return;
+    }
+    this->journey_cache_hits_counter->Increment(nb_hits);
+    this->journey_cache_misses_counter->Increment(nb_misses);
+}
+
+void Metrics::add_coalesced_rt_entities(size_t nb) const {
+    if (!registry) {
+        return;
+    }
+    this->coalesced_rt_entities_counter->Increment(nb);
+}
+
 }  // namespace navitia
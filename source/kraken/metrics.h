@@ -40,6 +40,7 @@ www.navitia.io
 
 #include <memory>
 #include <map>
+#include <string>
 
 // forward declare
 namespace prometheus {
@@ -69,8 +70,18 @@ protected:
     std::map<pbnavitia::API, prometheus::Histogram*> request_histogram;
     prometheus::Gauge* in_flight;
     prometheus::Histogram* data_loading_histogram;
+    std::map<std::string, prometheus::Histogram*> data_loading_stage_histograms;
     prometheus::Histogram* data_cloning_histogram;
+    prometheus::Histogram* data_reclaim_histogram;
     prometheus::Histogram* handle_rt_histogram;
+    std::map<std::string, prometheus::Histogram*> handle_rt_step_histograms;
+    prometheus::Gauge* raptor_cache_memory_gauge;
+    prometheus::Counter* raptor_cache_hits_counter;
+    prometheus::Counter* raptor_cache_misses_counter;
+    prometheus::Counter* raptor_cache_build_duration_counter;
+    prometheus::Counter* journey_cache_hits_counter;
+    prometheus::Counter* journey_cache_misses_counter;
+    prometheus::Counter* coalesced_rt_entities_counter;
 
 public:
     Metrics(const boost::optional<std::string>& endpoint, const std::string& coverage);
@@ -78,8 +89,15 @@ public:
     InFlightGuard start_in_flight() const;
 
     void observe_data_loading(double duration) const;
+    void observe_data_loading_stage(const std::string& stage, double duration) const;
     void observe_data_cloning(double duration) const;
+    void observe_data_reclaim(double duration) const;
     void observe_handle_rt(double duration) const;
+    void observe_handle_rt_step(const std::string& step, double duration) const;
+    void set_raptor_cache_memory(size_t nb_bytes) const;
+    void add_raptor_cache_calls(size_t nb_hits, size_t nb_misses, double build_duration) const;
+    void add_journey_cache_calls(size_t nb_hits, size_t nb_misses) const;
+    void add_coalesced_rt_entities(size_t nb) const;
 };
 
 }  // namespace navitia
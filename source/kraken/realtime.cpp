@@ -30,6 +30,7 @@ www.navitia.io
 #include "realtime.h"
 
 #include "kraken/apply_disruption.h"
+#include "type/chaos.pb.h"
 #include "type/data.h"
 #include "type/datetime.h"
 #include "type/kirin.pb.h"
@@ -43,16 +44,19 @@ www.navitia.io
 #include <boost/make_shared.hpp>
 #include <boost/optional.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <set>
 
 namespace navitia {
 
 namespace nd = type::disruption;
 namespace nt = navitia::type;
 
+// the meta vj of the trip must exist
 static bool base_vj_exists_the_same_day(const type::Data& data, const transit_realtime::TripUpdate& trip_update) {
-    const auto& mvj = *data.pt_data->get_or_create_meta_vehicle_journey(trip_update.trip().trip_id(),
-                                                                        data.pt_data->get_main_timezone());
+    const auto& mvj = *data.pt_data->meta_vjs[trip_update.trip().trip_id()];
     return mvj.get_base_vj_circulating_at_date(
         boost::gregorian::from_undelimited_string(trip_update.trip().start_date()));
 }
@@ -607,19 +611,16 @@ static const type::disruption::Disruption* create_disruption(const std::string&
     return &disruption;
 }
 
-void handle_realtime(const std::string& id,
-                     const boost::posix_time::ptime& timestamp,
-                     const transit_realtime::TripUpdate& trip_update,
-                     const type::Data& data,
-                     const bool is_realtime_add_enabled,
-                     const bool is_realtime_add_trip_enabled) {
+bool is_applicable(const transit_realtime::TripUpdate& trip_update,
+                   const type::Data& data,
+                   const bool is_realtime_add_enabled,
+                   const bool is_realtime_add_trip_enabled) {
     auto log = log4cplus::Logger::getInstance("realtime");
-    LOG4CPLUS_TRACE(log, "realtime trip update received");
 
     if (!is_handleable(trip_update, *data.pt_data, is_realtime_add_enabled, is_realtime_add_trip_enabled)
         || !check_trip_update(trip_update)) {
         LOG4CPLUS_DEBUG(log, "unhandled real time message");
-        return;
+        return false;
     }
 
     bool meta_vj_exists = data.pt_data->meta_vjs.exists(trip_update.trip().trip_id());
@@ -631,12 +632,27 @@ void handle_realtime(const std::string& id,
             LOG4CPLUS_WARN(log,
                            "Meta VJ 1st stop time departure: " << trip_update.stop_time_update(0).departure().time());
         }
-        return;
+        return false;
     }
     if (meta_vj_exists && is_added_trip(trip_update) && base_vj_exists_the_same_day(data, trip_update)) {
         LOG4CPLUS_WARN(log, "cannot add new trip, because trip id corresponds to a base VJ the same day"
                                 << ", trip id: " << trip_update.trip().trip_id() << ", effect: "
                                 << get_wordings(get_trip_effect(trip_update.GetExtension(kirin::effect))));
+        return false;
+    }
+    return true;
+}
+
+void handle_realtime(const std::string& id,
+                     const boost::posix_time::ptime& timestamp,
+                     const transit_realtime::TripUpdate& trip_update,
+                     const type::Data& data,
+                     const bool is_realtime_add_enabled,
+                     const bool is_realtime_add_trip_enabled) {
+    auto log = log4cplus::Logger::getInstance("realtime");
+    LOG4CPLUS_TRACE(log, "realtime trip update received");
+
+    if (!is_applicable(trip_update, data, is_realtime_add_enabled, is_realtime_add_trip_enabled)) {
         return;
     }
 
@@ -652,4 +668,52 @@ void handle_realtime(const std::string& id,
     apply_disruption(*disruption, *data.pt_data, *data.meta);
 }
 
+// the disruption an entity creates, updates or deletes
+static const std::string& disruption_id(const transit_realtime::FeedEntity& entity) {
+    if (!entity.is_deleted() && entity.HasExtension(chaos::disruption)) {
+        return entity.GetExtension(chaos::disruption).id();
+    }
+    return entity.id();
+}
+
+std::vector<RealtimeEntity> coalesce_entities(const std::vector<transit_realtime::FeedMessage>& feed_messages,
+                                              const type::Data& data,
+                                              const bool is_realtime_add_enabled,
+                                              const bool is_realtime_add_trip_enabled) {
+    std::vector<RealtimeEntity> entities;
+    std::map<std::string, size_t> nb_by_disruption;
+    for (const auto& feed_message : feed_messages) {
+        for (const auto& entity : feed_message.entity()) {
+            entities.push_back({&feed_message, &entity});
+            ++nb_by_disruption[disruption_id(entity)];
+        }
+    }
+
+    // from the last entity to the first one, an entity is dropped if a
+    // later one on the same disruption replaces all its effects
+    std::set<std::string> replaced;
+    std::vector<RealtimeEntity> kept;
+    for (auto it = entities.rbegin(); it != entities.rend(); ++it) {
+        const auto& entity = *it->entity;
+        const auto& id = disruption_id(entity);
+        if (replaced.count(id)) {
+            continue;
+        }
+        kept.push_back(*it);
+        if (--nb_by_disruption[id] == 0) {
+            // no previous entity on this disruption
+            continue;
+        }
+        // a deletion or a chaos disruption always deletes the previous
+        // state of the disruption, but a trip update only if applied
+        if (entity.is_deleted() || entity.HasExtension(chaos::disruption)
+            || (entity.has_trip_update()
+                && is_applicable(entity.trip_update(), data, is_realtime_add_enabled, is_realtime_add_trip_enabled))) {
+            replaced.insert(id);
+        }
+    }
+    std::reverse(kept.begin(), kept.end());
+    return kept;
+}
+
 }  // namespace navitia
@@ -33,6 +33,8 @@ www.navitia.io
 #include "type/data.h"
 #include "type/gtfs-realtime.pb.h"
 
+#include <vector>
+
 namespace navitia {
 
 /**
@@ -47,4 +49,31 @@ void handle_realtime(const std::string& id,
                      const type::Data&,
                      const bool is_realtime_add_enabled = false,
                      const bool is_realtime_add_trip_enabled = false);
+
+/**
+ * Is the trip update applied by handle_realtime on data, or ignored?
+ */
+bool is_applicable(const transit_realtime::TripUpdate&,
+                   const type::Data&,
+                   const bool is_realtime_add_enabled = false,
+                   const bool is_realtime_add_trip_enabled = false);
+
+// An entity of a realtime batch, with the feed message it comes from
+struct RealtimeEntity {
+    const transit_realtime::FeedMessage* feed_message;
+    const transit_realtime::FeedEntity* entity;
+};
+
+/**
+ * Returns the entities of a batch of feed messages that must be applied,
+ * in the order of the batch.  An entity is dropped when a later entity on
+ * the same disruption replaces all its effects, i.e. a deletion, a chaos
+ * disruption or a trip update applicable on data (the data the batch
+ * will be applied on), thus only the last state of each disruption is
+ * applied.
+ */
+std::vector<RealtimeEntity> coalesce_entities(const std::vector<transit_realtime::FeedMessage>& feed_messages,
+                                              const type::Data& data,
+                                              const bool is_realtime_add_enabled = false,
+                                              const bool is_realtime_add_trip_enabled = false);
 }  // namespace navitia
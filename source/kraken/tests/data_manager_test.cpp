@@ -35,6 +35,10 @@ www.navitia.io
 
 #include <boost/test/unit_test.hpp>
 #include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
 
 namespace test {
 
@@ -47,20 +51,26 @@ public:
     void build_relations() {}
     void build_proximity_list() {}
     void build_autocomplete_partial() {}
+    void clone_from(const Data&) {}
     mutable std::atomic<bool> loading;
     mutable std::atomic<bool> is_connected_to_rabbitmq;
     static bool load_status;
     static bool last_load_succeeded;
-    static bool destructor_called;
+    static std::atomic<bool> destructor_called;
+    static std::atomic<std::thread::id> destructor_thread;
     size_t data_identifier;
 
     Data(size_t data_identifier = 0) : data_identifier(data_identifier) { is_connected_to_rabbitmq = false; }
 
-    ~Data() { Data::destructor_called = true; }
+    ~Data() {
+        Data::destructor_thread = std::this_thread::get_id();
+        Data::destructor_called = true;
+    }
 };
 bool Data::load_status = true;
 bool Data::last_load_succeeded = true;
-bool Data::destructor_called = false;
+std::atomic<bool> Data::destructor_called(false);
+std::atomic<std::thread::id> Data::destructor_thread;
 
 }  // namespace test
 
@@ -112,6 +122,156 @@ BOOST_AUTO_TEST_CASE(destructor_called) {
     BOOST_CHECK(data_manager.get_data());
 }
 
+BOOST_AUTO_TEST_CASE(build_data_does_not_set_data) {
+    DataManager<test::Data> data_manager;
+    auto first_data = data_manager.get_data();
+
+    auto data = data_manager.build_data("fake path");
+    BOOST_REQUIRE(data);
+    BOOST_CHECK_EQUAL(first_data, data_manager.get_data());
+    BOOST_CHECK_EQUAL(data->loading, false);
+
+    data_manager.set_data(std::move(data));
+    BOOST_CHECK_NE(first_data, data_manager.get_data());
+    BOOST_CHECK_GT(data_manager.get_data()->data_identifier, first_data->data_identifier);
+}
+
+BOOST_AUTO_TEST_CASE(identifier_is_given_on_publication) {
+    DataManager<test::Data> data_manager;
+
+    // a background reload is built while clones are published
+    auto reloaded = data_manager.build_data("fake path");
+    BOOST_REQUIRE(reloaded);
+    data_manager.set_data(data_manager.get_data_clone());
+    const size_t clone_identifier = data_manager.get_data()->data_identifier;
+
+    data_manager.set_data(std::move(reloaded));
+    BOOST_CHECK_GT(data_manager.get_data()->data_identifier, clone_identifier);
+}
+
+BOOST_AUTO_TEST_CASE(load_stages_are_observed) {
+    DataManager<test::Data> data_manager;
+    std::mutex mutex;
+    std::set<std::string> stages;
+    auto observe = [&](const std::string& stage, double duration) {
+        std::lock_guard<std::mutex> lock(mutex);
+        BOOST_CHECK_GE(duration, 0);
+        stages.insert(stage);
+    };
+    BOOST_CHECK(data_manager.load("fake path", boost::none, {}, 10, observe));
+    BOOST_CHECK(stages == std::set<std::string>({"nav", "raptor", "relations", "proximity_list"}));
+
+    stages.clear();
+    BOOST_CHECK(data_manager.load("fake path", std::string("fake database"), {}, 10, observe));
+    BOOST_CHECK(stages
+                == std::set<std::string>({"nav", "disruptions", "raptor", "relations", "proximity_list", "autocomplete"}));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_is_refreshed_on_publication) {
+    DataManager<test::Data> data_manager;
+    auto snapshot = data_manager.get_snapshot();
+    const auto first_data = snapshot.get();
+    BOOST_REQUIRE(first_data);
+    BOOST_CHECK_EQUAL(first_data, data_manager.get_data());
+    BOOST_CHECK_EQUAL(first_data, snapshot.get());
+
+    // a clone is not a publication
+    data_manager.get_data_clone();
+    BOOST_CHECK_EQUAL(first_data, snapshot.get());
+
+    BOOST_CHECK(data_manager.load("fake path"));
+    BOOST_CHECK_NE(first_data, snapshot.get());
+    BOOST_CHECK_EQUAL(snapshot.get(), data_manager.get_data());
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_holds_data_until_refreshed) {
+    DataManager<test::Data> data_manager;
+    auto snapshot = data_manager.get_snapshot();
+    const size_t first_identifier = snapshot.get()->data_identifier;
+
+    BOOST_CHECK(data_manager.load("fake path"));
+    // the snapshot still references the first data
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, false);
+
+    BOOST_CHECK_NE(snapshot.get()->data_identifier, first_identifier);
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, true);
+}
+
+BOOST_AUTO_TEST_CASE(idle_snapshot_releases_outdated_data) {
+    DataManager<test::Data> data_manager;
+    auto snapshot = data_manager.get_snapshot();
+    const size_t first_identifier = snapshot.get()->data_identifier;
+
+    // nothing published, the data is kept
+    snapshot.release_outdated();
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, false);
+
+    BOOST_CHECK(data_manager.load("fake path"));
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, false);
+    snapshot.release_outdated();
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, true);
+    BOOST_CHECK_NE(snapshot.get()->data_identifier, first_identifier);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_publication_and_reads) {
+    DataManager<test::Data> data_manager;
+    std::atomic_bool stop(false);
+    std::atomic_bool older_data_read(false);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            auto snapshot = data_manager.get_snapshot();
+            size_t last_identifier = 0;
+            while (!stop) {
+                const auto& data = snapshot.get();
+                // published identifiers only grow
+                if (data->data_identifier < last_identifier) {
+                    older_data_read = true;
+                }
+                last_identifier = data->data_identifier;
+            }
+        });
+    }
+    for (size_t i = 1; i <= 200; ++i) {
+        data_manager.set_data(new test::Data(i));
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    BOOST_CHECK(!older_data_read);
+    BOOST_CHECK_EQUAL(data_manager.get_data()->data_identifier, 200);
+    BOOST_CHECK_EQUAL(data_manager.get_snapshot().get()->data_identifier, 200);
+}
+
+BOOST_AUTO_TEST_CASE(reclaimer_destroys_data_in_its_thread) {
+    DataManager<test::Data> data_manager;
+    // called from the reclaimer thread, so no check in it
+    std::atomic_size_t nb_reclaimed(0);
+    data_manager.start_reclaimer(2, [&](double) { ++nb_reclaimed; });
+    BOOST_CHECK(data_manager.load("fake path"));
+    test::Data::destructor_called = false;
+
+    BOOST_CHECK(data_manager.load("fake path"));
+    for (size_t i = 0; i < 1000 && nb_reclaimed == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_CHECK_EQUAL(nb_reclaimed, 1);
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, true);
+    BOOST_CHECK(test::Data::destructor_thread.load() != std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_CASE(full_reclaimer_destroys_data_in_the_releasing_thread) {
+    DataManager<test::Data> data_manager;
+    data_manager.start_reclaimer(0);
+    BOOST_CHECK(data_manager.load("fake path"));
+    test::Data::destructor_called = false;
+
+    BOOST_CHECK(data_manager.load("fake path"));
+    BOOST_CHECK_EQUAL(test::Data::destructor_called, true);
+    BOOST_CHECK(test::Data::destructor_thread.load() == std::this_thread::get_id());
+}
+
 BOOST_AUTO_TEST_CASE(destructor_not_called) {
     DataManager<test::Data> data_manager;
     {
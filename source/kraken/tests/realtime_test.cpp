@@ -3504,3 +3504,208 @@ BOOST_FIXTURE_TEST_CASE(cannot_add_new_trip_if_id_corresponds_to_a_base_VJ_the_s
     BOOST_CHECK_EQUAL(res.response_type(), pbnavitia::NO_SOLUTION);
     BOOST_CHECK_EQUAL(res.impacts_size(), 0);
 }
+
+BOOST_AUTO_TEST_CASE(incremental_raptor_rebuild_matches_full_rebuild) {
+    ed::builder b("20150928");
+    b.vj("A", "000111", "", true, "vj:1")("stop1", "08:01"_t)("stop2", "09:01"_t)("stop3", "10:01"_t);
+    b.vj("A", "000111", "", true, "vj:2")("stop1", "09:01"_t)("stop2", "10:01"_t)("stop3", "11:01"_t);
+    b.vj("B", "000111", "", true, "vj:3")("stop2", "09:30"_t)("stop4", "10:30"_t);
+    b.vj("C", "000111", "", true, "vj:4")("stop3", "12:00"_t)("stop4", "12:30"_t);
+    b.data->build_uri();
+    b.finalize_disruption_batch();
+
+    const auto delay = ntest::make_trip_update_message(
+        "vj:1", "20150928",
+        {RTStopTime("stop1", "20150928T0810"_pts).delay(9_min), RTStopTime("stop2", "20150928T0910"_pts).delay(9_min),
+         RTStopTime("stop3", "20150928T1010"_pts).delay(9_min)});
+    const auto cancellation = make_cancellation_message("vj:3", "20150928");
+
+    // the same realtime is applied on 2 clones, one rebuilt from the base
+    // raptor data, the other one from scratch
+    nt::Data incremental(1), full(2);
+    for (auto* data : {&incremental, &full}) {
+        data->clone_from(*b.data);
+        navitia::handle_realtime(feed_id, timestamp, delay, *data, true, true);
+        navitia::handle_realtime(feed_id_1, timestamp, cancellation, *data, true, true);
+    }
+    BOOST_CHECK(incremental.pt_data->modified_meta_vjs == std::set<std::string>({"vj:1", "vj:3"}));
+    incremental.build_raptor(1, b.data.get());
+    full.build_raptor(1);
+    BOOST_CHECK(incremental.pt_data->modified_meta_vjs.empty());
+
+    const auto& inc_raptor = *incremental.dataRaptor;
+    const auto& full_raptor = *full.dataRaptor;
+    auto vj_uris = [](const navitia::routing::JourneyPattern& jp) {
+        std::set<std::string> uris;
+        jp.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
+            uris.insert(vj.uri);
+            return true;
+        });
+        return uris;
+    };
+    auto st_uris = [](const navitia::routing::NextStopTimeData::StopTimeIter& range) {
+        std::vector<std::string> uris;
+        for (const auto* st : range) {
+            uris.push_back(st->vehicle_journey->uri + ":" + std::to_string(st->order().val));
+        }
+        return uris;
+    };
+    BOOST_REQUIRE_EQUAL(incremental.pt_data->vehicle_journeys.size(), full.pt_data->vehicle_journeys.size());
+    for (const auto* full_vj : full.pt_data->vehicle_journeys) {
+        const auto* inc_vj = incremental.pt_data->vehicle_journeys_map.at(full_vj->uri);
+        const auto inc_jp_idx = inc_raptor.jp_container.get_jp_from_vj()[navitia::routing::VjIdx(*inc_vj)];
+        const auto full_jp_idx = full_raptor.jp_container.get_jp_from_vj()[navitia::routing::VjIdx(*full_vj)];
+        const auto& inc_jp = inc_raptor.jp_container.get(inc_jp_idx);
+        const auto& full_jp = full_raptor.jp_container.get(full_jp_idx);
+        const auto inc_vjs = vj_uris(inc_jp);
+        const auto full_vjs = vj_uris(full_jp);
+        BOOST_CHECK_EQUAL_COLLECTIONS(inc_vjs.begin(), inc_vjs.end(), full_vjs.begin(), full_vjs.end());
+
+        for (const auto level : {nt::RTLevel::Base, nt::RTLevel::Adapted, nt::RTLevel::RealTime}) {
+            for (size_t day = 0; day < 366; ++day) {
+                BOOST_CHECK_EQUAL(inc_raptor.jp_validity_patterns[level][day][inc_jp_idx.val],
+                                  full_raptor.jp_validity_patterns[level][day][full_jp_idx.val]);
+            }
+        }
+
+        BOOST_REQUIRE_EQUAL(inc_jp.jpps.size(), full_jp.jpps.size());
+        for (size_t i = 0; i < inc_jp.jpps.size(); ++i) {
+            for (const auto event : {navitia::routing::StopEvent::pick_up, navitia::routing::StopEvent::drop_off}) {
+                const auto& inc_nst = inc_raptor.next_stop_time_data;
+                const auto& full_nst = full_raptor.next_stop_time_data;
+                const auto inc_sts = st_uris(inc_nst.stop_time_range_forward(inc_jp.jpps[i], event));
+                const auto full_sts = st_uris(full_nst.stop_time_range_forward(full_jp.jpps[i], event));
+                BOOST_CHECK_EQUAL_COLLECTIONS(inc_sts.begin(), inc_sts.end(), full_sts.begin(), full_sts.end());
+            }
+        }
+    }
+
+    // and the journeys are the same
+    for (auto* data : {&incremental, &full}) {
+        navitia::routing::RAPTOR raptor(*data);
+        const auto& pt_data = *data->pt_data;
+        auto res = raptor.compute(pt_data.stop_areas_map.at("stop1"), pt_data.stop_areas_map.at("stop3"), "08:00"_t, 0,
+                                  navitia::DateTimeUtils::inf, nt::RTLevel::RealTime, 2_min, true);
+        BOOST_REQUIRE_EQUAL(res.size(), 1);
+        BOOST_CHECK_EQUAL(res[0].items[0].arrival, "20150928T1010"_dt);
+
+        res = raptor.compute(pt_data.stop_areas_map.at("stop1"), pt_data.stop_areas_map.at("stop4"), "08:00"_t, 0,
+                             navitia::DateTimeUtils::inf, nt::RTLevel::RealTime, 2_min, true);
+        BOOST_REQUIRE_EQUAL(res.size(), 1);
+        BOOST_CHECK_EQUAL(res[0].items.back().arrival, "20150928T1230"_dt);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(incremental_relations_rebuild_matches_full_rebuild) {
+    ed::builder b("20150928");
+    b.vj("A", "000111", "", true, "vj:1")("stop1", "08:01"_t)("stop2", "09:01"_t)("stop3", "10:01"_t);
+    b.vj("B", "000111", "", true, "vj:2")("stop2", "09:30"_t)("stop4", "10:30"_t);
+    b.vj("C", "000111", "", true, "vj:3")("stop3", "12:00"_t)("stop4", "12:30"_t);
+    b.data->build_uri();
+    b.finalize_disruption_batch();
+    b.data->build_proximity_list();
+
+    // vj:2 does not stop at stop4 anymore
+    const auto detour = ntest::make_trip_update_message(
+        "vj:2", "20150928", {RTStopTime("stop2", "20150928T0930"_pts), RTStopTime("stop3", "20150928T1030"_pts)});
+
+    nt::Data incremental(1), full(2);
+    for (auto* data : {&incremental, &full}) {
+        data->clone_from(*b.data);
+        navitia::handle_realtime(feed_id, timestamp, detour, *data, true, true);
+    }
+    incremental.build_relations(incremental.pt_data->modified_meta_vjs);
+    full.build_relations();
+
+    auto uris = [](const boost::container::flat_set<nt::StopPoint*>& sps) {
+        std::set<std::string> res;
+        for (const auto* sp : sps) {
+            res.insert(sp->uri);
+        }
+        return res;
+    };
+    auto route_uris = [](const boost::container::flat_set<nt::Route*>& routes) {
+        std::set<std::string> res;
+        for (const auto* route : routes) {
+            res.insert(route->uri);
+        }
+        return res;
+    };
+    BOOST_REQUIRE_EQUAL(incremental.pt_data->routes.size(), full.pt_data->routes.size());
+    for (const auto* route : full.pt_data->routes) {
+        const auto* inc_route = incremental.pt_data->routes_map.at(route->uri);
+        BOOST_CHECK(uris(inc_route->stop_point_list) == uris(route->stop_point_list));
+        BOOST_CHECK_EQUAL(inc_route->stop_area_list.size(), route->stop_area_list.size());
+    }
+    for (const auto* sp : full.pt_data->stop_points) {
+        const auto* inc_sp = incremental.pt_data->stop_points_map.at(sp->uri);
+        BOOST_CHECK(route_uris(inc_sp->route_list) == route_uris(sp->route_list));
+        BOOST_CHECK(route_uris(inc_sp->stop_area->route_list) == route_uris(sp->stop_area->route_list));
+    }
+    // the route of vj:2 has both its base and its realtime stop points
+    BOOST_CHECK(uris(incremental.pt_data->lines_map.at("B")->route_list.front()->stop_point_list)
+                == std::set<std::string>({"stop2", "stop3", "stop4"}));
+
+    // the proximity lists of the stop points are shared with the clone
+    incremental.build_proximity_list();
+    BOOST_CHECK(incremental.pt_data->stop_point_proximity_list.NN_index
+                == b.data->pt_data->stop_point_proximity_list.NN_index);
+    BOOST_CHECK_EQUAL(incremental.pt_data->stop_point_proximity_list.items.size(),
+                      b.data->pt_data->stop_point_proximity_list.items.size());
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_realtime_entities_of_a_batch) {
+    ed::builder b("20150928");
+    b.vj("A", "000001", "", true, "vj:1")("stop1", "08:00"_t)("stop2", "09:00"_t);
+    b.vj("A", "000001", "", true, "vj:2")("stop1", "09:00"_t)("stop2", "10:00"_t);
+    b.vj("A", "000001", "", true, "vj:3")("stop1", "10:00"_t)("stop2", "11:00"_t);
+    b.data->build_uri();
+
+    auto delay = [](const std::string& vj, const std::string& date, const std::string& dep1,
+                    const std::string& dep2) {
+        return ntest::make_trip_update_message(vj, date,
+                                               {RTStopTime("stop1", ntest::to_posix_timestamp(dep1)),
+                                                RTStopTime("stop2", ntest::to_posix_timestamp(dep2))});
+    };
+    std::vector<transit_realtime::FeedMessage> feeds(2);
+    auto add_entity = [](transit_realtime::FeedMessage& feed, const std::string& id) {
+        auto* entity = feed.add_entity();
+        entity->set_id(id);
+        return entity;
+    };
+    *add_entity(feeds[0], "42")->mutable_trip_update() = delay("vj:1", "20150928", "20150928T0805", "20150928T0905");
+    *add_entity(feeds[0], "43")->mutable_trip_update() = make_cancellation_message("vj:2", "20150928");
+    *add_entity(feeds[0], "45")->mutable_trip_update() = delay("vj:3", "20150928", "20150928T1010", "20150928T1110");
+    *add_entity(feeds[1], "42")->mutable_trip_update() = delay("vj:1", "20150928", "20150928T0809", "20150928T0909");
+    add_entity(feeds[1], "43")->set_is_deleted(true);
+    // its stop times are before its start date: it is not applied, and doesn't replace the previous one
+    *add_entity(feeds[1], "45")->mutable_trip_update() = delay("vj:3", "20150929", "20150928T1020", "20150928T1120");
+
+    const auto entities = navitia::coalesce_entities(feeds, *b.data, true, true);
+    std::vector<std::string> ids;
+    for (const auto& entity : entities) {
+        ids.push_back((entity.feed_message == &feeds[0] ? "0:" : "1:") + entity.entity->id());
+    }
+    const std::vector<std::string> expected = {"0:45", "1:42", "1:43", "1:45"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+
+    for (const auto& rt_entity : entities) {
+        const auto& entity = *rt_entity.entity;
+        if (entity.is_deleted()) {
+            navitia::delete_disruption(entity.id(), *b.data->pt_data, *b.data->meta);
+        } else {
+            navitia::handle_realtime(entity.id(), timestamp, entity.trip_update(), *b.data, true, true);
+        }
+    }
+    const auto& pt_data = *b.data->pt_data;
+    BOOST_CHECK(pt_data.disruption_holder.get_disruption("42"));
+    BOOST_CHECK(!pt_data.disruption_holder.get_disruption("43"));
+    BOOST_CHECK(pt_data.disruption_holder.get_disruption("45"));
+
+    // only the last delay of vj:1 is applied, vj:2 isn't cancelled anymore
+    BOOST_REQUIRE_EQUAL(pt_data.meta_vjs["vj:1"]->get_rt_vj().size(), 1);
+    BOOST_CHECK_EQUAL(pt_data.meta_vjs["vj:1"]->get_rt_vj()[0]->stop_time_list.front().departure_time, "08:09"_t);
+    BOOST_CHECK(pt_data.meta_vjs["vj:2"]->get_rt_vj().empty());
+    BOOST_REQUIRE_EQUAL(pt_data.meta_vjs["vj:3"]->get_rt_vj().size(), 1);
+    BOOST_CHECK_EQUAL(pt_data.meta_vjs["vj:3"]->get_rt_vj()[0]->stop_time_list.front().departure_time, "10:10"_t);
+}
@@ -40,6 +40,8 @@ www.navitia.io
 #include "ptreferential/ptreferential_api.h"
 #include "routing/raptor.h"
 #include "routing/raptor_api.h"
+#include "routing/street_network_matrix.h"
+#include "routing/thread_pool.h"
 #include "time_tables/departure_boards.h"
 #include "time_tables/passages.h"
 #include "time_tables/route_schedules.h"
@@ -223,8 +225,18 @@ std::vector<std::string> vector_of_admins(const T& admin) {
     return result;
 }
 
-Worker::Worker(kraken::Configuration conf)
-    : conf(std::move(conf)), logger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"))) {}
+Worker::Worker(kraken::Configuration conf, navitia::routing::JourneyCache* journey_cache)
+    : conf(std::move(conf)),
+      journey_cache(journey_cache),
+      logger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"))) {
+    if (this->conf.raptor_nb_threads() > 1) {
+        raptor_thread_pool = std::make_unique<routing::ThreadPool>(this->conf.raptor_nb_threads());
+    }
+    if (this->conf.street_network_matrix_nb_threads() > 1) {
+        street_network_matrix_thread_pool =
+            std::make_unique<routing::ThreadPool>(this->conf.street_network_matrix_nb_threads());
+    }
+}
 
 Worker::~Worker() = default;
 
@@ -378,8 +390,13 @@ void Worker::init_worker_data(const navitia::type::Data* data,
                               const bool disable_disruption) {
     //@TODO should be done in data_manager
     if (data->data_identifier != this->last_data_identifier || !planner) {
-        planner = std::make_unique<routing::RAPTOR>(*data);
-        street_network_worker = std::make_unique<georef::StreetNetwork>(*data->geo_ref);
+        planner = std::make_unique<routing::RAPTOR>(*data, conf.raptor_scan_marked_jps_only(),
+                                                    raptor_thread_pool.get());
+        const auto priority_queue = conf.street_network_radix_heap() ? georef::PriorityQueue_e::radix_heap
+                                                                     : georef::PriorityQueue_e::d_ary_heap;
+        street_network_worker = std::make_unique<georef::StreetNetwork>(*data->geo_ref, priority_queue);
+        street_network_matrix = std::make_unique<routing::StreetNetworkMatrix>(
+            *data->geo_ref, street_network_matrix_thread_pool.get(), priority_queue);
         this->last_data_identifier = data->data_identifier;
         LOG4CPLUS_INFO(logger, "Instanciate planner");
     }
@@ -767,7 +784,7 @@ void Worker::journeys(const pbnavitia::JourneysRequest& request, pbnavitia::API
                     request.night_bus_filter_max_factor(), request.night_bus_filter_base_factor(),
                     request.has_timeframe_duration() ? boost::make_optional<uint32_t>(request.timeframe_duration())
                                                      : boost::none,
-                    request.depth());
+                    request.depth(), journey_cache);
                 break;
             default:
                 routing::make_response(
@@ -780,7 +797,7 @@ void Worker::journeys(const pbnavitia::JourneysRequest& request, pbnavitia::API
                     request.night_bus_filter_max_factor(), request.night_bus_filter_base_factor(),
                     request.has_timeframe_duration() ? boost::make_optional<uint32_t>(request.timeframe_duration())
                                                      : boost::none,
-                    request.depth());
+                    request.depth(), journey_cache);
         }
     } catch (const navitia::coord_conversion_exception& e) {
         this->pb_creator.fill_pb_error(pbnavitia::Error::bad_format, e.what());
@@ -986,32 +1003,28 @@ void Worker::street_network_routing_matrix(const pbnavitia::StreetNetworkRouting
         }
     }
 
+    std::vector<type::EntryPoint> origins;
     for (const auto& origin : request.origins()) {
-        type::EntryPoint entry_point;
         try {
-            entry_point =
-                make_sn_entry_point(origin.place(), request.mode(), request.speed(), request.max_duration(), *data);
+            origins.push_back(
+                make_sn_entry_point(origin.place(), request.mode(), request.speed(), request.max_duration(), *data));
         } catch (const navitia::coord_conversion_exception& e) {
             this->pb_creator.fill_pb_error(pbnavitia::Error::bad_format, e.what());
             return;
         }
+    }
 
-        street_network_worker->departure_path_finder.init(entry_point.coordinates,
-                                                          entry_point.streetnetwork_params.mode,
-                                                          entry_point.streetnetwork_params.speed_factor);
-        auto nearest = street_network_worker->departure_path_finder.get_duration_with_dijkstra(
-            navitia::time_duration::from_boost_duration(boost::posix_time::seconds(request.max_duration())),
-            dest_coords);
+    // the destinations are projected once, and the origins searched together
+    const auto matrix = street_network_matrix->compute(
+        origins, dest_coords,
+        navitia::time_duration::from_boost_duration(boost::posix_time::seconds(request.max_duration())));
 
+    for (const auto& durations : matrix) {
         auto* row = this->pb_creator.mutable_sn_routing_matrix()->add_rows();
-        for (auto coord : dest_coords) {
+        for (const auto& routing_element : durations) {
             auto* k = row->add_routing_response();
-            auto it = nearest.find(coord.uri());
-            if (it == nearest.end()) {
-                throw navitia::recoverable_exception("Cannot find object: " + coord.uri());
-            }
-            k->set_duration(it->second.time_duration.total_seconds());
-            switch (it->second.routing_status) {
+            k->set_duration(routing_element.time_duration.total_seconds());
+            switch (routing_element.routing_status) {
                 case georef::RoutingStatus_e::reached:
                     k->set_routing_status(pbnavitia::RoutingStatus::reached);
                     break;
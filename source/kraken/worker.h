@@ -34,7 +34,10 @@ www.navitia.io
 namespace navitia {
 namespace routing {
 struct RAPTOR;
-}
+class JourneyCache;
+class StreetNetworkMatrix;
+class ThreadPool;
+}  // namespace routing
 }  // namespace navitia
 
 #include "georef/street_network.h"
@@ -74,10 +77,17 @@ struct JourneysArg {
 
 class Worker {
 private:
+    // created once, the planner and the matrix built on each new data use them, null when sequential
+    std::unique_ptr<navitia::routing::ThreadPool> raptor_thread_pool;
+    std::unique_ptr<navitia::routing::ThreadPool> street_network_matrix_thread_pool;
+
     std::unique_ptr<navitia::routing::RAPTOR> planner;
     std::unique_ptr<navitia::georef::StreetNetwork> street_network_worker;
+    std::unique_ptr<navitia::routing::StreetNetworkMatrix> street_network_matrix;
 
     const kraken::Configuration conf;
+    // shared by the workers, null when disabled
+    navitia::routing::JourneyCache* journey_cache;
     log4cplus::Logger logger;
     size_t last_data_identifier =
         std::numeric_limits<size_t>::max();  // to check that data did not change, do not use directly
@@ -86,7 +96,7 @@ private:
 public:
     navitia::PbCreator pb_creator;
 
-    Worker(kraken::Configuration conf);
+    Worker(kraken::Configuration conf, navitia::routing::JourneyCache* journey_cache = nullptr);
     // we override de destructor this way we can forward declare Raptor
     // see: https://stackoverflow.com/questions/6012157/is-stdunique-ptrt-required-to-know-the-full-definition-of-t
     ~Worker();
@@ -132,6 +142,7 @@ private:
      * from origin to destination by taking street network
      * */
     void street_network_routing_matrix(const pbnavitia::StreetNetworkRoutingMatrixRequest& request);
+
     void odt_stop_points(const pbnavitia::GeographicalCoord& request);
 
     void get_matching_routes(const pbnavitia::MatchingRoute&);
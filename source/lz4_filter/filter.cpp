@@ -0,0 +1,289 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "lz4_filter/filter.h"
+
+#include <boost/crc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace lz4_frame {
+
+namespace {
+
+// The tasks are claimed one by one by nb_threads threads, the calling one
+// included.  The first exception thrown by a task is rethrown at the end.
+void parallel_for(size_t nb_tasks, size_t nb_threads, const std::function<void(size_t)>& task) {
+    std::atomic<size_t> next_task{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&]() {
+        for (size_t i = next_task++; i < nb_tasks; i = next_task++) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_task = nb_tasks;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(nb_threads, nb_tasks); ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+uint32_t checksum(const char* data, size_t size) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+template <typename T>
+void write_value(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T read_value(std::istream& in) {
+    T value;
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!in) {
+        throw std::runtime_error("lz4 frame: truncated file");
+    }
+    return value;
+}
+
+}  // namespace
+
+size_t default_nb_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+Writer::Writer(std::ostream& out, size_t block_size, bool checksums, size_t nb_threads)
+    : out(out), block_size(block_size), checksums(checksums), nb_threads(std::max<size_t>(1, nb_threads)) {
+    pending.reserve(block_size * this->nb_threads);
+    write_value(out, magic);
+    write_value(out, format_version);
+    write_value(out, checksums ? checksums_flag : uint32_t(0));
+    write_value(out, static_cast<uint32_t>(block_size));
+}
+
+void Writer::compress_pending() {
+    const size_t nb_blocks = (pending.size() + block_size - 1) / block_size;
+    std::vector<std::vector<char>> compressed(nb_blocks);
+    std::vector<BlockInfo> infos(nb_blocks);
+    parallel_for(nb_blocks, nb_threads, [&](size_t i) {
+        const char* src = pending.data() + i * block_size;
+        const auto size = static_cast<int>(std::min(block_size, pending.size() - i * block_size));
+        compressed[i].resize(LZ4_compressBound(size));
+        const int compressed_size =
+            LZ4_compress_default(src, compressed[i].data(), size, static_cast<int>(compressed[i].size()));
+        if (compressed_size <= 0) {
+            throw std::runtime_error("lz4 frame: compression failed");
+        }
+        infos[i].compressed_size = compressed_size;
+        infos[i].size = size;
+        infos[i].checksum = checksums ? checksum(src, size) : 0;
+    });
+    for (size_t i = 0; i < nb_blocks; ++i) {
+        infos[i].offset = offset;
+        out.write(compressed[i].data(), infos[i].compressed_size);
+        offset += infos[i].compressed_size;
+        index.push_back(infos[i]);
+    }
+    pending.clear();
+}
+
+void Writer::write(const char* src, size_t size) {
+    const size_t capacity = block_size * nb_threads;
+    while (size > 0) {
+        const size_t nb = std::min(size, capacity - pending.size());
+        pending.insert(pending.end(), src, src + nb);
+        src += nb;
+        size -= nb;
+        if (pending.size() == capacity) {
+            compress_pending();
+        }
+    }
+}
+
+void Writer::finish() {
+    compress_pending();
+    const uint64_t index_offset = offset;
+    for (const auto& block : index) {
+        write_value(out, block.offset);
+        write_value(out, block.compressed_size);
+        write_value(out, block.size);
+        write_value(out, block.checksum);
+    }
+    write_value(out, index_offset);
+    write_value(out, static_cast<uint64_t>(index.size()));
+    write_value(out, magic);
+    out.flush();
+}
+
+bool is_frame(std::istream& in) {
+    const auto begin = in.tellg();
+    uint32_t value = 0;
+    bool res = false;
+    try {
+        in.read(reinterpret_cast<char*>(&value), sizeof(value));
+        res = in.gcount() == sizeof(value) && value == magic;
+    } catch (const std::ios_base::failure&) {
+    }
+    in.clear();
+    in.seekg(begin);
+    return res;
+}
+
+Reader::Reader(std::istream& in, size_t nb_threads)
+    : in(in), begin(in.tellg()), nb_threads(std::max<size_t>(1, nb_threads)) {
+    if (read_value<uint32_t>(in) != magic) {
+        throw std::runtime_error("lz4 frame: bad magic");
+    }
+    if (read_value<uint32_t>(in) != format_version) {
+        throw std::runtime_error("lz4 frame: unknown format version");
+    }
+    checksums = read_value<uint32_t>(in) & checksums_flag;
+    read_value<uint32_t>(in);  // block size, only informative
+
+    in.seekg(0, std::ios::end);
+    const auto frame_size = static_cast<uint64_t>(static_cast<std::streamoff>(in.tellg()) - begin);
+    if (frame_size < header_size + footer_size) {
+        throw std::runtime_error("lz4 frame: truncated file");
+    }
+    in.seekg(-static_cast<std::streamoff>(footer_size), std::ios::end);
+    const auto index_offset = read_value<uint64_t>(in);
+    const auto nb_blocks = read_value<uint64_t>(in);
+    if (read_value<uint32_t>(in) != magic) {
+        throw std::runtime_error("lz4 frame: bad footer");
+    }
+    if (index_offset < header_size || index_offset + footer_size > frame_size
+        || frame_size - index_offset - footer_size != nb_blocks * index_entry_size) {
+        throw std::runtime_error("lz4 frame: bad footer");
+    }
+
+    // the blocks follow each other, thus a batch is read at once
+    in.seekg(begin + static_cast<std::streamoff>(index_offset));
+    index.resize(nb_blocks);
+    uint64_t offset = header_size;
+    for (auto& block : index) {
+        block.offset = read_value<uint64_t>(in);
+        block.compressed_size = read_value<uint32_t>(in);
+        block.size = read_value<uint32_t>(in);
+        block.checksum = read_value<uint32_t>(in);
+        if (block.offset != offset || block.offset + block.compressed_size > index_offset) {
+            throw std::runtime_error("lz4 frame: bad index");
+        }
+        offset += block.compressed_size;
+    }
+    in.seekg(begin + static_cast<std::streamoff>(header_size));
+}
+
+uint64_t Reader::size() const {
+    uint64_t res = 0;
+    for (const auto& block : index) {
+        res += block.size;
+    }
+    return res;
+}
+
+bool Reader::decompress_batch() {
+    while (next_block < index.size()) {
+        const size_t first = next_block;
+        next_block = std::min(index.size(), first + nb_threads);
+        const auto& last = index[next_block - 1];
+        compressed.resize(last.offset + last.compressed_size - index[first].offset);
+        in.read(compressed.data(), compressed.size());
+        if (!in) {
+            throw std::runtime_error("lz4 frame: truncated file");
+        }
+
+        std::vector<size_t> positions;
+        size_t batch_size = 0;
+        for (size_t i = first; i < next_block; ++i) {
+            positions.push_back(batch_size);
+            batch_size += index[i].size;
+        }
+        decompressed.resize(batch_size);
+        parallel_for(next_block - first, nb_threads, [&](size_t i) {
+            const auto& block = index[first + i];
+            char* dest = decompressed.data() + positions[i];
+            const int size = LZ4_decompress_safe(compressed.data() + block.offset - index[first].offset, dest,
+                                                 block.compressed_size, block.size);
+            if (size < 0 || static_cast<uint32_t>(size) != block.size) {
+                throw std::runtime_error("lz4 frame: corrupted block");
+            }
+            if (checksums && checksum(dest, block.size) != block.checksum) {
+                throw std::runtime_error("lz4 frame: bad checksum");
+            }
+        });
+        if (!decompressed.empty()) {
+            setg(decompressed.data(), decompressed.data(), decompressed.data() + decompressed.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+Reader::int_type Reader::underflow() {
+    if (gptr() == egptr() && !decompress_batch()) {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+std::vector<char> read(std::istream& in, size_t nb_threads) {
+    Reader reader(in, nb_threads);
+    std::vector<char> result(reader.size());
+    if (reader.sgetn(result.data(), result.size()) != static_cast<std::streamsize>(result.size())) {
+        throw std::runtime_error("lz4 frame: truncated file");
+    }
+    return result;
+}
+
+}  // namespace lz4_frame
@@ -37,6 +37,8 @@ www.navitia.io
 #include <boost/iostreams/write.hpp>
 #include <boost/iostreams/read.hpp>
 #include <boost/cstdint.hpp>
+#include <streambuf>
+#include <vector>
 
 typedef std::exception LZ4Exception;
 
@@ -126,3 +128,115 @@ public:
         return output_size;
     }
 };
+
+/**
+ * Framed format of LZ4 compressed data
+ *
+ * Unlike the stream written by LZ4Compressor, the blocks of a frame are
+ * indexed, thus they can be compressed and decompressed in parallel:
+ *
+ *   header: magic, format version, flags, block size (uint32)
+ *   blocks: the compressed blocks, one after the other
+ *   index: for each block, its offset (uint64), its compressed size, its
+ *          size and the crc32 of its data (uint32, 0 without checksums)
+ *   footer: the offset of the index (uint64), the number of blocks (uint64), magic (uint32)
+ *
+ * The offsets are relative to the start of the frame, and the integers
+ * are in the machine byte order, as the chunk sizes of the stream format.
+ * The magic is bigger than any chunk size of the stream format, thus
+ * is_frame tells the 2 formats apart.
+ */
+namespace lz4_frame {
+
+const uint32_t magic = 0x3146344c;  // "L4F1"
+const uint32_t format_version = 1;
+const uint32_t checksums_flag = 1;
+const size_t header_size = 4 * sizeof(uint32_t);
+const size_t index_entry_size = sizeof(uint64_t) + 3 * sizeof(uint32_t);
+const size_t footer_size = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+
+struct BlockInfo {
+    uint64_t offset = 0;
+    uint32_t compressed_size = 0;
+    uint32_t size = 0;
+    uint32_t checksum = 0;
+};
+
+size_t default_nb_threads();
+
+/**
+ * Writes a frame to a stream.  The data is split in blocks of block_size,
+ * nb_threads blocks being compressed at the same time.  finish must be
+ * called once all the data has been written.
+ */
+class Writer {
+    std::ostream& out;
+    size_t block_size;
+    bool checksums;
+    size_t nb_threads;
+    std::vector<char> pending;
+    std::vector<BlockInfo> index;
+    uint64_t offset = header_size;
+
+    void compress_pending();
+
+public:
+    /// boost::iostreams sink writing to the frame
+    struct Sink : public boost::iostreams::sink {
+        Writer* writer;
+        explicit Sink(Writer* writer) : writer(writer) {}
+        std::streamsize write(const char* src, std::streamsize size) {
+            writer->write(src, size);
+            return size;
+        }
+    };
+
+    Writer(std::ostream& out,
+           size_t block_size = 4 * 1024 * 1024,
+           bool checksums = true,
+           size_t nb_threads = default_nb_threads());
+
+    Sink sink() { return Sink(this); }
+
+    void write(const char* src, size_t size);
+    void finish();
+};
+
+/// Does in start with a frame?  The position of in is left unchanged.
+bool is_frame(std::istream& in);
+
+/**
+ * Stream buffer reading the decompressed data of the frame starting at
+ * the position of in.
+ *
+ * The blocks are decompressed nb_threads at a time, in parallel, when the
+ * previous ones have been read: only a batch of blocks is held in memory,
+ * compressed and decompressed, whatever the size of the frame.
+ */
+class Reader : public std::streambuf {
+    std::istream& in;
+    std::streamoff begin;
+    size_t nb_threads;
+    bool checksums = false;
+    std::vector<BlockInfo> index;
+    size_t next_block = 0;
+    std::vector<char> compressed;
+    std::vector<char> decompressed;
+
+    // decompress the next batch of blocks, false at the end of the frame
+    bool decompress_batch();
+
+protected:
+    int_type underflow() override;
+
+public:
+    explicit Reader(std::istream& in, size_t nb_threads = default_nb_threads());
+
+    /// size of the decompressed data
+    uint64_t size() const;
+};
+
+/// Reads the whole frame starting at the position of in
+std::vector<char> read(std::istream& in, size_t nb_threads = default_nb_threads());
+
+}  // namespace lz4_frame
@@ -0,0 +1,134 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+/*
+ * Throughput of the LZ4 stream format, decompressed sequentially, against
+ * the framed format, decompressed in parallel, on generated data.
+ */
+
+#include "lz4_filter/filter.h"
+
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace po = boost::program_options;
+
+// roughly as compressible as a .nav: words, numbers and repetitions
+static std::string generate(size_t size) {
+    static const std::vector<std::string> words = {"stop_point:", "stop_area:", "vehicle_journey:", "route:",
+                                                   "line:",       "network:",   "\x01\x00\x00\x00", "\xff\xff"};
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> word(0, words.size() - 1);
+    std::uniform_int_distribution<int> number(0, 100000);
+    std::string res;
+    res.reserve(size + 32);
+    while (res.size() < size) {
+        res += words[word(gen)] + std::to_string(number(gen));
+    }
+    res.resize(size);
+    return res;
+}
+
+template <typename F>
+static double time_it(const F& fun) {
+    const auto begin = std::chrono::steady_clock::now();
+    fun();
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+    return duration.count();
+}
+
+static void report(const std::string& name, size_t size, double duration) {
+    std::cout << name << ": " << duration << "s, " << size / duration / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t size_mb = 0, nb_threads = 0, block_size = 0;
+    po::options_description desc("LZ4 formats throughput benchmark");
+    // clang-format off
+    desc.add_options()
+        ("help,h", "Show this message")
+        ("size,s", po::value<size_t>(&size_mb)->default_value(256), "Size of the uncompressed data, in MB")
+        ("threads,t", po::value<size_t>(&nb_threads)->default_value(lz4_frame::default_nb_threads()),
+            "Number of threads of the framed format")
+        ("block,b", po::value<size_t>(&block_size)->default_value(4 * 1024 * 1024),
+            "Size of the blocks of the framed format");
+    // clang-format on
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    const auto data = generate(size_mb * 1024 * 1024);
+
+    std::stringstream stream_format;
+    report("stream format compression", data.size(), time_it([&]() {
+               boost::iostreams::filtering_ostream out;
+               out.push(LZ4Compressor(2048 * 500), 1024 * 500, 1024 * 500);
+               out.push(stream_format);
+               out.write(data.data(), data.size());
+           }));
+    std::string result(data.size(), '\0');
+    report("stream format decompression", data.size(), time_it([&]() {
+               boost::iostreams::filtering_istream in;
+               in.push(LZ4Decompressor(2048 * 500), 8192 * 500, 8192 * 500);
+               in.push(stream_format);
+               in.read(&result[0], result.size());
+           }));
+    if (result != data) {
+        std::cerr << "stream format round trip failed" << std::endl;
+        return 1;
+    }
+
+    std::stringstream framed_format;
+    report("framed format compression", data.size(), time_it([&]() {
+               lz4_frame::Writer writer(framed_format, block_size, true, nb_threads);
+               writer.write(data.data(), data.size());
+               writer.finish();
+           }));
+    std::vector<char> framed_result;
+    report("framed format decompression", data.size(),
+           time_it([&]() { framed_result = lz4_frame::read(framed_format, nb_threads); }));
+    if (std::string(framed_result.begin(), framed_result.end()) != data) {
+        std::cerr << "framed format round trip failed" << std::endl;
+        return 1;
+    }
+    std::cout << "stream format size: " << stream_format.str().size()
+              << ", framed format size: " << framed_format.str().size() << std::endl;
+    return 0;
+}
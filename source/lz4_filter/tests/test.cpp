@@ -36,6 +36,8 @@ www.navitia.io
 #include <boost/iostreams/device/file_descriptor.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/device/file.hpp>
+#include <iterator>
+#include <sstream>
 #include <string>
 
 BOOST_AUTO_TEST_CASE(tiny_string_compression) {
@@ -95,3 +97,73 @@ BOOST_AUTO_TEST_CASE(big_string_compression) {
     }
     BOOST_CHECK_EQUAL(str, result);
 }
+
+static std::string make_frame(const std::string& str, size_t block_size, bool checksums, size_t nb_threads) {
+    std::stringstream ss;
+    lz4_frame::Writer writer(ss, block_size, checksums, nb_threads);
+    {
+        boost::iostreams::filtering_ostream out;
+        out.push(writer.sink());
+        out << str;
+    }
+    writer.finish();
+    return ss.str();
+}
+
+BOOST_AUTO_TEST_CASE(frame_compression) {
+    std::string str = "foobariozafiozehfuiozefuigaezgfuzegfpuzheuerfhzeupgf";
+    for (int i = 0; i < 10; i++) {
+        str += str;
+    }
+    // several batches of several blocks, the last one being smaller
+    for (size_t nb_threads : {1, 3}) {
+        std::stringstream ss(make_frame(str, 1000, true, nb_threads));
+        BOOST_CHECK(lz4_frame::is_frame(ss));
+        const auto result = lz4_frame::read(ss, nb_threads);
+        BOOST_CHECK_EQUAL(std::string(result.begin(), result.end()), str);
+    }
+
+    // read as a stream, a batch of blocks at a time
+    std::stringstream framed(make_frame(str, 1000, true, 2));
+    lz4_frame::Reader reader(framed, 2);
+    BOOST_CHECK_EQUAL(reader.size(), str.size());
+    std::istream in(&reader);
+    const std::string streamed{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    BOOST_CHECK_EQUAL(streamed, str);
+
+    std::stringstream empty(make_frame("", 1000, false, 2));
+    BOOST_CHECK(lz4_frame::is_frame(empty));
+    BOOST_CHECK(lz4_frame::read(empty).empty());
+}
+
+BOOST_AUTO_TEST_CASE(stream_is_not_a_frame) {
+    std::stringstream ss;
+    {
+        boost::iostreams::filtering_ostream out;
+        out.push(LZ4Compressor());
+        out.push(ss);
+        out << "foo";
+    }
+    BOOST_CHECK(!lz4_frame::is_frame(ss));
+    std::string result;
+    boost::iostreams::filtering_istream in;
+    in.push(LZ4Decompressor());
+    in.push(ss);
+    in >> result;
+    BOOST_CHECK_EQUAL(result, "foo");
+
+    std::stringstream too_short("fo");
+    BOOST_CHECK(!lz4_frame::is_frame(too_short));
+}
+
+BOOST_AUTO_TEST_CASE(frame_corruption_is_detected) {
+    const std::string str(5000, 'a');
+    auto frame = make_frame(str, 1000, true, 2);
+    // the data of the first block is right after the header
+    frame[lz4_frame::header_size + 5] ^= 1;
+    std::stringstream ss(frame);
+    BOOST_CHECK_THROW(lz4_frame::read(ss), std::runtime_error);
+
+    std::stringstream truncated(make_frame(str, 1000, true, 2).substr(0, 100));
+    BOOST_CHECK_THROW(lz4_frame::read(truncated), std::runtime_error);
+}
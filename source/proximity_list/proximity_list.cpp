@@ -75,7 +75,7 @@ void ProximityList<T>::build() {
     LOG4CPLUS_INFO(logger, "Building Proximitylist's NN index with " << items.size() << " items");
 
     // clean NN index
-    NN_data.clear();
+    NN_data = std::make_shared<const std::vector<float>>();
     NN_index.reset();
 
     if (items.empty()) {
@@ -83,15 +83,55 @@ void ProximityList<T>::build() {
         return;
     }
 
+    auto data = std::make_shared<std::vector<float>>();
+    data->reserve(items.size() * 3);
     for (const auto& i : items) {
         auto projected = project_coord(i.coord);
-        std::copy(projected.begin(), projected.end(), std::back_inserter(NN_data));
+        std::copy(projected.begin(), projected.end(), std::back_inserter(*data));
     }
-    auto points = flann::Matrix<float>{&NN_data[0], NN_data.size() / 3, 3};
+    NN_data = data;
+    build_index(NN_data->data(), NN_data->size() / 3);
+}
+
+template <class T>
+void ProximityList<T>::build_index(const float* data, size_t nb_points) {
+    // flann doesn't modify nor copy the points, thus they can be read-only mapped memory
+    auto points = flann::Matrix<float>{const_cast<float*>(data), nb_points, 3};
     NN_index = std::make_shared<navitia::proximitylist::index_t>(points, flann::KDTreeSingleIndexParams(10));
     NN_index->buildIndex();
 }
 
+template <class T>
+bool ProximityList<T>::build_from_flat(const std::shared_ptr<const type::FlatNav>& flat,
+                                       const std::string& name,
+                                       const boost::optional<size_t>& expected_nb_items) {
+    log4cplus::Logger logger = log4cplus::Logger::getInstance("log");
+    const auto flat_items_section = flat->get<Item>(name + ".items");
+    const auto flat_NN_data_section = flat->get<float>(name + ".nn_data");
+    if (!flat_items_section || !flat_NN_data_section
+        || flat_NN_data_section->size() != flat_items_section->size() * 3
+        || (expected_nb_items && flat_items_section->size() != *expected_nb_items)) {
+        LOG4CPLUS_WARN(logger, "Proximitylist " << name << " not found in the flat nav");
+        return false;
+    }
+
+    clear();
+    flat_items = *flat_items_section;
+    flat_NN_data = *flat_NN_data_section;
+    flat_nav = flat;
+    LOG4CPLUS_INFO(logger, "Building Proximitylist's NN index with " << flat_items.size() << " mapped items");
+    if (!flat_items.empty()) {
+        build_index(flat_NN_data.data(), flat_items.size());
+    }
+    return true;
+}
+
+template <class T>
+void ProximityList<T>::save_flat(type::FlatNavWriter& writer, const std::string& name) const {
+    writer.add(name + ".items", get_items());
+    writer.add(name + ".nn_data", flat_nav ? flat_NN_data : type::FlatArray<float>(*NN_data));
+}
+
 template <typename T, typename Items, typename Indices, typename Distances, typename Out, typename F>
 static void make_result(const type::GeographicalCoord& coord,
                         const Items& items,
@@ -161,7 +201,7 @@ auto ProximityList<T>::find_within_impl(const GeographicalCoord& coord,
 
     std::vector<typename ReturnTypeTrait<T, IndexCoord>::ValueType> res;
     auto op = [](const Item& item, float /*unused*/) { return std::make_pair(item.element, item.coord); };
-    make_result<T>(coord, items, indices[0], distances[0], nb_found, res, op);
+    make_result<T>(coord, get_items(), indices[0], distances[0], nb_found, res, op);
 
     return res;
 }
@@ -181,7 +221,7 @@ auto ProximityList<T>::find_within_impl(const GeographicalCoord& coord,
 
     std::vector<typename ReturnTypeTrait<T, IndexCoordDistance>::ValueType> res;
     auto op = [](const Item& item, float distance) { return std::make_tuple(item.element, item.coord, distance); };
-    make_result<T>(coord, items, indices[0], distances[0], nb_found, res, op);
+    make_result<T>(coord, get_items(), indices[0], distances[0], nb_found, res, op);
 
     return res;
 }
@@ -202,7 +242,7 @@ auto ProximityList<T>::find_within_impl(const GeographicalCoord& coord,
 
     std::vector<typename ReturnTypeTrait<T, IndexOnly>::ValueType> res;
     auto op = [](const Item& item, float /*unused*/) { return item.element; };
-    make_result<T>(coord, items, indices_data, distances_data, nb_found, res, op);
+    make_result<T>(coord, get_items(), indices_data, distances_data, nb_found, res, op);
 
     return res;
 }
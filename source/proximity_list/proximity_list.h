@@ -30,6 +30,7 @@ www.navitia.io
 
 #pragma once
 
+#include "type/flat_nav.h"
 #include "type/geographical_coord.h"
 #include "utils/exception.h"
 #include "utils/logger.h"
@@ -106,19 +107,54 @@ struct ProximityList {
 
     /// Contient toutes les coordonnées de manière à trouver rapidement
     std::vector<Item> items;
-    std::vector<float> NN_data;
+    // shared with the index, that only points to it
+    std::shared_ptr<const std::vector<float>> NN_data = std::make_shared<const std::vector<float>>();
     std::shared_ptr<index_t> NN_index = nullptr;
 
+    // When built from a flat nav file, the items and the NN data are
+    // read in place from its mapping instead of the vectors above
+    type::FlatArray<Item> flat_items;
+    type::FlatArray<float> flat_NN_data;
+    std::shared_ptr<const type::FlatNav> flat_nav;
+
     /// Rajoute un nouvel élément. Attention, il faut appeler build avant de pouvoir utiliser la structure
     void add(GeographicalCoord coord, T element) { items.push_back(Item(coord, element)); }
     void clear() {
         items.clear();
-        NN_data.clear();
+        NN_data = std::make_shared<const std::vector<float>>();
+        NN_index.reset();
+        flat_items = {};
+        flat_NN_data = {};
+        flat_nav.reset();
     }
 
+    type::FlatArray<Item> get_items() const { return flat_nav ? flat_items : type::FlatArray<Item>(items); }
+
     // build the Nearest Neighbours data from items, then the index
     void build();
 
+    // share the index of other, that must have the same items
+    void share_index(const ProximityList& other) {
+        NN_data = other.NN_data;
+        NN_index = other.NN_index;
+        flat_items = other.flat_items;
+        flat_NN_data = other.flat_NN_data;
+        flat_nav = other.flat_nav;
+    }
+
+    /*
+     * build the index on the items and NN data saved under name in the flat nav.
+     *
+     * Returns false, leaving the list untouched, if they are missing or
+     * don't have the expected number of items.
+     */
+    bool build_from_flat(const std::shared_ptr<const type::FlatNav>& flat_nav,
+                         const std::string& name,
+                         const boost::optional<size_t>& expected_nb_items = boost::none);
+
+    // add the items and NN data under name to the flat nav, the list must be built
+    void save_flat(type::FlatNavWriter& writer, const std::string& name) const;
+
     /*
      * This method can return three types of result
      *
@@ -156,7 +192,13 @@ struct ProximityList {
      */
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
-        ar& items;
+        // built from a flat nav, the items are in its mapping
+        if (Archive::is_saving::value && flat_nav) {
+            std::vector<Item> mapped_items(flat_items.begin(), flat_items.end());
+            ar& mapped_items;
+        } else {
+            ar& items;
+        }
     }
 
 private:
@@ -183,6 +225,8 @@ private:
      * */
     auto find_within_impl(const GeographicalCoord& coord, const double radius, const int size, IndexOnly) const
         -> std::vector<typename ReturnTypeTrait<T, IndexOnly>::ValueType>;
+
+    void build_index(const float* data, size_t nb_points);
 };
 
 }  // namespace proximitylist
@@ -47,7 +47,9 @@ www.navitia.io
 #include <boost/progress.hpp>
 
 #include <fstream>
+#include <memory>
 #include <random>
+#include <vector>
 
 using namespace navitia;
 using namespace routing;
@@ -133,11 +135,26 @@ static type::EntryPoint make_entry_point(const std::string& entry_id, const type
     return entry;
 }
 
+static bool same_journeys(const pbnavitia::Response& lhs, const pbnavitia::Response& rhs) {
+    if (lhs.journeys_size() != rhs.journeys_size()) {
+        return false;
+    }
+    for (int i = 0; i < lhs.journeys_size(); ++i) {
+        if (lhs.journeys(i).SerializeAsString() != rhs.journeys(i).SerializeAsString()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char** argv) {
     navitia::init_app();
     po::options_description desc("Benchmark tool options");
     std::string data_file, benchmark_output_file, requests_input_file, requests_output_file;
     int iterations, nb_second_pass;
+    bool full_sweep, compare_scan;
+    size_t nb_threads;
+    std::vector<size_t> compare_threads;
 
     // clang-format off
     desc.add_options()
@@ -149,6 +166,16 @@ int main(int argc, char** argv) {
                      "Path to data.nav.lz4")
             ("verbose,v", "Verbose debugging output.")
             ("nb_second_pass", po::value<int>(&nb_second_pass)->default_value(0), "nb second pass")
+            ("full_sweep", po::bool_switch(&full_sweep),
+                     "At each raptor round, scan all the journey patterns instead of only the marked ones.")
+            ("compare_scan", po::bool_switch(&compare_scan),
+                     "Compute each request twice, scanning only the marked journey patterns and sweeping all of them, "
+                     "check that the results are identical and display the computing time of both.")
+            ("nb_threads", po::value<size_t>(&nb_threads)->default_value(1),
+                     "Number of threads scanning the journey patterns of a raptor round.")
+            ("compare_threads", po::value<std::vector<size_t>>(&compare_threads)->multitoken(),
+                     "Compute each request again with each given number of threads (for example --compare_threads 1 4 16), "
+                     "check that the results are identical and display the computing time of each.")
             ("requests", po::value<std::string>(&requests_input_file),
                         "List of requests to benchmark on.\n"
                         "Must be a comma-separated csv file where the first 3 columns are :  start point uri, target point uri, departure posix time.\n"
@@ -252,7 +279,16 @@ int main(int argc, char** argv) {
     // Journeys computation
     std::vector<Result> results;
     data.build_raptor();
-    RAPTOR raptor(data);
+    ThreadPool thread_pool(nb_threads);
+    RAPTOR raptor(data, !full_sweep, &thread_pool);
+    RAPTOR other_scan_raptor(data, full_sweep, &thread_pool);
+    std::vector<std::unique_ptr<ThreadPool>> compared_thread_pools;
+    std::vector<std::unique_ptr<RAPTOR>> threads_raptors;
+    for (const auto n : compare_threads) {
+        compared_thread_pools.push_back(std::make_unique<ThreadPool>(n));
+        threads_raptors.push_back(std::make_unique<RAPTOR>(data, !full_sweep, compared_thread_pools.back().get()));
+    }
+    std::vector<int> total_threads_ms(compare_threads.size(), 0);
     auto georef_worker = georef::StreetNetwork(*data.geo_ref);
 
     // disabling logging, to not pollute std::cout
@@ -261,9 +297,42 @@ int main(int argc, char** argv) {
     auto logger_raptor = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("raptor"));
     logger_raptor.setLogLevel(log4cplus::WARN_LOG_LEVEL);
 
+    const auto compute = [&](RAPTOR& planner, const Request& request) {
+        type::EntryPoint origin = make_entry_point(request.start, data);
+        type::EntryPoint destination = make_entry_point(request.target, data);
+
+        origin.streetnetwork_params.mode = request.start_mode;
+        origin.streetnetwork_params.offset = data.geo_ref->offsets[request.start_mode];
+        origin.streetnetwork_params.max_duration = navitia::seconds(30 * 60);
+        origin.streetnetwork_params.speed_factor = 1;
+        destination.streetnetwork_params.mode = request.target_mode;
+        destination.streetnetwork_params.offset = data.geo_ref->offsets[request.target_mode];
+        destination.streetnetwork_params.max_duration = navitia::seconds(30 * 60);
+        destination.streetnetwork_params.speed_factor = 1;
+        type::AccessibiliteParams accessibilite_params;
+        navitia::PbCreator pb_creator(&data, boost::gregorian::not_a_date_time, null_time_period);
+
+        int days_since_epoch = (request.departure_posix_time.date() - boost::gregorian::date(1970, 1, 1)).days();
+        int total_second_in_day = request.departure_posix_time.time_of_day().total_seconds();
+
+        const DateTime departure_datetime = DateTimeUtils::set(days_since_epoch, total_second_in_day);
+        make_response(pb_creator, planner, origin, destination, {departure_datetime},
+                      true,                      // clockwise ?
+                      accessibilite_params, {},  // forbidden
+                      {},                        // allowed
+                      georef_worker,
+                      type::RTLevel::Base,             // real time level
+                      2_min,                           // transfer penalty
+                      DateTimeUtils::SECONDS_PER_DAY,  // max_duration
+                      10,                              // max_transfers
+                      nb_second_pass);
+        return pb_creator.get_response();
+    };
+
     std::cout << "Launching benchmark " << std::endl;
     boost::progress_display show_progress(requests.size());
-    int nb_reponses = 0, nb_journeys = 0;
+    int nb_reponses = 0, nb_journeys = 0, nb_scan_mismatches = 0;
+    int total_ms = 0, total_other_scan_ms = 0;
     {
         Timer total_compute_timer("Total computing time");
         // ProfilerStart("bench.prof");
@@ -279,43 +348,38 @@ int main(int argc, char** argv) {
                 std::cout << request.start << ", " << request.target << ", " << request.departure_posix_time << "\n";
             }
 
-            type::EntryPoint origin = make_entry_point(request.start, data);
-            type::EntryPoint destination = make_entry_point(request.target, data);
-
-            origin.streetnetwork_params.mode = request.start_mode;
-            origin.streetnetwork_params.offset = data.geo_ref->offsets[request.start_mode];
-            origin.streetnetwork_params.max_duration = navitia::seconds(30 * 60);
-            origin.streetnetwork_params.speed_factor = 1;
-            destination.streetnetwork_params.mode = request.target_mode;
-            destination.streetnetwork_params.offset = data.geo_ref->offsets[request.target_mode];
-            destination.streetnetwork_params.max_duration = navitia::seconds(30 * 60);
-            destination.streetnetwork_params.speed_factor = 1;
-            type::AccessibiliteParams accessibilite_params;
-            navitia::PbCreator pb_creator(&data, boost::gregorian::not_a_date_time, null_time_period);
-
-            int days_since_epoch = (request.departure_posix_time.date() - boost::gregorian::date(1970, 1, 1)).days();
-            int total_second_in_day = request.departure_posix_time.time_of_day().total_seconds();
-
-            const DateTime departure_datetime = DateTimeUtils::set(days_since_epoch, total_second_in_day);
-            make_response(pb_creator, raptor, origin, destination, {departure_datetime},
-                          true,                      // clockwise ?
-                          accessibilite_params, {},  // forbidden
-                          {},                        // allowed
-                          georef_worker,
-                          type::RTLevel::Base,             // real time level
-                          2_min,                           // transfer penalty
-                          DateTimeUtils::SECONDS_PER_DAY,  // max_duration
-                          10,                              // max_transfers
-                          nb_second_pass);
-            auto resp = pb_creator.get_response();
+            auto resp = compute(raptor, request);
 
             Result result(resp.journeys().size(), t2.ms());
             results.push_back(result);
+            total_ms += result.computing_time_in_ms;
 
             if (resp.journeys_size() > 0) {
                 ++nb_reponses;
                 nb_journeys += resp.journeys_size();
             }
+
+            if (compare_scan) {
+                Timer t3;
+                const auto other_resp = compute(other_scan_raptor, request);
+                total_other_scan_ms += t3.ms();
+                if (!same_journeys(resp, other_resp)) {
+                    ++nb_scan_mismatches;
+                    std::cout << "different results between scan modes for " << request.start << ", "
+                              << request.target << ", " << request.departure_posix_time << std::endl;
+                }
+            }
+
+            for (size_t i = 0; i < threads_raptors.size(); ++i) {
+                Timer t4;
+                const auto threads_resp = compute(*threads_raptors[i], request);
+                total_threads_ms[i] += t4.ms();
+                if (!same_journeys(resp, threads_resp)) {
+                    ++nb_scan_mismatches;
+                    std::cout << "different results with " << compare_threads[i] << " threads for " << request.start
+                              << ", " << request.target << ", " << request.departure_posix_time << std::endl;
+                }
+            }
         }
         // ProfilerStop();
 #ifdef __BENCH_WITH_CALGRIND__
@@ -339,4 +403,20 @@ int main(int argc, char** argv) {
     std::cout << "Number of requests: " << requests.size() << std::endl;
     std::cout << "Number of results with solution: " << nb_reponses << std::endl;
     std::cout << "Number of journey found: " << nb_journeys << std::endl;
+    if (compare_scan) {
+        std::cout << "Computing time " << (full_sweep ? "sweeping all" : "scanning marked")
+                  << " journey patterns: " << total_ms << "ms" << std::endl;
+        std::cout << "Computing time " << (full_sweep ? "scanning marked" : "sweeping all")
+                  << " journey patterns: " << total_other_scan_ms << "ms" << std::endl;
+    }
+    if (!compare_threads.empty()) {
+        std::cout << "Computing time with " << nb_threads << " thread(s): " << total_ms << "ms" << std::endl;
+        for (size_t i = 0; i < compare_threads.size(); ++i) {
+            std::cout << "Computing time with " << compare_threads[i] << " thread(s): " << total_threads_ms[i] << "ms"
+                      << std::endl;
+        }
+    }
+    if (compare_scan || !compare_threads.empty()) {
+        std::cout << "Number of requests with different results: " << nb_scan_mismatches << std::endl;
+    }
 }
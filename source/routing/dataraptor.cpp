@@ -33,8 +33,6 @@ www.navitia.io
 #include "routing.h"
 #include "routing/raptor_utils.h"
 
-#include <boost/range/algorithm_ext.hpp>
-
 namespace navitia {
 namespace routing {
 
@@ -70,12 +68,6 @@ void dataRAPTOR::JppsFromSp::load(const type::PT_Data& data, const JourneyPatter
     }
 }
 
-void dataRAPTOR::JppsFromSp::filter_jpps(const boost::dynamic_bitset<>& valid_jpps) {
-    for (auto& jpps : jpps_from_sp.values()) {
-        boost::remove_erase_if(jpps, [&](const Jpp& jpp) { return !valid_jpps[jpp.idx.val]; });
-    }
-}
-
 void dataRAPTOR::JppsFromJp::load(const JourneyPatternContainer& jp_container) {
     jpps_from_jp.assign(jp_container.get_jps_values());
     for (const auto jp : jp_container.get_jps()) {
@@ -90,25 +82,78 @@ void dataRAPTOR::JppsFromJp::load(const JourneyPatternContainer& jp_container) {
     }
 }
 
+void dataRAPTOR::JpStopTimes::load(const type::PT_Data& data, const JourneyPatternContainer& jp_container) {
+    size_t nb_stop_times = 0;
+    for (const auto* vj : data.vehicle_journeys) {
+        nb_stop_times += vj->stop_time_list.size();
+    }
+    stop_times.clear();
+    stop_times.reserve(nb_stop_times);
+    type_stop_times.clear();
+    type_stop_times.reserve(nb_stop_times);
+    first_stop_time.assign(data.vehicle_journeys, std::numeric_limits<uint32_t>::max());
+    for (const auto& jp : jp_container.get_jps_values()) {
+        jp.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
+            first_stop_time[VjIdx(vj)] = stop_times.size();
+            for (const auto& st : vj.stop_time_list) {
+                stop_times.push_back({st.boarding_time, st.alighting_time, st.local_traffic_zone,
+                                      st.pick_up_allowed(), st.drop_off_allowed()});
+                type_stop_times.push_back(&st);
+            }
+            return true;
+        });
+    }
+    stop_times.shrink_to_fit();
+    type_stop_times.shrink_to_fit();
+}
+
 void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size) {
     jp_container.load(data);
-    labels_const.init_inf(data.stop_points);
-    labels_const_reverse.init_min(data.stop_points);
-
-    connections.load(data);
-    jpps_from_sp.load(data, jp_container);
-    jpps_from_jp.load(jp_container);
     next_stop_time_data.load(jp_container);
+    for (auto level_cont : jp_validity_patterns) {
+        level_cont.second.clear();
+    }
+    load_jp_validity_patterns(boost::dynamic_bitset<>(jp_container.nb_jps()).set());
+    load_from_jps(data, cache_size);
+}
 
+void dataRAPTOR::load(const type::PT_Data& data,
+                      const dataRAPTOR& previous,
+                      const std::set<std::string>& modified_meta_vjs,
+                      size_t cache_size) {
+    // realtime neither creates stop points nor removes routes or physical modes
+    const auto& prev_jp_container = previous.jp_container;
+    if (data.stop_points.size() != previous.connections.forward_connections.size()
+        || data.routes.size() < prev_jp_container.get_jps_from_route().size()
+        || data.physical_modes.size() < prev_jp_container.get_jps_from_phy_mode().size()) {
+        load(data, cache_size);
+        return;
+    }
+
+    const auto modified_jps = jp_container.load(data, prev_jp_container, modified_meta_vjs);
+    next_stop_time_data.load(jp_container, previous.next_stop_time_data, prev_jp_container, modified_jps);
+    for (auto level_cont : jp_validity_patterns) {
+        level_cont.second = previous.jp_validity_patterns[level_cont.first];
+    }
+    load_jp_validity_patterns(modified_jps);
+    load_from_jps(data, cache_size);
+}
+
+void dataRAPTOR::load_jp_validity_patterns(const boost::dynamic_bitset<>& jps_to_load) {
     for (auto level_cont : jp_validity_patterns) {
         const auto rt_level = level_cont.first;
         auto& jp_vp = level_cont.second;
-        jp_vp.assign(366, boost::dynamic_bitset<>(jp_container.nb_jps()));
-        for (const auto jp : jp_container.get_jps()) {
-            for (int i = 0; i <= 365; ++i) {
-                jp.second.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
-                    if (vj.validity_patterns[rt_level]->check2(i)) {
-                        jp_vp[i].set(jp.first.val);
+        jp_vp.resize(366);
+        for (auto& day_jps : jp_vp) {
+            day_jps.resize(jp_container.nb_jps());
+            day_jps -= jps_to_load;
+        }
+        for (auto i = jps_to_load.find_first(); i != boost::dynamic_bitset<>::npos; i = jps_to_load.find_next(i)) {
+            const auto& jp = jp_container.get(JpIdx(i));
+            for (int day = 0; day <= 365; ++day) {
+                jp.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
+                    if (vj.validity_patterns[rt_level]->check2(day)) {
+                        jp_vp[day].set(i);
                         return false;
                     }
                     return true;
@@ -116,6 +161,17 @@ void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size) {
             }
         }
     }
+}
+
+void dataRAPTOR::load_from_jps(const type::PT_Data& data, size_t cache_size) {
+    labels_const.init_inf(data.stop_points);
+    labels_const_reverse.init_min(data.stop_points);
+
+    // these structures only index the jps, their load is linear
+    connections.load(data);
+    jpps_from_sp.load(data, jp_container);
+    jpps_from_jp.load(jp_container);
+    jp_stop_times.load(data, jp_container);
 
     min_connection_time = std::numeric_limits<uint32_t>::max();
     for (const auto conns : connections.forward_connections) {
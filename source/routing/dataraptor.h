@@ -31,6 +31,7 @@ www.navitia.io
 #pragma once
 #include "type/pt_data.h"
 #include "type/datetime.h"
+#include "type/stop_time.h"
 #include "routing/raptor_utils.h"
 #include "utils/idx_map.h"
 #include "routing/next_stop_time.h"
@@ -38,6 +39,7 @@ www.navitia.io
 
 #include <boost/foreach.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/range/adaptor/filtered.hpp>
 
 namespace navitia {
 namespace routing {
@@ -71,7 +73,6 @@ struct dataRAPTOR {
         };
         inline const std::vector<Jpp>& operator[](const SpIdx& sp) const { return jpps_from_sp[sp]; }
         void load(const type::PT_Data&, const JourneyPatternContainer&);
-        void filter_jpps(const boost::dynamic_bitset<>& valid_jpps);
 
         inline IdxMap<type::StopPoint, std::vector<Jpp>>::const_iterator begin() const { return jpps_from_sp.begin(); }
         inline IdxMap<type::StopPoint, std::vector<Jpp>>::const_iterator end() const { return jpps_from_sp.end(); }
@@ -81,6 +82,33 @@ struct dataRAPTOR {
     };
     JppsFromSp jpps_from_sp;
 
+    // view of a JppsFromSp only showing the valid JourneyPatternPoints
+    // of a query.  Invalidating a jpp only costs a bit, whereas
+    // filtering a copy of the JppsFromSp would cost the whole
+    // structure at each query.
+    struct FilteredJppsFromSp {
+        struct IsValid {
+            const boost::dynamic_bitset<>* valid_jpps;
+            inline bool operator()(const JppsFromSp::Jpp& jpp) const { return (*valid_jpps)[jpp.idx.val]; }
+        };
+        using Range = boost::filtered_range<IsValid, const std::vector<JppsFromSp::Jpp>>;
+
+        // all the jpps are valid at construction
+        FilteredJppsFromSp(const JppsFromSp& jpps_from_sp, size_t nb_jpps)
+            : valid_jpps(nb_jpps), jpps_from_sp(&jpps_from_sp) {
+            valid_jpps.set();
+        }
+        inline Range operator[](const SpIdx& sp) const {
+            return boost::adaptors::filter((*jpps_from_sp)[sp], IsValid{&valid_jpps});
+        }
+
+        // valid_jpps[jpp_idx.val] is true iff the jpp is shown
+        boost::dynamic_bitset<> valid_jpps;
+
+    private:
+        const JppsFromSp* jpps_from_sp;
+    };
+
     // cache friendly access to in order JourneyPatternPoints from a JourneyPattern
     struct JppsFromJp {
         // compressed JourneyPatternPoint
@@ -97,6 +125,48 @@ struct dataRAPTOR {
     };
     JppsFromJp jpps_from_jp;
 
+    // cache friendly access to the times and properties of the stop
+    // times used by the raptor inner loop.  The stop times of the
+    // vehicle journeys of a journey pattern are contiguous, each
+    // vehicle journey being a block in the order of its stop times.
+    struct JpStopTimes {
+        // compressed StopTime
+        struct StopTime {
+            uint32_t boarding_time;
+            uint32_t alighting_time;
+            uint16_t local_traffic_zone;
+            bool pick_up_allowed;
+            bool drop_off_allowed;
+
+            // same as type::StopTime::section_end
+            inline DateTime section_end(DateTime base_dt, bool clockwise) const {
+                return base_dt + (clockwise ? alighting_time : boarding_time);
+            }
+            // same as type::StopTime::valid_end
+            inline bool valid_end(bool clockwise) const { return clockwise ? drop_off_allowed : pick_up_allowed; }
+        };
+        using const_iterator = std::vector<StopTime>::const_iterator;
+
+        // Returns the compressed stop time corresponding to st
+        inline const_iterator get(const type::StopTime& st) const { return stop_times.begin() + index(st); }
+        // Returns the index of st in the compressed stop times, a
+        // compact replacement of a pointer to st
+        inline uint32_t index(const type::StopTime& st) const {
+            return first_stop_time[VjIdx(*st.vehicle_journey)] + st.order().val;
+        }
+        // Returns the stop time of the given index
+        inline const type::StopTime* stop_time(const uint32_t idx) const { return type_stop_times[idx]; }
+        void load(const type::PT_Data&, const JourneyPatternContainer&);
+
+    private:
+        std::vector<StopTime> stop_times;
+        // type_stop_times[i] is the stop time compressed in stop_times[i]
+        std::vector<const type::StopTime*> type_stop_times;
+        // index in stop_times of the first stop time of each vehicle journey
+        IdxMap<type::VehicleJourney, uint32_t> first_stop_time;
+    };
+    JpStopTimes jp_stop_times;
+
     NextStopTimeData next_stop_time_data;
     std::unique_ptr<CachedNextStopTimeManager> cached_next_st_manager;
 
@@ -111,8 +181,20 @@ struct dataRAPTOR {
 
     dataRAPTOR() {}
     void load(const navitia::type::PT_Data&, size_t cache_size = 10);
+    // Loads from previous, loaded with the data pt_data has been cloned
+    // from: only the jps of the vjs of the given meta vjs are rebuilt.
+    void load(const navitia::type::PT_Data& pt_data,
+              const dataRAPTOR& previous,
+              const std::set<std::string>& modified_meta_vjs,
+              size_t cache_size = 10);
 
     void warmup(const dataRAPTOR& other);
+
+private:
+    // loads everything but the jps and the next stop times
+    void load_from_jps(const navitia::type::PT_Data&, size_t cache_size);
+    // computes the validity of the given jps, the other ones being kept
+    void load_jp_validity_patterns(const boost::dynamic_bitset<>& jps_to_load);
 };
 
 }  // namespace routing
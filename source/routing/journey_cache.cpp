@@ -0,0 +1,165 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "journey_cache.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace navitia {
+namespace routing {
+
+static std::vector<std::pair<uint32_t, int64_t>> to_vector(const map_stop_point_duration& sp_durations) {
+    // a flat_map is already sorted, thus the result is normalized
+    std::vector<std::pair<uint32_t, int64_t>> result;
+    result.reserve(sp_durations.size());
+    for (const auto& sp_duration : sp_durations) {
+        result.emplace_back(sp_duration.first.val, sp_duration.second.total_seconds());
+    }
+    return result;
+}
+
+JourneyCache::Key::Key(const map_stop_point_duration& departures,
+                       const map_stop_point_duration& destinations,
+                       std::vector<DateTime> datetimes,
+                       const type::RTLevel rt_level,
+                       const navitia::time_duration& transfer_penalty,
+                       const type::AccessibiliteParams& accessibilite_params,
+                       std::vector<std::string> forbidden,
+                       std::vector<std::string> allowed,
+                       const bool clockwise,
+                       const boost::optional<navitia::time_duration>& direct_path_duration,
+                       const boost::optional<uint32_t>& min_nb_journeys,
+                       const uint32_t nb_direct_path,
+                       const uint32_t max_duration,
+                       const uint32_t max_transfers,
+                       const size_t max_extra_second_pass,
+                       const double night_bus_filter_max_factor,
+                       const int32_t night_bus_filter_base_factor,
+                       const boost::optional<uint32_t>& timeframe_duration)
+    : departures(to_vector(departures)),
+      destinations(to_vector(destinations)),
+      datetimes(std::move(datetimes)),
+      rt_level(rt_level),
+      transfer_penalty(transfer_penalty.total_seconds()),
+      properties(accessibilite_params.properties.to_ulong()),
+      vehicle_properties(accessibilite_params.vehicle_properties.to_ulong()),
+      forbidden(std::move(forbidden)),
+      allowed(std::move(allowed)),
+      clockwise(clockwise),
+      min_nb_journeys(min_nb_journeys),
+      nb_direct_path(nb_direct_path),
+      max_duration(max_duration),
+      max_transfers(max_transfers),
+      max_extra_second_pass(max_extra_second_pass),
+      night_bus_filter_max_factor(night_bus_filter_max_factor),
+      night_bus_filter_base_factor(night_bus_filter_base_factor),
+      timeframe_duration(timeframe_duration) {
+    if (direct_path_duration) {
+        this->direct_path_duration = direct_path_duration->total_seconds();
+    }
+    // the order of the uris has no influence on the result
+    std::sort(this->forbidden.begin(), this->forbidden.end());
+    std::sort(this->allowed.begin(), this->allowed.end());
+}
+
+bool JourneyCache::Key::operator<(const Key& other) const {
+    const auto tie = [](const Key& k) {
+        return std::tie(k.departures, k.destinations, k.datetimes, k.rt_level, k.transfer_penalty, k.properties,
+                        k.vehicle_properties, k.forbidden, k.allowed, k.clockwise, k.direct_path_duration,
+                        k.min_nb_journeys, k.nb_direct_path, k.max_duration, k.max_transfers,
+                        k.max_extra_second_pass, k.night_bus_filter_max_factor, k.night_bus_filter_base_factor,
+                        k.timeframe_duration);
+    };
+    return tie(*this) < tie(other);
+}
+
+bool JourneyCache::set_data_identifier(const size_t identifier) {
+    if (identifier < data_identifier) {
+        return false;
+    }
+    if (identifier > data_identifier) {
+        // the data has been swapped: the cached pathes point into the old one
+        entries.clear();
+        index.clear();
+        data_identifier = identifier;
+    }
+    return true;
+}
+
+std::shared_ptr<const JourneyCache::Value> JourneyCache::get(const size_t identifier, const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!set_data_identifier(identifier)) {
+        ++pending_misses;
+        return nullptr;
+    }
+    const auto it = index.find(key);
+    if (it == index.end()) {
+        ++pending_misses;
+        return nullptr;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    ++pending_hits;
+    return it->second->second;
+}
+
+void JourneyCache::add(const size_t identifier, const Key& key, Value value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (max_size == 0 || !set_data_identifier(identifier)) {
+        return;
+    }
+    const auto it = index.find(key);
+    if (it != index.end()) {
+        // computed concurrently by another worker
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    entries.emplace_front(key, std::make_shared<const Value>(std::move(value)));
+    index.emplace(key, entries.begin());
+    if (entries.size() > max_size) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+size_t JourneyCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+JourneyCache::Report JourneyCache::take_report() {
+    Report report;
+    report.nb_hits = pending_hits.exchange(0);
+    report.nb_misses = pending_misses.exchange(0);
+    return report;
+}
+
+}  // namespace routing
+}  // namespace navitia
@@ -0,0 +1,147 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "routing/raptor_utils.h"
+#include "routing/routing.h"
+#include "type/accessibility_params.h"
+#include "type/rt_level.h"
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace navitia {
+namespace routing {
+
+/*
+ * Cache of the raptor results of journeys requests, shared by the workers.
+ *
+ * The results are the pathes of a request, keyed on everything the
+ * raptor computation depends on.  As the pathes point into the data,
+ * the cache only keeps the results of one data: when a result of a
+ * newer data is looked up, the cache is cleared, and the results of
+ * an older data are neither looked up nor stored.
+ *
+ * The least recently used result is evicted when the cache is full.
+ */
+class JourneyCache {
+public:
+    struct Key {
+        std::vector<std::pair<uint32_t, int64_t>> departures;  // stop point idx, fallback duration in seconds
+        std::vector<std::pair<uint32_t, int64_t>> destinations;
+        std::vector<DateTime> datetimes;
+        type::RTLevel rt_level = type::RTLevel::Base;
+        int64_t transfer_penalty = 0;
+        unsigned long properties = 0;
+        unsigned long vehicle_properties = 0;
+        std::vector<std::string> forbidden;  // sorted
+        std::vector<std::string> allowed;    // sorted
+        bool clockwise = true;
+        boost::optional<int64_t> direct_path_duration;
+        boost::optional<uint32_t> min_nb_journeys;
+        uint32_t nb_direct_path = 0;
+        uint32_t max_duration = 0;
+        uint32_t max_transfers = 0;
+        size_t max_extra_second_pass = 0;
+        double night_bus_filter_max_factor = 0;
+        int32_t night_bus_filter_base_factor = 0;
+        boost::optional<uint32_t> timeframe_duration;
+
+        Key(const map_stop_point_duration& departures,
+            const map_stop_point_duration& destinations,
+            std::vector<DateTime> datetimes,
+            const type::RTLevel rt_level,
+            const navitia::time_duration& transfer_penalty,
+            const type::AccessibiliteParams& accessibilite_params,
+            std::vector<std::string> forbidden,
+            std::vector<std::string> allowed,
+            const bool clockwise,
+            const boost::optional<navitia::time_duration>& direct_path_duration,
+            const boost::optional<uint32_t>& min_nb_journeys,
+            const uint32_t nb_direct_path,
+            const uint32_t max_duration,
+            const uint32_t max_transfers,
+            const size_t max_extra_second_pass,
+            const double night_bus_filter_max_factor,
+            const int32_t night_bus_filter_base_factor,
+            const boost::optional<uint32_t>& timeframe_duration);
+
+        bool operator<(const Key& other) const;
+    };
+
+    struct Value {
+        std::vector<Path> pathes;
+        // datetime of the next request to do, if the raptor had to shift the requested datetime
+        boost::optional<uint64_t> next_request_date_time;
+    };
+
+    // What happened since the previous call to take_report()
+    struct Report {
+        size_t nb_hits = 0;
+        size_t nb_misses = 0;
+    };
+
+    explicit JourneyCache(size_t max_size) : max_size(max_size) {}
+
+    // Returns the cached result of key for the given data, or null
+    std::shared_ptr<const Value> get(const size_t data_identifier, const Key& key);
+    void add(const size_t data_identifier, const Key& key, Value value);
+
+    size_t size() const;
+    // Returns the hits and misses not reported yet, and resets them
+    Report take_report();
+
+private:
+    using Entries = std::list<std::pair<Key, std::shared_ptr<const Value>>>;
+
+    // must be called with the mutex locked.  Returns false if data_identifier is too old to be cached
+    bool set_data_identifier(const size_t data_identifier);
+
+    const size_t max_size;
+    mutable std::mutex mutex;
+    size_t data_identifier = 0;
+    // most recently used first
+    Entries entries;
+    std::map<Key, Entries::iterator> index;
+
+    std::atomic<size_t> pending_hits{0};
+    std::atomic<size_t> pending_misses{0};
+};
+
+}  // namespace routing
+}  // namespace navitia
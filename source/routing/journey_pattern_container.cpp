@@ -31,7 +31,9 @@ www.navitia.io
 #include "journey_pattern_container.h"
 
 #include "tests/utils_test.h"
+#include "type/meta_vehicle_journey.h"
 #include "type/pt_data.h"
+#include "type/vehicle_journey.h"
 
 #include <type_traits>
 
@@ -82,6 +84,80 @@ void JourneyPatternContainer::load(const nt::PT_Data& pt_data) {
     }
 }
 
+// Replaces the vjs by the ones of pt_data with the same uri, removing
+// the vjs of the modified meta vjs.  Returns true if a vj has been removed.
+template <typename VJ>
+static bool update_vjs(std::vector<const VJ*>& vjs,
+                       const nt::PT_Data& pt_data,
+                       const std::set<std::string>& modified_meta_vjs) {
+    std::vector<const VJ*> updated_vjs;
+    updated_vjs.reserve(vjs.size());
+    for (const auto* vj : vjs) {
+        if (modified_meta_vjs.count(vj->meta_vj->uri)) {
+            continue;
+        }
+        updated_vjs.push_back(static_cast<const VJ*>(pt_data.vehicle_journeys_map.at(vj->uri)));
+    }
+    const bool modified = updated_vjs.size() != vjs.size();
+    vjs = std::move(updated_vjs);
+    return modified;
+}
+
+boost::dynamic_bitset<> JourneyPatternContainer::load(const nt::PT_Data& pt_data,
+                                                      const JourneyPatternContainer& previous,
+                                                      const std::set<std::string>& modified_meta_vjs) {
+    // realtime only appends routes, thus the indexes of previous are still valid
+    map = previous.map;
+    jps = previous.jps;
+    jpps = previous.jpps;
+    jps_from_route.assign(pt_data.routes);
+    for (const auto route_jps : previous.jps_from_route) {
+        jps_from_route[route_jps.first] = route_jps.second;
+    }
+    jps_from_phy_mode.assign(pt_data.physical_modes);
+    for (const auto phy_mode_jps : previous.jps_from_phy_mode) {
+        jps_from_phy_mode[phy_mode_jps.first] = phy_mode_jps.second;
+    }
+    jpps_from_phy_mode.assign(pt_data.physical_modes);
+    for (const auto phy_mode_jpps : previous.jpps_from_phy_mode) {
+        jpps_from_phy_mode[phy_mode_jpps.first] = phy_mode_jpps.second;
+    }
+
+    boost::dynamic_bitset<> modified_jps(jps.size());
+    jp_from_vj.assign(pt_data.vehicle_journeys);
+    for (size_t i = 0; i < jps.size(); ++i) {
+        auto& jp = jps[i];
+        const bool discrete_modified = update_vjs(jp.discrete_vjs, pt_data, modified_meta_vjs);
+        const bool freq_modified = update_vjs(jp.freq_vjs, pt_data, modified_meta_vjs);
+        modified_jps[i] = discrete_modified || freq_modified;
+        jp.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
+            jp_from_vj[VjIdx(vj)] = JpIdx(i);
+            return true;
+        });
+    }
+
+    // the vjs of the modified meta vjs are added as in a full load
+    for (const auto& uri : modified_meta_vjs) {
+        if (!pt_data.meta_vjs.exists(uri)) {
+            continue;
+        }
+        pt_data.meta_vjs[uri]->for_all_vjs([&](const nt::VehicleJourney& vj) {
+            // a full load only knows the vjs of the routes
+            if (!vj.route) {
+                return;
+            }
+            if (const auto* freq_vj = dynamic_cast<const nt::FrequencyVehicleJourney*>(&vj)) {
+                add_vj(*freq_vj);
+            } else {
+                add_vj(static_cast<const nt::DiscreteVehicleJourney&>(vj));
+            }
+            modified_jps.resize(jps.size());
+            modified_jps.set(jp_from_vj[VjIdx(vj)].val);
+        });
+    }
+    return modified_jps;
+}
+
 const JppIdx& JourneyPatternContainer::get_jpp(const type::StopTime& st) const {
     const auto& jp = get(jp_from_vj[VjIdx(*st.vehicle_journey)]);
     return jp.jpps.at(st.order().val);
@@ -33,8 +33,12 @@ www.navitia.io
 #include "raptor_utils.h"
 #include "utils/rank.h"
 
+#include <boost/dynamic_bitset.hpp>
 #include <boost/optional.hpp>
 
+#include <set>
+#include <string>
+
 namespace navitia {
 namespace type {
 
@@ -105,6 +109,13 @@ struct JourneyPatternContainer {
     using JppRange = boost::iterator_range<JppIterator>;
 
     void load(const navitia::type::PT_Data&);
+    // Loads from previous, loaded with the data pt_data has been cloned
+    // from: the vjs of the given meta vjs are removed from their jps and
+    // added again, the other vjs stay in the same jp.  Returns the jps
+    // whose vjs have changed, the created ones included.
+    boost::dynamic_bitset<> load(const navitia::type::PT_Data& pt_data,
+                                 const JourneyPatternContainer& previous,
+                                 const std::set<std::string>& modified_meta_vjs);
     size_t nb_jps() const { return jps.size(); }
     size_t nb_jpps() const { return jpps.size(); }
     const JourneyPattern& get(const JpIdx& idx) const {
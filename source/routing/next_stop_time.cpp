@@ -31,6 +31,7 @@ www.navitia.io
 #include "next_stop_time.h"
 
 #include "dataraptor.h"
+#include "thread_pool.h"
 #include "type/data.h"
 #include "type/meta_data.h"
 #include "type/pt_data.h"
@@ -39,7 +40,9 @@ www.navitia.io
 #include "utils/logger.h"
 
 #include <boost/range/algorithm/sort.hpp>
-#include <boost/range/algorithm_ext/push_back.hpp>
+
+#include <algorithm>
+#include <chrono>
 
 namespace nt = navitia::type;
 
@@ -94,6 +97,17 @@ void NextStopTimeData::TimesStopTimes<Getter>::init(const JourneyPattern& jp, co
     }
 }
 
+template <typename Getter>
+void NextStopTimeData::TimesStopTimes<Getter>::init(const TimesStopTimes& other,
+                                                    const std::vector<const type::VehicleJourney*>& vjs) {
+    // the order of the vjs is the same, thus there is no need to sort
+    times = other.times;
+    stop_times.reserve(other.stop_times.size());
+    for (const auto* st : other.stop_times) {
+        stop_times.push_back(&vjs[st->vehicle_journey->idx]->stop_time_list[st->order().val]);
+    }
+}
+
 void NextStopTimeData::load(const JourneyPatternContainer& jp_container) {
     departure.assign(jp_container.get_jpps_values());
     arrival.assign(jp_container.get_jpps_values());
@@ -107,6 +121,45 @@ void NextStopTimeData::load(const JourneyPatternContainer& jp_container) {
     }
 }
 
+void NextStopTimeData::load(const JourneyPatternContainer& jp_container,
+                            const NextStopTimeData& previous,
+                            const JourneyPatternContainer& prev_jp_container,
+                            const boost::dynamic_bitset<>& modified_jps) {
+    departure.assign(jp_container.get_jpps_values());
+    arrival.assign(jp_container.get_jpps_values());
+
+    // the vjs of the unmodified jps, indexed by the idx of the
+    // corresponding vjs of prev_jp_container
+    std::vector<const type::VehicleJourney*> vjs;
+    for (const auto jp : jp_container.get_jps()) {
+        if (modified_jps[jp.first.val]) {
+            continue;
+        }
+        const auto& prev_vjs = prev_jp_container.get(jp.first).discrete_vjs;
+        assert(prev_vjs.size() == jp.second.discrete_vjs.size());
+        for (size_t i = 0; i < prev_vjs.size(); ++i) {
+            if (prev_vjs[i]->idx >= vjs.size()) {
+                vjs.resize(prev_vjs[i]->idx + 1, nullptr);
+            }
+            vjs[prev_vjs[i]->idx] = jp.second.discrete_vjs[i];
+        }
+    }
+
+    for (const auto jp : jp_container.get_jps()) {
+        const bool modified = modified_jps[jp.first.val];
+        for (const auto& jpp_idx : jp.second.jpps) {
+            if (modified) {
+                const auto& jpp = jp_container.get(jpp_idx);
+                departure[jpp_idx].init(jp.second, jpp);
+                arrival[jpp_idx].init(jp.second, jpp);
+            } else {
+                departure[jpp_idx].init(previous.departure[jpp_idx], vjs);
+                arrival[jpp_idx].init(previous.arrival[jpp_idx], vjs);
+            }
+        }
+    }
+}
+
 inline static bool is_valid(const type::StopTime* st,
                             const DateTime date,
                             const bool clockwise,
@@ -368,6 +421,7 @@ static void fill_cache(const DateTime from,
                        const type::AccessibiliteParams& accessibilite_params,
                        const JourneyPattern& jp,
                        const std::vector<const VJ_T*>& vjs,
+                       const dataRAPTOR::JpStopTimes& jp_stop_times,
                        IdxMap<JourneyPatternPoint, std::vector<CachedNextStopTime::DtSt>>& arrival_cache,
                        IdxMap<JourneyPatternPoint, std::vector<CachedNextStopTime::DtSt>>& departure_cache) {
     const auto to_int = static_cast<int>(DateTimeUtils::date(to));
@@ -387,17 +441,18 @@ static void fill_cache(const DateTime from,
             RankJourneyPatternPoint i{0};
             for (const auto& st : vj->stop_time_list) {
                 auto jpp_idx = jp.get_jpp_idx(i);
+                const auto st_idx = jp_stop_times.index(st);
                 auto loop_impl = [&](long freq_shift) {
                     if (st.drop_off_allowed()) {
                         auto arrival_time = st.alighting_time + shift + freq_shift;
                         if (from <= arrival_time && arrival_time <= to) {
-                            arrival_cache[jpp_idx].emplace_back(arrival_time, &st);
+                            arrival_cache[jpp_idx].emplace_back(arrival_time, st_idx);
                         }
                     }
                     if (st.pick_up_allowed()) {
                         auto departure_time = st.boarding_time + shift + freq_shift;
                         if (departure_time <= to && from <= departure_time) {
-                            departure_cache[jpp_idx].emplace_back(departure_time, &st);
+                            departure_cache[jpp_idx].emplace_back(departure_time, st_idx);
                         }
                     }
                 };
@@ -419,7 +474,13 @@ bool CachedNextStopTimeKey::operator<(const CachedNextStopTimeKey& other) const
     return accessibilite_params < other.accessibilite_params;
 }
 
+// Number of caches built by the current thread.  The lru builds a
+// missing cache in the thread asking for it, thus comparing this
+// counter before and after a call tells if the call was a miss.
+static thread_local size_t nb_builds_on_this_thread = 0;
+
 CachedNextStopTime CachedNextStopTimeManager::CacheCreator::operator()(const CachedNextStopTimeKey& key) const {
+    const auto start = std::chrono::steady_clock::now();
     CachedNextStopTime::vDtStByJpp departure, arrival;
     const auto& jp_container = dataRaptor.jp_container;
 
@@ -428,9 +489,12 @@ CachedNextStopTime CachedNextStopTimeManager::CacheCreator::operator()(const Cac
     DateTime dt_from = DateTimeUtils::set(key.from, 0);
     DateTime dt_to = DateTimeUtils::set(key.from + 2, 0);  // cache window is 2-days wide (journeys : 24h max)
 
+    const auto& jp_stop_times = dataRaptor.jp_stop_times;
     for (const auto& jp : jp_container.get_jps_values()) {
-        fill_cache(dt_from, dt_to, key.rt_level, key.accessibilite_params, jp, jp.discrete_vjs, arrival, departure);
-        fill_cache(dt_from, dt_to, key.rt_level, key.accessibilite_params, jp, jp.freq_vjs, arrival, departure);
+        fill_cache(dt_from, dt_to, key.rt_level, key.accessibilite_params, jp, jp.discrete_vjs, jp_stop_times, arrival,
+                   departure);
+        fill_cache(dt_from, dt_to, key.rt_level, key.accessibilite_params, jp, jp.freq_vjs, jp_stop_times, arrival,
+                   departure);
     }
     auto compare = [](const CachedNextStopTime::DtSt& lhs, const CachedNextStopTime::DtSt& rhs) noexcept {
         return lhs.first < rhs.first;
@@ -441,7 +505,15 @@ CachedNextStopTime CachedNextStopTimeManager::CacheCreator::operator()(const Cac
     for (const auto jpp_dtst : departure) {
         boost::sort(jpp_dtst.second, compare);
     }
-    return {departure, arrival};
+    CachedNextStopTime cache(dataRaptor, departure, arrival);
+    const size_t duration_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    ++nb_builds_on_this_thread;
+    ++stats->nb_builds;
+    stats->last_memory_size = cache.memory_size();
+    stats->build_duration_us += duration_us;
+    stats->pending_build_duration_us += duration_us;
+    return cache;
 }
 
 CachedNextStopTime::DtStFromJpp::DtStFromJpp(const vDtStByJpp& map) {
@@ -449,44 +521,49 @@ CachedNextStopTime::DtStFromJpp::DtStFromJpp(const vDtStByJpp& map) {
     for (const auto elt : map) {
         s += elt.second.size();
     }
-    dtsts.reserve(s);
+    times.reserve(s);
+    st_idxs.reserve(s);
     until.assign(map, 0);
     for (const auto elt : map) {
-        boost::push_back(dtsts, elt.second);
-        until[elt.first] = dtsts.size();
+        for (const auto& dtst : elt.second) {
+            times.push_back(dtst.first);
+            st_idxs.push_back(dtst.second);
+        }
+        until[elt.first] = times.size();
     }
-    dtsts.shrink_to_fit();
 }
 
-boost::iterator_range<CachedNextStopTime::vDtSt::const_iterator> CachedNextStopTime::DtStFromJpp::operator[](
-    const JppIdx& jpp_idx) const {
+boost::iterator_range<CachedNextStopTime::DtStFromJpp::Times::const_iterator> CachedNextStopTime::DtStFromJpp::
+operator[](const JppIdx& jpp_idx) const {
     const auto from = jpp_idx.val == 0 ? 0 : until[JppIdx(jpp_idx.val - 1)];
-    const auto begin = dtsts.begin();
+    const auto begin = times.begin();
     return boost::make_iterator_range(begin + from, begin + until[jpp_idx]);
 }
 
+size_t CachedNextStopTime::DtStFromJpp::memory_size() const {
+    return times.capacity() * sizeof(DateTime) + st_idxs.capacity() * sizeof(uint32_t)
+           + until.size() * sizeof(uint32_t);
+}
+
 std::pair<const type::StopTime*, DateTime> CachedNextStopTime::next_stop_time(const StopEvent stop_event,
                                                                               const JppIdx jpp_idx,
                                                                               const DateTime dt,
                                                                               const bool clockwise) const {
-    const auto& v = (stop_event == StopEvent::pick_up ? departure[jpp_idx] : arrival[jpp_idx]);
-    const type::StopTime* null_st = nullptr;
+    const auto& dtsts = (stop_event == StopEvent::pick_up ? departure : arrival);
+    const auto v = dtsts[jpp_idx];
     decltype(v.begin()) search;
-    auto cmp = [](const CachedNextStopTime::DtSt& a, const CachedNextStopTime::DtSt& b) noexcept {
-        return a.first < b.first;
-    };
     if (clockwise) {
-        search = boost::lower_bound(v, std::make_pair(dt, null_st), cmp);
+        search = boost::lower_bound(v, dt);
     } else {
-        search = boost::upper_bound(v, std::make_pair(dt, null_st), cmp);
+        search = boost::upper_bound(v, dt);
         if (search == v.begin()) {
             search = v.end();
-        } else if (!v.empty()) {
+        } else {
             --search;
         }
     }
     if (search != v.end()) {
-        return {search->second, search->first};
+        return {dataRaptor->jp_stop_times.stop_time(dtsts.st_idx(search)), *search};
     }
     return {nullptr, 0};
 }
@@ -501,7 +578,60 @@ std::shared_ptr<const CachedNextStopTime> CachedNextStopTimeManager::load(
     const type::RTLevel rt_level,
     const type::AccessibiliteParams& accessibilite_params) {
     CachedNextStopTimeKey key(DateTimeUtils::date(from), rt_level, accessibilite_params);
-    return lru(key);
+    const auto nb_builds_before = nb_builds_on_this_thread;
+    auto cache = lru(key);
+    if (nb_builds_on_this_thread == nb_builds_before) {
+        ++stats->pending_hits;
+    } else {
+        ++stats->pending_misses;
+    }
+    return cache;
+}
+
+std::vector<CachedNextStopTimeKey> CachedNextStopTimeManager::prefetch_keys(const CachedNextStopTimeKey::Day day) {
+    type::AccessibiliteParams wheelchair;
+    wheelchair.properties.set(type::hasProperties::WHEELCHAIR_BOARDING, true);
+    wheelchair.vehicle_properties.set(type::hasVehicleProperties::WHEELCHAIR_ACCESSIBLE, true);
+
+    std::vector<CachedNextStopTimeKey> keys;
+    for (const auto d : {day, day + 1}) {
+        for (const auto& accessibilite_params : {type::AccessibiliteParams(), wheelchair}) {
+            for (const auto rt_level : {type::RTLevel::Base, type::RTLevel::RealTime}) {
+                keys.emplace_back(d, rt_level, accessibilite_params);
+            }
+        }
+    }
+    return keys;
+}
+
+size_t CachedNextStopTimeManager::prefetch(const std::vector<CachedNextStopTimeKey>& keys, const size_t nb_threads) {
+    const size_t nb_keys = std::min(keys.size(), max_cache);
+    if (nb_keys == 0) {
+        return 0;
+    }
+    std::atomic<size_t> nb_built{0};
+    auto build = [&](const size_t i) {
+        const auto nb_builds_before = nb_builds_on_this_thread;
+        lru(keys[i]);
+        nb_built += nb_builds_on_this_thread - nb_builds_before;
+    };
+    if (nb_threads <= 1 || nb_keys == 1) {
+        for (size_t i = 0; i < nb_keys; ++i) {
+            build(i);
+        }
+    } else {
+        ThreadPool pool(std::min(nb_threads, nb_keys));
+        pool.parallel_for(nb_keys, build);
+    }
+    return nb_built;
+}
+
+CachedNextStopTimeManager::Report CachedNextStopTimeManager::take_report() {
+    Report report;
+    report.nb_hits = stats->pending_hits.exchange(0);
+    report.nb_misses = stats->pending_misses.exchange(0);
+    report.build_duration = stats->pending_build_duration_us.exchange(0) / 1e6;
+    return report;
 }
 
 inline static bool within(u_int32_t val, std::pair<u_int32_t, u_int32_t> bound) {
@@ -45,6 +45,10 @@ www.navitia.io
 #include <boost/optional.hpp>
 #include <boost/dynamic_bitset.hpp>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace navitia {
 
 namespace type {
@@ -65,6 +69,13 @@ struct NextStopTimeData {
     typedef boost::iterator_range<std::vector<const type::StopTime*>::const_reverse_iterator> StopTimeReverseIter;
 
     void load(const JourneyPatternContainer&);
+    // Loads the jpps of the modified jps, and copies the other ones from
+    // previous, loaded with prev_jp_container, replacing their stop times
+    // by the ones of the same vjs in jp_container.
+    void load(const JourneyPatternContainer& jp_container,
+              const NextStopTimeData& previous,
+              const JourneyPatternContainer& prev_jp_container,
+              const boost::dynamic_bitset<>& modified_jps);
 
     // Returns the range of the stop times in increasing time order
     inline StopTimeIter stop_time_range_forward(const JppIdx jpp_idx, const StopEvent stop_event) const {
@@ -142,6 +153,9 @@ private:
             return boost::make_iterator_range(stop_times.rend() - idx, stop_times.rend());
         }
         void init(const JourneyPattern& jp, const JourneyPatternPoint& jpp);
+        // copies other, where the stop times of the vj of index i are
+        // replaced by the ones of vjs[i]
+        void init(const TimesStopTimes& other, const std::vector<const type::VehicleJourney*>& vjs);
     };
     IdxMap<JourneyPatternPoint, TimesStopTimes<Departure>> departure;
     IdxMap<JourneyPatternPoint, TimesStopTimes<Arrival>> arrival;
@@ -215,11 +229,13 @@ struct CachedNextStopTimeKey {
 };
 
 struct CachedNextStopTime {
-    using DtSt = std::pair<DateTime, const type::StopTime*>;
+    // a datetime and the index of the corresponding stop time in dataRAPTOR::jp_stop_times
+    using DtSt = std::pair<DateTime, uint32_t>;
     using vDtSt = std::vector<DtSt>;
     using vDtStByJpp = IdxMap<JourneyPatternPoint, vDtSt>;
 
-    CachedNextStopTime(const vDtStByJpp& d, const vDtStByJpp& a) : departure(d), arrival(a) {}
+    CachedNextStopTime(const dataRAPTOR& dataRaptor, const vDtStByJpp& d, const vDtStByJpp& a)
+        : dataRaptor(&dataRaptor), departure(d), arrival(a) {}
     // Returns the next stop time at given journey pattern point
     // either a vehicle that leaves or that arrives depending on
     // clockwise.
@@ -228,16 +244,29 @@ struct CachedNextStopTime {
                                                               const DateTime dt,
                                                               const bool clockwise) const;
 
+    // Returns the memory used by the cache, in bytes
+    size_t memory_size() const { return sizeof(*this) + departure.memory_size() + arrival.memory_size(); }
+
 private:
     // This structure provide the same interface as a vDtStByJpp, but
-    // in a condensed and read only view.
+    // in a condensed and read only view.  The datetimes are stored
+    // apart from the stop times, thus a search only reads a
+    // contiguous array of 32 bits integers, and the stop time is only
+    // fetched for the found datetime.
     struct DtStFromJpp {
+        using Times = std::vector<DateTime>;
+
         DtStFromJpp(const vDtStByJpp& map);
 
-        // Returns the range corresponding to map[jpp_idx], i.e. from
-        // dtsts[until[prev(jpp_idx)]] to dtsts[until[jpp_idx]]
-        // (excluded).
-        boost::iterator_range<vDtSt::const_iterator> operator[](const JppIdx& jpp_idx) const;
+        // Returns the range of datetimes corresponding to
+        // map[jpp_idx], i.e. from times[until[prev(jpp_idx)]] to
+        // times[until[jpp_idx]] (excluded).
+        boost::iterator_range<Times::const_iterator> operator[](const JppIdx& jpp_idx) const;
+
+        // Returns the index of the stop time corresponding to the datetime pointed by it
+        inline uint32_t st_idx(const Times::const_iterator it) const { return st_idxs[it - times.begin()]; }
+
+        size_t memory_size() const;
 
     private:
         // let map[JppIdx(40)] == []
@@ -248,26 +277,51 @@ private:
         //                  |           |            |        |
         //                  ------------+------,     |        |
         //                                     V     V        V
-        // dtsts: [...................... , o, a, l, x, y, z, p, q, ...]
+        // times: [...................... , o, a, l, x, y, z, p, q, ...]
         //                                           ^^^^^^^
         //                                      range of values
         //                                      corresponding to
         //                                      map[JppIdx(42)]
         //
-        // Every vectors of map concatenated in order
-        // (flatten(map.values())).
-        vDtSt dtsts;
+        // The datetimes of every vectors of map concatenated in order
+        // (flatten(map.values())), st_idxs being the corresponding
+        // stop time indexes.
+        Times times;
+        std::vector<uint32_t> st_idxs;
 
-        // dtsts[until[jpp_idx]] correspond to the end of
+        // times[until[jpp_idx]] correspond to the end of
         // map[jpp_idx], and to the begin of map[next(jpp_idx)]
         IdxMap<JourneyPatternPoint, uint32_t> until;
     };
+    const dataRAPTOR* dataRaptor;
     DtStFromJpp departure;
     DtStFromJpp arrival;
 };
 
 struct CachedNextStopTimeManager {
-    explicit CachedNextStopTimeManager(const dataRAPTOR& dataRaptor, size_t max_cache) : lru({dataRaptor}, max_cache) {}
+    // Statistics on the built caches, shared with the cache creator
+    struct Stats {
+        std::atomic<size_t> nb_builds{0};
+        // memory used by the last built cache, i.e. by a cached day
+        std::atomic<size_t> last_memory_size{0};
+        // total time spent building caches, in microseconds
+        std::atomic<size_t> build_duration_us{0};
+
+        // counters not yet collected by take_report()
+        std::atomic<size_t> pending_hits{0};
+        std::atomic<size_t> pending_misses{0};
+        std::atomic<size_t> pending_build_duration_us{0};
+    };
+
+    // What happened since the previous call to take_report()
+    struct Report {
+        size_t nb_hits = 0;    // calls to load() served by an already built cache
+        size_t nb_misses = 0;  // calls to load() that had to build their cache
+        double build_duration = 0;  // time spent building caches (prefetching included), in seconds
+    };
+
+    explicit CachedNextStopTimeManager(const dataRAPTOR& dataRaptor, size_t max_cache)
+        : stats(std::make_shared<Stats>()), max_cache(max_cache), lru({dataRaptor, stats}, max_cache) {}
     CachedNextStopTimeManager& operator=(CachedNextStopTimeManager&&) = default;
     ~CachedNextStopTimeManager();
 
@@ -277,15 +331,36 @@ struct CachedNextStopTimeManager {
 
     void warmup(const CachedNextStopTimeManager& other) { this->lru.warmup(other.lru); }
 
+    // The keys most likely to be asked for the given day, by decreasing
+    // priority: the day and the next one, base and realtime, with and
+    // without wheelchair.
+    static std::vector<CachedNextStopTimeKey> prefetch_keys(const CachedNextStopTimeKey::Day day);
+
+    // Builds the caches of the given keys, using at most nb_threads
+    // threads (the calling one included).  Only the first keys fitting
+    // in the lru are considered, to avoid evicting the first ones with
+    // the last ones.  Returns the number of caches built, i.e. that
+    // were not already in the lru.
+    size_t prefetch(const std::vector<CachedNextStopTimeKey>& keys, const size_t nb_threads);
+
+    size_t nb_cache_builds() const { return stats->nb_builds; }
+    // Returns the memory used by a cached day, in bytes (0 if no cache has been built)
+    size_t cache_memory_size() const { return stats->last_memory_size; }
+    // Returns the hits, misses and build time not reported yet, and resets them
+    Report take_report();
+
 private:
     struct CacheCreator {
         typedef CachedNextStopTimeKey const& argument_type;
         typedef CachedNextStopTime result_type;
         const dataRAPTOR& dataRaptor;
-        CacheCreator(const dataRAPTOR& d) : dataRaptor(d) {}
+        std::shared_ptr<Stats> stats;
+        CacheCreator(const dataRAPTOR& d, std::shared_ptr<Stats> s) : dataRaptor(d), stats(std::move(s)) {}
         CachedNextStopTime operator()(const CachedNextStopTimeKey& key) const;
     };
 
+    std::shared_ptr<Stats> stats;
+    size_t max_cache;
     ConcurrentLru<CacheCreator> lru;
 };
 
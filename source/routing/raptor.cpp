@@ -37,13 +37,21 @@ www.navitia.io
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/algorithm/fill.hpp>
 #include <boost/range/algorithm/find_if.hpp>
+#include <boost/range/algorithm_ext/erase.hpp>
 #include <boost/range/algorithm_ext/push_back.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
 
 namespace navitia {
 namespace routing {
 
+// Under this number of marked journey patterns, a round is not worth being scanned in parallel
+static const size_t MIN_NB_JPS_FOR_PARALLEL_SCAN = 64;
+// Number of chunks of marked journey patterns per thread of the pool
+static const size_t NB_CHUNKS_PER_THREAD = 4;
+
 DateTime limit_bound(const bool clockwise, const DateTime departure_datetime, const DateTime bound) {
     auto depart_clockwise = departure_datetime + DateTimeUtils::SECONDS_PER_DAY;
     auto depart_anticlockwise =
@@ -65,7 +73,8 @@ bool RAPTOR::apply_vj_extension(const Visitor& v,
                                 const uint16_t l_zone,
                                 DateTime base_dt,
                                 DateTime working_walking_duration,
-                                SpIdx boarding_stop_point) {
+                                SpIdx boarding_stop_point,
+                                std::vector<PtLabelUpdate>* updates) {
     auto& working_labels = labels[count];
     bool result = false;
     while (vj) {
@@ -102,11 +111,15 @@ bool RAPTOR::apply_vj_extension(const Visitor& v,
                                                    << st.vehicle_journey->route->line->uri << " boarding_stop_point : "
                                                    << data.pt_data->stop_points[boarding_stop_point.val]->uri
                                                    << " fallback : " << navitia::str(working_walking_duration));
-                working_labels.mut_dt_pt(sp_idx) = workingDt;
-                working_labels.mut_walking_duration_pt(sp_idx) = working_walking_duration;
-                BOOST_ASSERT(working_walking_duration != DateTimeUtils::not_valid);
-                best_labels_pts[sp_idx] = workingDt;
-                best_labels_pts_walking[sp_idx] = working_walking_duration;
+                if (updates) {
+                    updates->push_back({sp_idx, workingDt, working_walking_duration});
+                } else {
+                    working_labels.mut_dt_pt(sp_idx) = workingDt;
+                    working_labels.mut_walking_duration_pt(sp_idx) = working_walking_duration;
+                    BOOST_ASSERT(working_walking_duration != DateTimeUtils::not_valid);
+                    best_labels_pts[sp_idx] = workingDt;
+                    best_labels_pts_walking[sp_idx] = working_walking_duration;
+                }
                 result = true;
             }
         }
@@ -155,19 +168,13 @@ bool RAPTOR::foot_path(const Visitor& v) {
                 best_labels_transfers[destination_sp_idx] = end_connection_date;
                 best_labels_transfers_walking[destination_sp_idx] = candidate_walking_duration;
                 result = true;
-            }
-        }
-    }
 
-    for (const auto sp_jpps : jpps_from_sp) {
-        if (!working_labels.transfer_is_initialized(sp_jpps.first)) {
-            continue;
-        }
-
-        // we mark the jpp order
-        for (const auto& jpp : sp_jpps.second) {
-            if (v.comp(jpp.order, Q[jpp.jp_idx])) {
-                Q[jpp.jp_idx] = jpp.order;
+                // we mark the jpp order.  Only the improved transfers
+                // are marked, as the labels of a round may have been
+                // initialized by a previous run (see rRAPTOR)
+                for (const auto& jpp : jpps_from_sp[destination_sp_idx]) {
+                    mark_jpp(jpp, v.clockwise());
+                }
             }
         }
     }
@@ -178,6 +185,7 @@ bool RAPTOR::foot_path(const Visitor& v) {
 void RAPTOR::clear(const bool clockwise, const DateTime bound) {
     const int queue_value = clockwise ? std::numeric_limits<int>::max() : -1;
     Q.assign(data.dataRaptor->jp_container.get_jps_values(), queue_value);
+    marked_jps.clear();
     if (labels.empty()) {
         labels.resize(5);
     }
@@ -207,11 +215,7 @@ void RAPTOR::init(const map_stop_point_duration& dep,
         best_labels_transfers[sp_dt.first] = begin_dt;
         best_labels_transfers_walking[sp_dt.first] = begin_dt;
         for (const auto& jpp : jpps_from_sp[sp_dt.first]) {
-            if (clockwise && Q[jpp.jp_idx] > jpp.order) {
-                Q[jpp.jp_idx] = jpp.order;
-            } else if (!clockwise && Q[jpp.jp_idx] < jpp.order) {
-                Q[jpp.jp_idx] = jpp.order;
-            }
+            mark_jpp(jpp, clockwise);
         }
     }
 }
@@ -386,6 +390,25 @@ std::vector<Path> RAPTOR::compute_all(const map_stop_point_duration& departures,
     return from_journeys_to_path(journeys);
 }
 
+static void add_direct_path(Solutions& solutions,
+                            const boost::optional<navitia::time_duration>& direct_path_dur,
+                            const DateTime& departure_datetime,
+                            const bool clockwise) {
+    if (!direct_path_dur) {
+        return;
+    }
+    Journey j;
+    j.sn_dur = *direct_path_dur;
+    if (clockwise) {
+        j.departure_dt = departure_datetime;
+        j.arrival_dt = j.departure_dt + j.sn_dur;
+    } else {
+        j.arrival_dt = departure_datetime;
+        j.departure_dt = j.arrival_dt - j.sn_dur;
+    }
+    solutions.add(j);
+}
+
 RAPTOR::Journeys RAPTOR::compute_all_journeys(const map_stop_point_duration& departures,
                                               const map_stop_point_duration& destinations,
                                               const DateTime& departure_datetime,
@@ -403,18 +426,7 @@ RAPTOR::Journeys RAPTOR::compute_all_journeys(const map_stop_point_duration& dep
     auto dominator = Dominates(clockwise, transfer_penalty);
     auto solutions = Solutions(dominator);
 
-    if (direct_path_dur) {
-        Journey j;
-        j.sn_dur = *direct_path_dur;
-        if (clockwise) {
-            j.departure_dt = departure_datetime;
-            j.arrival_dt = j.departure_dt + j.sn_dur;
-        } else {
-            j.arrival_dt = departure_datetime;
-            j.departure_dt = j.arrival_dt - j.sn_dur;
-        }
-        solutions.add(j);
-    }
+    add_direct_path(solutions, direct_path_dur, departure_datetime, clockwise);
 
     const auto& calc_dep = clockwise ? departures : destinations;
     const auto& calc_dest = clockwise ? destinations : departures;
@@ -427,6 +439,33 @@ RAPTOR::Journeys RAPTOR::compute_all_journeys(const map_stop_point_duration& dep
 
     LOG4CPLUS_DEBUG(raptor_logger, "end first pass with count : " << count);
 
+    const auto starting_points = make_starting_points_snd_phase(*this, calc_dest, accessibilite_params, clockwise);
+    second_pass(solutions, starting_points, departures, destinations, departure_datetime, rt_level, transfer_penalty,
+                max_transfers, accessibilite_params, clockwise, max_extra_second_pass);
+
+    auto end_raptor = std::chrono::system_clock::now();
+    LOG4CPLUS_DEBUG(raptor_logger,
+                    "[2nd pass] Run times: 1st pass = "
+                        << std::chrono::duration_cast<std::chrono::milliseconds>(end_first_pass - start_raptor).count()
+                        << ", 2nd pass = "
+                        << std::chrono::duration_cast<std::chrono::milliseconds>(end_raptor - end_first_pass).count());
+
+    return solutions.get_pool();
+}
+
+void RAPTOR::second_pass(Solutions& solutions,
+                         const std::vector<StartingPointSndPhase>& starting_points,
+                         const map_stop_point_duration& departures,
+                         const map_stop_point_duration& destinations,
+                         const DateTime& departure_datetime,
+                         const nt::RTLevel rt_level,
+                         const navitia::time_duration& transfer_penalty,
+                         const uint32_t max_transfers,
+                         const type::AccessibiliteParams& accessibilite_params,
+                         const bool clockwise,
+                         const size_t max_extra_second_pass) {
+    const auto& calc_dep = clockwise ? departures : destinations;
+
     // Now, we do the second pass.  In case of clockwise (resp
     // anticlockwise) search, the goal of the second pass is to find
     // the earliest (resp. tardiest) departure (resp arrival)
@@ -439,7 +478,6 @@ RAPTOR::Journeys RAPTOR::compute_all_journeys(const map_stop_point_duration& dep
     // (as in best_labels_pt) in the second pass.  Then, we can reuse
     // these bounds, modulo an off by one because of strict comparison
     // on best_labels.
-    auto starting_points = make_starting_points_snd_phase(*this, calc_dest, accessibilite_params, clockwise);
     swap(labels, first_pass_labels);
     auto best_labels_pts_for_snd_pass = snd_pass_best_labels(clockwise, best_labels_transfers);
     IdxMap<type::StopPoint, DateTime> best_labels_pts_walking_for_snd_pass = best_labels_transfers_walking;
@@ -450,62 +488,254 @@ RAPTOR::Journeys RAPTOR::compute_all_journeys(const map_stop_point_duration& dep
     LOG4CPLUS_TRACE(raptor_logger, "starting points 2nd phase " << std::endl
                                                                 << print_starting_points_snd_phase(starting_points));
 
-    size_t nb_snd_pass = 0, nb_useless = 0, last_usefull_2nd_pass = 0, supplementary_2nd_pass = 0;
-    for (const auto& start : starting_points) {
-        navitia::type::StopPoint* start_stop_point = data.pt_data->stop_points[start.sp_idx.val];
+    // launch the second pass from start on the labels of raptor, adding its journeys in sols
+    const auto run_snd_pass = [&](RAPTOR& raptor, const StartingPointSndPhase& start, Solutions& sols) {
+        const auto& working_labels = first_pass_labels[start.count];
 
-        LOG4CPLUS_TRACE(raptor_logger, std::endl
-                                           << "Second pass from " << start_stop_point->uri
-                                           << "   count : " << start.count);
+        raptor.clear(!clockwise, departure_datetime + (clockwise ? -1 : 1));
+        map_stop_point_duration init_map;
+        init_map[start.sp_idx] = 0_s;
+        raptor.best_labels_pts = best_labels_pts_for_snd_pass;
+        raptor.best_labels_transfers = best_labels_transfers_for_snd_pass;
+        raptor.best_labels_pts_walking = best_labels_pts_walking_for_snd_pass;
+        raptor.best_labels_transfers_walking = best_labels_transfers_walking_for_snd_pass;
+        raptor.init(init_map, working_labels.dt_pt(start.sp_idx), !clockwise, accessibilite_params.properties);
+        raptor.boucleRAPTOR(!clockwise, rt_level, max_transfers);
+
+        read_solutions(raptor, sols, !clockwise, departure_datetime, departures, destinations, rt_level,
+                       accessibilite_params, transfer_penalty, start);
+    };
 
-        if (!start.has_priority) {
-            Journey fake_journey = convert_to_bound(start, clockwise);
+    size_t nb_snd_pass = 0, nb_useless = 0, last_usefull_2nd_pass = 0, supplementary_2nd_pass = 0;
+    bool max_reached = false;
+    // returns true if the second pass from start must be skipped, or
+    // if max_extra_second_pass is reached (then max_reached is set)
+    const auto skip_snd_pass = [&](const StartingPointSndPhase& start) {
+        if (start.has_priority) {
+            return false;
+        }
+        Journey fake_journey = convert_to_bound(start, clockwise);
 
-            if (solutions.contains_better_than(fake_journey)) {
-                LOG4CPLUS_TRACE(raptor_logger,
-                                "already found a better solution than the fake journey from " << start_stop_point->uri);
-                continue;
-            }
+        if (solutions.contains_better_than(fake_journey)) {
+            LOG4CPLUS_TRACE(raptor_logger, "already found a better solution than the fake journey from "
+                                               << data.pt_data->stop_points[start.sp_idx.val]->uri);
+            return true;
+        }
 
-            ++supplementary_2nd_pass;
+        ++supplementary_2nd_pass;
 
-            if (supplementary_2nd_pass > max_extra_second_pass) {
-                LOG4CPLUS_DEBUG(raptor_logger, "max second pass reached");
+        if (supplementary_2nd_pass > max_extra_second_pass) {
+            LOG4CPLUS_DEBUG(raptor_logger, "max second pass reached");
+            max_reached = true;
+            return true;
+        }
+        return false;
+    };
+
+    if (thread_pool && starting_points.size() > 1) {
+        // The second passes are independent: they are run by batches
+        // on the label sets of snd_pass_raptors, then the decisions of
+        // the sequential loop (skipping the passes that cannot give a
+        // better journey, max_extra_second_pass) are replayed in order
+        // while merging the batch.  A pass launched in a batch but
+        // skipped by the replay only cost some time: the result is the
+        // same as the sequential one.
+        prepare_snd_pass_raptors();
+        std::vector<const StartingPointSndPhase*> batch;
+        std::vector<Solutions> batch_solutions;
+        auto it = starting_points.begin();
+        while (it != starting_points.end() && !max_reached) {
+            batch.clear();
+            size_t nb_extra_in_batch = 0;
+            for (; it != starting_points.end() && batch.size() < snd_pass_raptors.size(); ++it) {
+                if (!it->has_priority) {
+                    if (supplementary_2nd_pass + nb_extra_in_batch >= max_extra_second_pass) {
+                        break;
+                    }
+                    if (solutions.contains_better_than(convert_to_bound(*it, clockwise))) {
+                        continue;
+                    }
+                    ++nb_extra_in_batch;
+                }
+                batch.push_back(&*it);
+            }
+            if (batch.empty()) {
                 break;
             }
+            batch_solutions.assign(batch.size(), Solutions(Dominates(clockwise, transfer_penalty)));
+            thread_pool->parallel_for(batch.size(), [&](size_t i) {
+                run_snd_pass(*snd_pass_raptors[i], *batch[i], batch_solutions[i]);
+            });
+
+            for (size_t i = 0; i < batch.size() && !max_reached; ++i) {
+                if (skip_snd_pass(*batch[i])) {
+                    continue;
+                }
+                for (const auto& journey : batch_solutions[i]) {
+                    solutions.add(journey);
+                }
+                ++nb_snd_pass;
+            }
         }
+        LOG4CPLUS_DEBUG(raptor_logger, "end of parallel second passes, nb of solutions : " << solutions.size());
+    } else {
+        for (const auto& start : starting_points) {
+            LOG4CPLUS_TRACE(raptor_logger, std::endl
+                                               << "Second pass from "
+                                               << data.pt_data->stop_points[start.sp_idx.val]->uri
+                                               << "   count : " << start.count);
+
+            if (skip_snd_pass(start)) {
+                if (max_reached) {
+                    break;
+                }
+                continue;
+            }
 
-        const auto& working_labels = first_pass_labels[start.count];
+            run_snd_pass(*this, start, solutions);
 
-        clear(!clockwise, departure_datetime + (clockwise ? -1 : 1));
-        map_stop_point_duration init_map;
-        init_map[start.sp_idx] = 0_s;
-        best_labels_pts = best_labels_pts_for_snd_pass;
-        best_labels_transfers = best_labels_transfers_for_snd_pass;
-        best_labels_pts_walking = best_labels_pts_walking_for_snd_pass;
-        best_labels_transfers_walking = best_labels_transfers_walking_for_snd_pass;
-        init(init_map, working_labels.dt_pt(start.sp_idx), !clockwise, accessibilite_params.properties);
-        boucleRAPTOR(!clockwise, rt_level, max_transfers);
-
-        read_solutions(*this, solutions, !clockwise, departure_datetime, departures, destinations, rt_level,
-                       accessibilite_params, transfer_penalty, start);
+            LOG4CPLUS_DEBUG(raptor_logger, "end of raptor loop body, nb of solutions : " << solutions.size());
 
-        LOG4CPLUS_DEBUG(raptor_logger, "end of raptor loop body, nb of solutions : " << solutions.size());
-
-        ++nb_snd_pass;
+            ++nb_snd_pass;
+        }
     }
 
     LOG4CPLUS_DEBUG(raptor_logger, "[2nd pass] number of 2nd pass = "
                                        << nb_snd_pass << " / " << starting_points.size() << " (nb useless = "
                                        << nb_useless << ", last usefull try = " << last_usefull_2nd_pass << ")");
-    auto end_raptor = std::chrono::system_clock::now();
-    LOG4CPLUS_DEBUG(raptor_logger,
-                    "[2nd pass] Run times: 1st pass = "
-                        << std::chrono::duration_cast<std::chrono::milliseconds>(end_first_pass - start_raptor).count()
-                        << ", 2nd pass = "
-                        << std::chrono::duration_cast<std::chrono::milliseconds>(end_raptor - end_first_pass).count());
+}
 
-    return solutions.get_pool();
+/*
+ * Returns the datetimes at which we can leave (resp. arrive when
+ * anticlockwise) the given stop points to board (resp. after alighting)
+ * a vehicle, between dt and limit, the fallback duration being taken
+ * into account.  They are sorted from the latest (resp. earliest) one,
+ * i.e. in the order rRAPTOR must process them.
+ */
+static std::vector<DateTime> get_profile_datetimes(const RAPTOR& raptor,
+                                                   const map_stop_point_duration& sps,
+                                                   const DateTime dt,
+                                                   const DateTime limit,
+                                                   const bool clockwise) {
+    const auto stop_event = clockwise ? StopEvent::pick_up : StopEvent::drop_off;
+    std::vector<DateTime> res;
+    for (const auto& sp_dur : sps) {
+        const DateTime sn_dur = sp_dur.second.total_seconds();
+        if (!clockwise && (dt < sn_dur || limit < sn_dur)) {
+            continue;
+        }
+        const DateTime from = clockwise ? dt + sn_dur : dt - sn_dur;
+        const DateTime to = clockwise ? limit + sn_dur : limit - sn_dur;
+        for (const auto& jpp : raptor.jpps_from_sp[sp_dur.first]) {
+            auto cur_dt = from;
+            while (true) {
+                const auto st_dt = raptor.next_st->next_stop_time(stop_event, jpp.idx, cur_dt, clockwise);
+                if (st_dt.first == nullptr || (clockwise ? st_dt.second > to : st_dt.second < to)) {
+                    break;
+                }
+                res.push_back(clockwise ? st_dt.second - sn_dur : st_dt.second + sn_dur);
+                if (!clockwise && st_dt.second == 0) {
+                    break;
+                }
+                cur_dt = clockwise ? st_dt.second + 1 : st_dt.second - 1;
+            }
+        }
+    }
+    if (clockwise) {
+        std::sort(res.begin(), res.end(), std::greater<DateTime>());
+    } else {
+        std::sort(res.begin(), res.end());
+    }
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+std::vector<RAPTOR::ProfileJourneys> RAPTOR::compute_all_journeys_profile(
+    const map_stop_point_duration& departures,
+    const map_stop_point_duration& destinations,
+    const DateTime& departure_datetime,
+    const DateTime& window_limit,
+    const nt::RTLevel rt_level,
+    const navitia::time_duration& transfer_penalty,
+    const DateTime& bound,
+    const uint32_t max_transfers,
+    const type::AccessibiliteParams& accessibilite_params,
+    bool clockwise,
+    const boost::optional<navitia::time_duration>& direct_path_dur,
+    const size_t max_extra_second_pass) {
+    std::vector<ProfileJourneys> res;
+    const auto& calc_dep = clockwise ? departures : destinations;
+    const auto& calc_dest = clockwise ? destinations : departures;
+
+    // same initialization as first_raptor_loop, but done once for all the runs
+    const DateTime first_pass_bound = limit_bound(clockwise, departure_datetime, bound);
+    assert(data.dataRaptor->cached_next_st_manager);
+    next_st = data.dataRaptor->cached_next_st_manager->load(clockwise ? departure_datetime : first_pass_bound,
+                                                            rt_level, accessibilite_params);
+    clear(clockwise, first_pass_bound);
+
+    const auto datetimes = get_profile_datetimes(*this, calc_dep, departure_datetime, window_limit, clockwise);
+    LOG4CPLUS_DEBUG(raptor_logger, "rRAPTOR on " << datetimes.size() << " datetimes");
+
+    // labels reached at the destinations before a run, to only
+    // launch the second pass from the ones improved by the run
+    std::vector<std::vector<std::pair<DateTime, DateTime>>> dest_labels;
+    auto is_improved = [&](const StartingPointSndPhase& sp) {
+        const auto& lbl = labels[sp.count];
+        if (sp.count >= dest_labels.size()) {
+            return true;
+        }
+        const auto it = calc_dest.find(sp.sp_idx);
+        const auto& prev = dest_labels[sp.count][it - calc_dest.begin()];
+        return prev.first != lbl.dt_pt(sp.sp_idx) || prev.second != lbl.walking_duration_pt(sp.sp_idx);
+    };
+
+    for (const auto& dt : datetimes) {
+        dest_labels.clear();
+        for (const auto& lbl : labels) {
+            dest_labels.emplace_back();
+            for (const auto& dest : calc_dest) {
+                dest_labels.back().emplace_back(lbl.dt_pt(dest.first), lbl.walking_duration_pt(dest.first));
+            }
+        }
+
+        // no clear: the labels of the previous (later) runs are still
+        // valid bounds as we can always wait for a later departure
+        init(calc_dep, dt, clockwise, accessibilite_params.properties);
+        boucleRAPTOR(clockwise, rt_level, max_transfers);
+
+        auto starting_points = make_starting_points_snd_phase(*this, calc_dest, accessibilite_params, clockwise);
+        boost::remove_erase_if(starting_points, [&](const StartingPointSndPhase& sp) { return !is_improved(sp); });
+        if (starting_points.empty()) {
+            continue;
+        }
+
+        // the second pass overwrites the labels of the first pass, we keep them for the next runs
+        const auto saved_best_labels_pts = best_labels_pts;
+        const auto saved_best_labels_transfers = best_labels_transfers;
+        const auto saved_best_labels_pts_walking = best_labels_pts_walking;
+        const auto saved_best_labels_transfers_walking = best_labels_transfers_walking;
+
+        auto solutions = Solutions(Dominates(clockwise, transfer_penalty));
+        add_direct_path(solutions, direct_path_dur, dt, clockwise);
+        second_pass(solutions, starting_points, departures, destinations, dt, rt_level, transfer_penalty,
+                    max_transfers, accessibilite_params, clockwise, max_extra_second_pass);
+
+        swap(labels, first_pass_labels);
+        best_labels_pts = saved_best_labels_pts;
+        best_labels_transfers = saved_best_labels_transfers;
+        best_labels_pts_walking = saved_best_labels_pts_walking;
+        best_labels_transfers_walking = saved_best_labels_transfers_walking;
+        const int queue_value = clockwise ? std::numeric_limits<int>::max() : -1;
+        Q.assign(data.dataRaptor->jp_container.get_jps_values(), queue_value);
+        marked_jps.clear();
+
+        res.push_back({dt, {}});
+        for (const auto& journey : solutions) {
+            res.back().journeys.push_back(journey);
+        }
+    }
+    return res;
 }
 
 void RAPTOR::isochrone(const map_stop_point_duration& departures,
@@ -599,6 +829,22 @@ struct ObjsFromIds {
 };
 }  // namespace
 
+void RAPTOR::prepare_snd_pass_raptors() {
+    while (snd_pass_raptors.size() < thread_pool->size()) {
+        snd_pass_raptors.push_back(std::make_unique<RAPTOR>(data, scan_marked_jps_only));
+    }
+    for (auto& raptor : snd_pass_raptors) {
+        raptor->next_st = next_st;
+        if (raptor->valid_generation == valid_generation) {
+            continue;
+        }
+        raptor->valid_journey_patterns = valid_journey_patterns;
+        raptor->valid_stop_points = valid_stop_points;
+        raptor->jpps_from_sp = jpps_from_sp;
+        raptor->valid_generation = valid_generation;
+    }
+}
+
 // Returns valid_jpps
 void RAPTOR::set_valid_jp_and_jpp(uint32_t date,
                                   const type::AccessibiliteParams& accessibilite_params,
@@ -655,12 +901,246 @@ void RAPTOR::set_valid_jp_and_jpp(uint32_t date,
         }
     }
 
-    // We get our own copy of jpps_from_sp to filter every invalid
-    // jpps.  Thanks to that, we don't need to check
-    // valid_journey_pattern[_point]s as we iterate only on the
-    // feasible ones.
-    jpps_from_sp = data.dataRaptor->jpps_from_sp;
-    jpps_from_sp.filter_jpps(valid_journey_pattern_points);
+    // jpps_from_sp only shows the valid jpps.  Thanks to that, we
+    // don't need to check valid_journey_pattern[_point]s as we
+    // iterate only on the feasible ones.
+    jpps_from_sp.valid_jpps = std::move(valid_journey_pattern_points);
+    ++valid_generation;
+}
+
+template <typename Visitor>
+bool RAPTOR::scan_journey_pattern(const Visitor& visitor,
+                                  const nt::RTLevel rt_level,
+                                  const JpIdx jp_idx,
+                                  const int jpp_order,
+                                  std::vector<PtLabelUpdate>* updates) {
+    /// We will scan the journey_pattern jp_idx, starting from its stop numbered jpp_order
+    const auto& prec_labels = labels[count - 1];
+    auto& working_labels = labels[count];
+    bool result = false;
+
+    const RouteIdx route_idx = data.dataRaptor->jp_container.get(jp_idx).route_idx;
+
+    /// we begin scanning the journey_pattern as if we were not yet aboard a vehicle
+    bool is_onboard = false;
+    DateTime workingDt = visitor.worst_datetime();
+    DateTime base_dt = workingDt;
+    DateTime working_walking_duration = DateTimeUtils::not_valid;
+    SpIdx boarding_stop_point = SpIdx();
+
+    /// will be used to iterate through the compressed StopTimeS of
+    /// the vehicle journey of the current journey_pattern (jp_idx)
+    ///  with the relevant departure date
+    typename Visitor::jp_stop_time_iterator it_st;  /// item = dataRAPTOR::JpStopTimes::StopTime
+    const type::VehicleJourney* onboard_vj = nullptr;
+    uint16_t l_zone = std::numeric_limits<uint16_t>::max();
+
+    LOG4CPLUS_TRACE(raptor_logger, " Scanning line  " << data.pt_data->routes[route_idx.val]->line->uri);
+
+    const auto& jpps_to_explore = visitor.jpps_from_order(data.dataRaptor->jpps_from_jp, jp_idx, jpp_order);
+    for (const dataRAPTOR::JppsFromJp::Jpp& jpp : jpps_to_explore) {
+        if (is_onboard) {
+            ++it_st;
+            // We update workingDt with the new arrival time
+            // We need at each journey pattern point when we have a st
+            // If we don't it might cause problem with overmidnight vj
+            const auto& st = *it_st;
+            workingDt = st.section_end(base_dt, visitor.clockwise());
+            // We check if there are no drop_off_only and if the local_zone is okay
+
+            const bool has_better_label =
+                visitor.comp(workingDt, best_labels_pts[jpp.sp_idx])
+                || (workingDt == best_labels_pts[jpp.sp_idx]
+                    && working_walking_duration < best_labels_pts_walking[jpp.sp_idx]);
+            if (st.valid_end(visitor.clockwise())
+                && (l_zone == std::numeric_limits<uint16_t>::max() || l_zone != st.local_traffic_zone)
+                && has_better_label
+                && valid_stop_points[jpp.sp_idx.val])  // we need to check the accessibility
+            {
+                LOG4CPLUS_TRACE(raptor_logger,
+                                "Updating label dt "
+                                    << "count : " << count << " sp "
+                                    << data.pt_data->stop_points[jpp.sp_idx.val]->uri << " from "
+                                    << iso_string(working_labels.dt_pt(jpp.sp_idx), data) << " to "
+                                    << iso_string(workingDt, data) << " throught : "
+                                    << onboard_vj->route->line->uri << " boarding_stop_point : "
+                                    << data.pt_data->stop_points[boarding_stop_point.val]->uri
+                                    << " walking : " << navitia::str(working_walking_duration)
+                                    << " old best : " << iso_string(best_labels_pts[jpp.sp_idx], data));
+
+                if (updates) {
+                    updates->push_back({jpp.sp_idx, workingDt, working_walking_duration});
+                } else {
+                    working_labels.mut_dt_pt(jpp.sp_idx) = workingDt;
+                    working_labels.mut_walking_duration_pt(jpp.sp_idx) = working_walking_duration;
+                    BOOST_ASSERT(working_fallback_duration != DateTimeUtils::not_valid);
+                    best_labels_pts[jpp.sp_idx] = workingDt;
+                    best_labels_pts_walking[jpp.sp_idx] = working_walking_duration;
+                }
+                result = true;
+            }
+        }
+
+        // We try to get on a vehicle, if we were already on a vehicle, but we arrived
+        // before on the previous via a connection, we try to catch a vehicle leaving this
+        // journey pattern point before
+
+        // if we cannot board at this stop point, nothing to do
+        if (!prec_labels.transfer_is_initialized(jpp.sp_idx) || !valid_stop_points[jpp.sp_idx.val]) {
+            continue;
+        }
+
+        /// the time at which we arrive at stop point jpp.sp_idx (using at most count-1 transfers)
+        //  hence we can board any vehicle arriving after previous_dt
+        const DateTime previous_dt = prec_labels.dt_transfer(jpp.sp_idx);
+        const DateTime previous_walking_duration = prec_labels.walking_duration_transfer(jpp.sp_idx);
+
+        /// we are at stop point jpp.idx at time previous_dt
+        /// waiting for the next vehicle journey of the journey_pattern jpp.jp_idx to embark on
+        /// the next vehicle journey will arrive at
+        ///   tmp_st_dt.second
+        /// the corresponding StopTime is
+        ///    tmp_st_dt.first
+        const auto tmp_st_dt = next_st->next_stop_time(visitor.stop_event(), jpp.idx, previous_dt, visitor.clockwise());
+
+        /// if there is no vehicle arriving after previous_dt, nothing to do
+        if (tmp_st_dt.first == nullptr) {
+            continue;
+        }
+
+        const auto candidate_board_time = tmp_st_dt.second;
+        const auto candidate_base_dt = tmp_st_dt.first->base_dt(candidate_board_time, visitor.clockwise());
+        const auto candidate_debark_time = visitor.clockwise() ? tmp_st_dt.first->arrival(candidate_base_dt)
+                                                               : tmp_st_dt.first->departure(candidate_base_dt);
+
+        bool update_boarding_stop_point = !is_onboard || visitor.comp(candidate_debark_time, workingDt)
+                                          || (candidate_debark_time == workingDt
+                                              && previous_walking_duration <= working_walking_duration);
+
+        // LOG4CPLUS_TRACE(raptor_logger, "Try boarding stop point  "
+        //                                    << data.pt_data->stop_points[jpp.sp_idx.val]->uri
+        //                                    << " debark : " << iso_string(candidate_debark_time, data)
+        //                                    << " onboard  : " << iso_string(tmp_st_dt.second, data)
+        //                                    << " waiting  : " << iso_string(previous_dt, data)
+        //                                    << " walking : " << navitia::str(previous_walking_duration)
+        //                                    << "\n vs : "
+        //                                    << " working dt : " << iso_string(workingDt, data)
+        //                                    << " walking : " << navitia::str(working_walking_duration));
+
+        if (update_boarding_stop_point) {
+            /// we are at stop point jpp.idx at time previous_dt
+            /// waiting for the next vehicle journey of the journey_pattern jpp.jp_idx to embark on
+            /// the next vehicle journey will arrive at
+            ///   tmp_st_dt.second
+            /// the corresponding StopTime is
+            ///    tmp_st_dt.first
+            // const auto tmp_st_dt =
+            //     next_st->next_stop_time(visitor.stop_event(), jpp.idx, previous_dt, visitor.clockwise());
+            if (tmp_st_dt.first != nullptr) {
+                // we only need the StopTime to find its compressed
+                // counterpart, the scan itself stays in jp_stop_times
+                const auto candidate_it_st =
+                    visitor.jp_st_iterator(data.dataRaptor->jp_stop_times.get(*tmp_st_dt.first));
+                if (!is_onboard || it_st != candidate_it_st) {
+                    it_st = candidate_it_st;
+                    onboard_vj = tmp_st_dt.first->vehicle_journey;
+                    is_onboard = true;
+                    l_zone = it_st->local_traffic_zone;
+                    // note that if we have found a better
+                    // pickup, and that this pickup does
+                    // not have the same local traffic
+                    // zone, we may miss some interesting
+                    // solutions.
+                } else if (l_zone != it_st->local_traffic_zone) {
+                    // if we can pick up in this vj with 2
+                    // different zones, we can drop off
+                    // anywhere (we'll chose later at
+                    // which stop we pickup)
+                    l_zone = std::numeric_limits<uint16_t>::max();
+                }
+
+                // if (boarding_stop_point == SpIdx()) {
+                //     LOG4CPLUS_TRACE(raptor_logger,
+                //                     "Setting boarding stop point  "
+                //                         << " to " << data.pt_data->stop_points[jpp.sp_idx.val]->uri
+                //                         << " working dt : " << iso_string(tmp_st_dt.second, data)
+                //                         << " walking : " << navitia::str(previous_walking_duration));
+                // } else {
+                //     LOG4CPLUS_TRACE(raptor_logger,
+                //                     "Switching boarding stop point : "
+                //                         << " from "
+                //                         << data.pt_data->stop_points[boarding_stop_point.val]->uri << "
+                //                         to "
+                //                         << data.pt_data->stop_points[jpp.sp_idx.val]->uri
+                //                         << " working dt before : " << iso_string(workingDt, data)
+                //                         << " working dt after : " << iso_string(tmp_st_dt.second, data)
+                //                         << " walking before : " << navitia::str(working_walking_duration)
+                //                         << " walking after : " <<
+                //                         navitia::str(previous_walking_duration));
+                // }
+                workingDt = candidate_debark_time;
+                working_walking_duration = previous_walking_duration;
+                boarding_stop_point = jpp.sp_idx;
+
+                base_dt = candidate_base_dt;
+                BOOST_ASSERT(!visitor.comp(workingDt, previous_dt));
+            }
+        }
+    }
+    if (is_onboard) {
+        const type::VehicleJourney* vj_stay_in = visitor.get_extension_vj(onboard_vj);
+        if (vj_stay_in) {
+            bool applied = apply_vj_extension(visitor, rt_level, vj_stay_in, l_zone, base_dt,
+                                              working_walking_duration, boarding_stop_point, updates);
+            result = result || applied;
+        }
+    }
+    return result;
+}
+
+template <typename Visitor>
+bool RAPTOR::scan_marked_jps_parallel(const Visitor& visitor, const nt::RTLevel rt_level) {
+    // Consecutive marked journey patterns are grouped in chunks, a few
+    // per thread to balance the load, and a thread finishing its chunk
+    // takes the next remaining one.  During the scan, the labels are
+    // only read: each chunk stores its improvements in its own buffer.
+    const size_t nb_jps = marked_jps.size();
+    const size_t nb_chunks = std::min(nb_jps, thread_pool->size() * NB_CHUNKS_PER_THREAD);
+    if (pt_label_updates.size() < nb_chunks) {
+        pt_label_updates.resize(nb_chunks);
+    }
+    thread_pool->parallel_for(nb_chunks, [&](size_t chunk) {
+        auto& updates = pt_label_updates[chunk];
+        updates.clear();
+        for (size_t i = nb_jps * chunk / nb_chunks; i < nb_jps * (chunk + 1) / nb_chunks; ++i) {
+            scan_journey_pattern(visitor, rt_level, marked_jps[i], Q[marked_jps[i]], &updates);
+        }
+    });
+
+    // The improvements are applied in the order of the journey
+    // patterns, as during a sequential scan, thus the labels are the
+    // same whatever the number of threads.
+    auto& working_labels = labels[count];
+    bool result = false;
+    for (size_t chunk = 0; chunk < nb_chunks; ++chunk) {
+        for (const auto& update : pt_label_updates[chunk]) {
+            if (visitor.comp(update.dt, best_labels_pts[update.sp_idx])
+                || (update.dt == best_labels_pts[update.sp_idx]
+                    && update.walking_duration < best_labels_pts_walking[update.sp_idx])) {
+                working_labels.mut_dt_pt(update.sp_idx) = update.dt;
+                working_labels.mut_walking_duration_pt(update.sp_idx) = update.walking_duration;
+                best_labels_pts[update.sp_idx] = update.dt;
+                best_labels_pts_walking[update.sp_idx] = update.walking_duration;
+                result = true;
+            }
+        }
+    }
+
+    for (const auto jp_idx : marked_jps) {
+        /// mark the journey_pattern as visited, no need to explore it in the next round
+        Q[jp_idx] = visitor.init_queue_item();
+    }
+    return result;
 }
 
 template <typename Visitor>
@@ -678,196 +1158,35 @@ void RAPTOR::raptor_loop(Visitor visitor, const nt::RTLevel rt_level, uint32_t m
                 this->labels.push_back(this->data.dataRaptor->labels_const_reverse);
             }
         }
-        const auto& prec_labels = labels[count - 1];
-        auto& working_labels = labels[this->count];
-        /*
-         * We need to store it so we can apply stay_in after applying normal vjs
-         * We want to do it, to favoritize normal vj against stay_in vjs
-         */
-        for (auto q_elt : Q) {
-            /// We will scan the journey_pattern q_elt.first, starting from its stop numbered q_elt.second
-
-            const JpIdx jp_idx = q_elt.first;
-
-            const RouteIdx route_idx = data.dataRaptor->jp_container.get(jp_idx).route_idx;
-
-            /// q_elt.second == visitor.init_queue_item() means that
-            /// this journey_pattern is marked "not to be scanned"
-            if (q_elt.second != visitor.init_queue_item()) {
-                /// we begin scanning the journey_pattern as if we were not yet aboard a vehicle
-                bool is_onboard = false;
-                DateTime workingDt = visitor.worst_datetime();
-                DateTime base_dt = workingDt;
-                DateTime working_walking_duration = DateTimeUtils::not_valid;
-                SpIdx boarding_stop_point = SpIdx();
-
-                /// will be used to iterate through the StopTimeS of
-                /// the vehicle journey of the current journey_pattern (jp_idx)
-                ///  with the relevant departure date
-                typename Visitor::stop_time_iterator it_st;  /// item = type::StopTime
-                uint16_t l_zone = std::numeric_limits<uint16_t>::max();
-
-                LOG4CPLUS_TRACE(raptor_logger, " Scanning line  " << data.pt_data->routes[route_idx.val]->line->uri);
-
-                const auto& jpps_to_explore =
-                    visitor.jpps_from_order(data.dataRaptor->jpps_from_jp, jp_idx, q_elt.second);
-                for (const dataRAPTOR::JppsFromJp::Jpp& jpp : jpps_to_explore) {
-                    if (is_onboard) {
-                        ++it_st;
-                        // We update workingDt with the new arrival time
-                        // We need at each journey pattern point when we have a st
-                        // If we don't it might cause problem with overmidnight vj
-                        const type::StopTime& st = *it_st;
-                        workingDt = st.section_end(base_dt, visitor.clockwise());
-                        // We check if there are no drop_off_only and if the local_zone is okay
-
-                        const bool has_better_label =
-                            visitor.comp(workingDt, best_labels_pts[jpp.sp_idx])
-                            || (workingDt == best_labels_pts[jpp.sp_idx]
-                                && working_walking_duration < best_labels_pts_walking[jpp.sp_idx]);
-                        if (st.valid_end(visitor.clockwise())
-                            && (l_zone == std::numeric_limits<uint16_t>::max() || l_zone != st.local_traffic_zone)
-                            && has_better_label
-                            && valid_stop_points[jpp.sp_idx.val])  // we need to check the accessibility
-                        {
-                            LOG4CPLUS_TRACE(raptor_logger,
-                                            "Updating label dt "
-                                                << "count : " << count << " sp "
-                                                << data.pt_data->stop_points[jpp.sp_idx.val]->uri << " from "
-                                                << iso_string(working_labels.dt_pt(jpp.sp_idx), data) << " to "
-                                                << iso_string(workingDt, data) << " throught : "
-                                                << st.vehicle_journey->route->line->uri << " boarding_stop_point : "
-                                                << data.pt_data->stop_points[boarding_stop_point.val]->uri
-                                                << " walking : " << navitia::str(working_walking_duration)
-                                                << " old best : " << iso_string(best_labels_pts[jpp.sp_idx], data));
-
-                            working_labels.mut_dt_pt(jpp.sp_idx) = workingDt;
-                            working_labels.mut_walking_duration_pt(jpp.sp_idx) = working_walking_duration;
-                            BOOST_ASSERT(working_fallback_duration != DateTimeUtils::not_valid);
-                            best_labels_pts[jpp.sp_idx] = workingDt;
-                            best_labels_pts_walking[jpp.sp_idx] = working_walking_duration;
-                            continue_algorithm = true;
-                        }
-                    }
-
-                    // We try to get on a vehicle, if we were already on a vehicle, but we arrived
-                    // before on the previous via a connection, we try to catch a vehicle leaving this
-                    // journey pattern point before
-
-                    // if we cannot board at this stop point, nothing to do
-                    if (!prec_labels.transfer_is_initialized(jpp.sp_idx) || !valid_stop_points[jpp.sp_idx.val]) {
-                        continue;
-                    }
-
-                    /// the time at which we arrive at stop point jpp.sp_idx (using at most count-1 transfers)
-                    //  hence we can board any vehicle arriving after previous_dt
-                    const DateTime previous_dt = prec_labels.dt_transfer(jpp.sp_idx);
-                    const DateTime previous_walking_duration = prec_labels.walking_duration_transfer(jpp.sp_idx);
-
-                    /// we are at stop point jpp.idx at time previous_dt
-                    /// waiting for the next vehicle journey of the journey_pattern jpp.jp_idx to embark on
-                    /// the next vehicle journey will arrive at
-                    ///   tmp_st_dt.second
-                    /// the corresponding StopTime is
-                    ///    tmp_st_dt.first
-                    const auto tmp_st_dt =
-                        next_st->next_stop_time(visitor.stop_event(), jpp.idx, previous_dt, visitor.clockwise());
-
-                    /// if there is no vehicle arriving after previous_dt, nothing to do
-                    if (tmp_st_dt.first == nullptr) {
-                        continue;
-                    }
-
-                    const auto candidate_board_time = tmp_st_dt.second;
-                    const auto candidate_base_dt = tmp_st_dt.first->base_dt(candidate_board_time, visitor.clockwise());
-                    const auto candidate_debark_time = visitor.clockwise()
-                                                           ? tmp_st_dt.first->arrival(candidate_base_dt)
-                                                           : tmp_st_dt.first->departure(candidate_base_dt);
-
-                    bool update_boarding_stop_point = !is_onboard || visitor.comp(candidate_debark_time, workingDt)
-                                                      || (candidate_debark_time == workingDt
-                                                          && previous_walking_duration <= working_walking_duration);
-
-                    // LOG4CPLUS_TRACE(raptor_logger, "Try boarding stop point  "
-                    //                                    << data.pt_data->stop_points[jpp.sp_idx.val]->uri
-                    //                                    << " debark : " << iso_string(candidate_debark_time, data)
-                    //                                    << " onboard  : " << iso_string(tmp_st_dt.second, data)
-                    //                                    << " waiting  : " << iso_string(previous_dt, data)
-                    //                                    << " walking : " << navitia::str(previous_walking_duration)
-                    //                                    << "\n vs : "
-                    //                                    << " working dt : " << iso_string(workingDt, data)
-                    //                                    << " walking : " << navitia::str(working_walking_duration));
-
-                    if (update_boarding_stop_point) {
-                        /// we are at stop point jpp.idx at time previous_dt
-                        /// waiting for the next vehicle journey of the journey_pattern jpp.jp_idx to embark on
-                        /// the next vehicle journey will arrive at
-                        ///   tmp_st_dt.second
-                        /// the corresponding StopTime is
-                        ///    tmp_st_dt.first
-                        // const auto tmp_st_dt =
-                        //     next_st->next_stop_time(visitor.stop_event(), jpp.idx, previous_dt, visitor.clockwise());
-                        if (tmp_st_dt.first != nullptr) {
-                            if (!is_onboard || &*it_st != tmp_st_dt.first) {
-                                // st_range is quite cache
-                                // unfriendly, so avoid using it if
-                                // not really needed.
-                                it_st = visitor.st_range(*tmp_st_dt.first).begin();
-                                is_onboard = true;
-                                l_zone = it_st->local_traffic_zone;
-                                // note that if we have found a better
-                                // pickup, and that this pickup does
-                                // not have the same local traffic
-                                // zone, we may miss some interesting
-                                // solutions.
-                            } else if (l_zone != it_st->local_traffic_zone) {
-                                // if we can pick up in this vj with 2
-                                // different zones, we can drop off
-                                // anywhere (we'll chose later at
-                                // which stop we pickup)
-                                l_zone = std::numeric_limits<uint16_t>::max();
-                            }
-
-                            // if (boarding_stop_point == SpIdx()) {
-                            //     LOG4CPLUS_TRACE(raptor_logger,
-                            //                     "Setting boarding stop point  "
-                            //                         << " to " << data.pt_data->stop_points[jpp.sp_idx.val]->uri
-                            //                         << " working dt : " << iso_string(tmp_st_dt.second, data)
-                            //                         << " walking : " << navitia::str(previous_walking_duration));
-                            // } else {
-                            //     LOG4CPLUS_TRACE(raptor_logger,
-                            //                     "Switching boarding stop point : "
-                            //                         << " from "
-                            //                         << data.pt_data->stop_points[boarding_stop_point.val]->uri << "
-                            //                         to "
-                            //                         << data.pt_data->stop_points[jpp.sp_idx.val]->uri
-                            //                         << " working dt before : " << iso_string(workingDt, data)
-                            //                         << " working dt after : " << iso_string(tmp_st_dt.second, data)
-                            //                         << " walking before : " << navitia::str(working_walking_duration)
-                            //                         << " walking after : " <<
-                            //                         navitia::str(previous_walking_duration));
-                            // }
-                            workingDt = candidate_debark_time;
-                            working_walking_duration = previous_walking_duration;
-                            boarding_stop_point = jpp.sp_idx;
-
-                            base_dt = candidate_base_dt;
-                            BOOST_ASSERT(!visitor.comp(workingDt, previous_dt));
-                        }
+        if (scan_marked_jps_only) {
+            // Only the journey patterns marked at the previous round can improve a label.
+            // The scanning order has no influence on the labels, but we keep the
+            // one of the full sweep to be strictly identical.
+            std::sort(marked_jps.begin(), marked_jps.end());
+            if (thread_pool && marked_jps.size() >= MIN_NB_JPS_FOR_PARALLEL_SCAN) {
+                continue_algorithm = scan_marked_jps_parallel(visitor, rt_level);
+            } else {
+                for (const auto jp_idx : marked_jps) {
+                    if (scan_journey_pattern(visitor, rt_level, jp_idx, Q[jp_idx])) {
+                        continue_algorithm = true;
                     }
+                    /// mark the journey_pattern as visited, no need to explore it in the next round
+                    Q[jp_idx] = visitor.init_queue_item();
                 }
-                if (is_onboard) {
-                    const type::VehicleJourney* vj_stay_in = visitor.get_extension_vj(it_st->vehicle_journey);
-                    if (vj_stay_in) {
-                        bool applied = apply_vj_extension(visitor, rt_level, vj_stay_in, l_zone, base_dt,
-                                                          working_walking_duration, boarding_stop_point);
-                        continue_algorithm = continue_algorithm || applied;
-                    }
+            }
+        } else {
+            for (auto q_elt : Q) {
+                /// q_elt.second == visitor.init_queue_item() means that
+                /// this journey_pattern is marked "not to be scanned"
+                if (q_elt.second != visitor.init_queue_item()
+                    && scan_journey_pattern(visitor, rt_level, q_elt.first, q_elt.second)) {
+                    continue_algorithm = true;
                 }
+                /// mark the journey_pattern as visited, no need to explore it in the next round
+                q_elt.second = visitor.init_queue_item();
             }
-            /// mark the journey_pattern as visited, no need to explore it in the next round
-            q_elt.second = visitor.init_queue_item();
         }
+        marked_jps.clear();
         if (continue_algorithm) {
             continue_algorithm = this->foot_path(visitor);
         }
@@ -47,11 +47,13 @@ www.navitia.io
 #include "utils/timer.h"
 #include "dataraptor.h"
 #include "raptor_utils.h"
+#include "thread_pool.h"
 
 #include "dataraptor.h"
 #include <unordered_map>
 #include <queue>
 #include <limits>
+#include <memory>
 
 namespace navitia {
 namespace routing {
@@ -70,6 +72,12 @@ struct StartingPointSndPhase {
 struct RAPTOR {
     typedef std::list<Journey> Journeys;
 
+    /// Journeys found by a profile query for one departure (resp. arrival) datetime
+    struct ProfileJourneys {
+        DateTime datetime;
+        Journeys journeys;
+    };
+
     const navitia::type::Data& data;
 
     std::shared_ptr<const CachedNextStopTime> next_st;
@@ -89,16 +97,39 @@ struct RAPTOR {
     unsigned int count;
     /// Are the journey pattern valid
     boost::dynamic_bitset<> valid_journey_patterns;
-    dataRAPTOR::JppsFromSp jpps_from_sp;
+    /// The jpps of each stop point, restricted to the valid ones
+    dataRAPTOR::FilteredJppsFromSp jpps_from_sp;
     /// Order of the first journey_pattern point of each journey_pattern
     IdxMap<JourneyPattern, int> Q;
+    /// Journey patterns marked in Q (i.e. with a value different from the init queue item)
+    std::vector<JpIdx> marked_jps;
+    /// If true, a round only scans the journey patterns of marked_jps instead of sweeping all Q
+    bool scan_marked_jps_only;
 
     // set to store if the stop_point is valid
     boost::dynamic_bitset<> valid_stop_points;
 
+    /// Label improvement found by a parallel scan, applied at the end of the round
+    struct PtLabelUpdate {
+        SpIdx sp_idx;
+        DateTime dt;
+        DateTime walking_duration;
+    };
+    /// Threads used to scan the marked journey patterns of a round, null if the scan is sequential.
+    /// Not owned: the pool outlives the RAPTORs built on the successive data
+    ThreadPool* thread_pool = nullptr;
+    /// One buffer of label improvements per chunk of marked journey patterns scanned in parallel
+    std::vector<std::vector<PtLabelUpdate>> pt_label_updates;
+    /// Label sets used to run the second passes in parallel, one per thread of thread_pool
+    std::vector<std::unique_ptr<RAPTOR>> snd_pass_raptors;
+    /// Incremented each time the valid journey patterns and stop points change
+    size_t valid_generation = 0;
+
     log4cplus::Logger raptor_logger;
 
-    explicit RAPTOR(const navitia::type::Data& data)
+    explicit RAPTOR(const navitia::type::Data& data,
+                    const bool scan_marked_jps_only = true,
+                    ThreadPool* thread_pool = nullptr)
         : data(data),
           best_labels_pts(data.pt_data->stop_points),
           best_labels_transfers(data.pt_data->stop_points),
@@ -106,11 +137,17 @@ struct RAPTOR {
           best_labels_transfers_walking(data.pt_data->stop_points),
           count(0),
           valid_journey_patterns(data.dataRaptor->jp_container.nb_jps()),
+          jpps_from_sp(data.dataRaptor->jpps_from_sp, data.dataRaptor->jp_container.nb_jpps()),
           Q(data.dataRaptor->jp_container.get_jps_values()),
+          scan_marked_jps_only(scan_marked_jps_only),
           valid_stop_points(data.pt_data->stop_points.size()),
           raptor_logger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("raptor"))) {
         labels.assign(10, data.dataRaptor->labels_const);
         first_pass_labels.assign(10, data.dataRaptor->labels_const);
+        marked_jps.reserve(data.dataRaptor->jp_container.nb_jps());
+        if (thread_pool && thread_pool->size() > 1) {
+            this->thread_pool = thread_pool;
+        }
     }
 
     void clear(const bool clockwise, const DateTime bound);
@@ -168,6 +205,33 @@ struct RAPTOR {
                                   const boost::optional<navitia::time_duration>& direct_path_dur = boost::none,
                                   const size_t max_extra_second_pass = 0);
 
+    /** Range-RAPTOR (rRAPTOR) profile query.
+     *
+     * Computes the journeys for every departure (resp. arrival when
+     * anticlockwise) of a vehicle at the departure stop points between
+     * departure_datetime and window_limit.  The departures are processed
+     * from the latest (resp. earliest) one, and the labels of the first
+     * pass are kept from one departure to the other, thus each run only
+     * explores what is improved by leaving earlier.
+     *
+     * The result contains, for each processed datetime that improves at
+     * least one arrival, the journeys found for this datetime, from the
+     * latest processed to the earliest.
+     */
+    std::vector<ProfileJourneys> compute_all_journeys_profile(
+        const map_stop_point_duration& departures,
+        const map_stop_point_duration& destinations,
+        const DateTime& departure_datetime,
+        const DateTime& window_limit,
+        const nt::RTLevel rt_level,
+        const navitia::time_duration& transfer_penalty,
+        const DateTime& bound = DateTimeUtils::inf,
+        const uint32_t max_transfers = 10,
+        const type::AccessibiliteParams& accessibilite_params = type::AccessibiliteParams(),
+        bool clockwise = true,
+        const boost::optional<navitia::time_duration>& direct_path_dur = boost::none,
+        const size_t max_extra_second_pass = 0);
+
     template <class T>
     std::vector<Path> from_journeys_to_path(const T& journeys) const {
         std::vector<Path> result;
@@ -218,7 +282,37 @@ struct RAPTOR {
                             const uint16_t l_zone,
                             DateTime workingDate,
                             DateTime working_walking_duration,
-                            SpIdx boarding_stop_point);
+                            SpIdx boarding_stop_point,
+                            std::vector<PtLabelUpdate>* updates = nullptr);
+
+    /// Lower (resp. raise when anticlockwise) the order from which the journey pattern of jpp
+    /// will be scanned at the next round, and register it in marked_jps when newly marked
+    inline void mark_jpp(const dataRAPTOR::JppsFromSp::Jpp& jpp, const bool clockwise) {
+        int& order = Q[jpp.jp_idx];
+        if (clockwise ? jpp.order < order : jpp.order > order) {
+            if (order == (clockwise ? std::numeric_limits<int>::max() : -1)) {
+                marked_jps.push_back(jpp.jp_idx);
+            }
+            order = jpp.order;
+        }
+    }
+
+    /// Scan the journey pattern jp_idx from its journey pattern point of order jpp_order
+    /// Returns true if we improve at least one label, false otherwise
+    ///
+    /// If updates is given, the labels are not modified: the improvements are pushed in updates
+    template <typename Visitor>
+    bool scan_journey_pattern(const Visitor& visitor,
+                              const nt::RTLevel rt_level,
+                              const JpIdx jp_idx,
+                              const int jpp_order,
+                              std::vector<PtLabelUpdate>* updates = nullptr);
+
+    /// Scan the marked journey patterns on the thread pool, then apply the improvements
+    /// in the journey pattern order, giving the same labels as a sequential scan
+    /// Returns true if we improve at least one label, false otherwise
+    template <typename Visitor>
+    bool scan_marked_jps_parallel(const Visitor& visitor, const nt::RTLevel rt_level);
 
     /// Main loop
     template <typename Visitor>
@@ -240,6 +334,25 @@ struct RAPTOR {
                            const type::AccessibiliteParams& accessibilite_params,
                            const bool clockwise);
 
+    /// Give to snd_pass_raptors the valid objects and next stop times of this RAPTOR
+    void prepare_snd_pass_raptors();
+
+    /// Second pass: from each starting point, computes the best journey in the other direction
+    /// and adds it in solutions
+    ///
+    /// With a thread pool, the passes are run concurrently on snd_pass_raptors
+    void second_pass(Solutions& solutions,
+                     const std::vector<StartingPointSndPhase>& starting_points,
+                     const map_stop_point_duration& departures,
+                     const map_stop_point_duration& destinations,
+                     const DateTime& departure_datetime,
+                     const nt::RTLevel rt_level,
+                     const navitia::time_duration& transfer_penalty,
+                     const uint32_t max_transfers,
+                     const type::AccessibiliteParams& accessibilite_params,
+                     const bool clockwise,
+                     const size_t max_extra_second_pass);
+
     ~RAPTOR() = default;
 
     std::string print_all_labels();
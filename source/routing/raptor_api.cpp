@@ -43,6 +43,7 @@ www.navitia.io
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/range/algorithm/count.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <string>
 #include <unordered_set>
@@ -113,6 +114,9 @@ static boost::optional<DateTime> get_timeframe_limit(const DateTime request_date
 
 /**
  * @brief internal function to call raptor in a loop
+ *
+ * If a journey cache is given, the pathes are looked up in it before
+ * calling raptor, and stored in it afterwards.
  */
 static std::vector<Path> call_raptor(navitia::PbCreator& pb_creator,
                                      RAPTOR& raptor,
@@ -133,10 +137,32 @@ static std::vector<Path> call_raptor(navitia::PbCreator& pb_creator,
                                      const size_t max_extra_second_pass,
                                      const double night_bus_filter_max_factor,
                                      const int32_t night_bus_filter_base_factor,
-                                     const boost::optional<uint32_t>& timeframe_duration) {
+                                     const boost::optional<uint32_t>& timeframe_duration,
+                                     JourneyCache* journey_cache) {
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
 
+    boost::optional<JourneyCache::Key> cache_key;
+    if (journey_cache) {
+        std::vector<DateTime> request_datetimes;
+        for (const auto& datetime : datetimes) {
+            request_datetimes.push_back(to_datetime(datetime, raptor.data));
+        }
+        cache_key = JourneyCache::Key(departures, destinations, std::move(request_datetimes), rt_level,
+                                      transfer_penalty, accessibilite_params, forbidden_uri, allowed_ids, clockwise,
+                                      direct_path_duration, min_nb_journeys, nb_direct_path, max_duration,
+                                      max_transfers, max_extra_second_pass, night_bus_filter_max_factor,
+                                      night_bus_filter_base_factor, timeframe_duration);
+        if (const auto cached = journey_cache->get(raptor.data.data_identifier, *cache_key)) {
+            LOG4CPLUS_DEBUG(logger, "journey cache hit, " << cached->pathes.size() << " Path(es)");
+            if (cached->next_request_date_time) {
+                pb_creator.set_next_request_date_time(*cached->next_request_date_time);
+            }
+            return cached->pathes;
+        }
+    }
+
     std::vector<Path> pathes;
+    boost::optional<uint64_t> next_request_date_time;
 
     // We loop on datetimes, but in practice there's always only one
     // (It's a deprecated feature to provide multiple datetimes).
@@ -168,7 +194,45 @@ static std::vector<Path> call_raptor(navitia::PbCreator& pb_creator,
         raptor.set_valid_jp_and_jpp(DateTimeUtils::date(request_date_secs), accessibilite_params, forbidden_uri,
                                     allowed_ids, rt_level);
 
-        do {
+        // With a time frame, all the departures inside it are computed
+        // in one profile query instead of shifting the request datetime
+        // after each raptor call.
+        bool raptor_called = false;
+        if (timeframe_limit) {
+            auto profile = raptor.compute_all_journeys_profile(
+                departures, destinations, request_date_secs, *timeframe_limit, rt_level, transfer_penalty, bound,
+                max_transfers, accessibilite_params, clockwise, direct_path_duration, max_extra_second_pass);
+
+            LOG4CPLUS_DEBUG(logger, "raptor profile found solutions for " << profile.size() << " datetimes");
+
+            for (auto& profile_journeys : profile) {
+                filter_direct_path(profile_journeys.journeys);
+                NightBusFilter::Params params{profile_journeys.datetime, clockwise, night_bus_filter_max_factor,
+                                              night_bus_filter_base_factor};
+                filter_late_journeys(profile_journeys.journeys, params);
+                for (const auto& journey : profile_journeys.journeys) {
+                    journeys.insert(journey);
+                }
+            }
+
+            nb_try++;
+            total_nb_journeys = journeys.size() + nb_direct_path;
+
+            // the whole time frame has been explored, the next call
+            // (if any) starts after it, or after the last journey found
+            // (the first datetime processed by the profile query)
+            request_date_secs = *timeframe_limit;
+            if (!profile.empty() && !profile.front().journeys.empty()) {
+                const auto next = prepare_next_call_for_raptor(profile.front().journeys, clockwise);
+                request_date_secs = clockwise ? std::max(next, request_date_secs) : std::min(next, request_date_secs);
+            }
+            raptor_called = true;
+        }
+
+        while (!raptor_called
+               || keep_going(total_nb_journeys, nb_try, clockwise, request_date_secs, min_nb_journeys,
+                             timeframe_limit, max_transfers)) {
+            raptor_called = true;
             auto raptor_journeys = raptor.compute_all_journeys(
                 departures, destinations, request_date_secs, rt_level, transfer_penalty, bound, max_transfers,
                 accessibilite_params, clockwise, direct_path_duration, max_extra_second_pass);
@@ -200,13 +264,12 @@ static std::vector<Path> call_raptor(navitia::PbCreator& pb_creator,
 
             // Prepare next call for raptor with min_nb_journeys option
             request_date_secs = prepare_next_call_for_raptor(raptor_journeys, clockwise);
-
-        } while (keep_going(total_nb_journeys, nb_try, clockwise, request_date_secs, min_nb_journeys, timeframe_limit,
-                            max_transfers));
+        }
 
         // create date time for next
         if (request_date_secs != to_datetime(datetime, raptor.data)) {
-            pb_creator.set_next_request_date_time(to_posix_timestamp(request_date_secs, raptor.data));
+            next_request_date_time = to_posix_timestamp(request_date_secs, raptor.data);
+            pb_creator.set_next_request_date_time(*next_request_date_time);
         }
 
         auto tmp_pathes = raptor.from_journeys_to_path(journeys);
@@ -233,6 +296,10 @@ static std::vector<Path> call_raptor(navitia::PbCreator& pb_creator,
         }
     }
 
+    if (journey_cache) {
+        journey_cache->add(raptor.data.data_identifier, *cache_key, {pathes, next_request_date_time});
+    }
+
     return pathes;
 }
 
@@ -1088,10 +1155,13 @@ boost::optional<routing::map_stop_point_duration> get_stop_points(const type::En
             }
             const auto admin = data.geo_ref->admins[it_admin->second];
 
-            for (auto stop_area : admin->main_stop_areas) {
-                for (auto stop_point : stop_area->stop_point_list) {
-                    add_free_stop_point(stop_point, concerned_path_finder, result);
-                }
+            for (const auto& sa_uri : admin->main_stop_area_uris) {
+                utils::make_map_find(data.pt_data->stop_areas_map, sa_uri)
+                    .if_found([&](const type::StopArea* stop_area) {
+                        for (auto stop_point : stop_area->stop_point_list) {
+                            add_free_stop_point(stop_point, concerned_path_finder, result);
+                        }
+                    });
             }
             break;
         }
@@ -1107,8 +1177,11 @@ boost::optional<routing::map_stop_point_duration> get_stop_points(const type::En
     // we need to check if the admin has zone odt
     const auto& admins = find_admins(ep, data);
     for (const auto* admin : admins) {
-        for (const auto* odt_admin_stop_point : admin->odt_stop_points) {
-            add_free_stop_point(odt_admin_stop_point, concerned_path_finder, result);
+        for (const auto& odt_sp_uri : admin->odt_stop_point_uris) {
+            utils::make_map_find(data.pt_data->stop_points_map, odt_sp_uri)
+                .if_found([&](const type::StopPoint* stop_point) {
+                    add_free_stop_point(stop_point, concerned_path_finder, result);
+                });
         }
     }
 
@@ -1265,7 +1338,8 @@ void make_pt_response(navitia::PbCreator& pb_creator,
                       const double night_bus_filter_max_factor,
                       const int32_t night_bus_filter_base_factor,
                       const boost::optional<DateTime>& timeframe_duration,
-                      const uint32_t depth) {
+                      const uint32_t depth,
+                      JourneyCache* journey_cache) {
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
 
     // Create datetime
@@ -1284,7 +1358,7 @@ void make_pt_response(navitia::PbCreator& pb_creator,
                     accessibilite_params, forbidden, allowed, clockwise, direct_path_duration, min_nb_journeys,
                     // nb_direct_path = 0 for distributed if direct_path_duration is none
                     direct_path_duration ? 1 : 0, max_duration, max_transfers, max_extra_second_pass,
-                    night_bus_filter_max_factor, night_bus_filter_base_factor, timeframe_duration);
+                    night_bus_filter_max_factor, night_bus_filter_base_factor, timeframe_duration, journey_cache);
 
     // Create pb response
     make_pt_pathes(pb_creator, pathes, depth);
@@ -1378,7 +1452,8 @@ void make_response(navitia::PbCreator& pb_creator,
                    const double night_bus_filter_max_factor,
                    const int32_t night_bus_filter_base_factor,
                    const boost::optional<uint32_t>& timeframe_duration,
-                   const uint32_t depth) {
+                   const uint32_t depth,
+                   JourneyCache* journey_cache) {
     // Create datetime
     auto datetimes = parse_datetimes(raptor, timestamps, pb_creator, clockwise);
     if (pb_creator.has_error() || pb_creator.has_response_type(pbnavitia::DATE_OUT_OF_BOUNDS)) {
@@ -1439,7 +1514,8 @@ void make_response(navitia::PbCreator& pb_creator,
     const auto pathes = call_raptor(
         pb_creator, raptor, *departures, *destinations, datetimes, rt_level, transfer_penalty, accessibilite_params,
         forbidden, allowed, clockwise, direct_path_dur, min_nb_journeys, nb_direct_path, max_duration, max_transfers,
-        max_extra_second_pass, night_bus_filter_max_factor, night_bus_filter_base_factor, timeframe_duration);
+        max_extra_second_pass, night_bus_filter_max_factor, night_bus_filter_base_factor, timeframe_duration,
+        journey_cache);
 
     // Create pb response
     make_pathes(pb_creator, pathes, worker, direct_path, origin, destination, datetimes, clockwise, free_radius_from,
@@ -36,6 +36,7 @@ www.navitia.io
 #include "type/rt_level.h"
 #include "raptor.h"
 #include "routing/routing.h"
+#include "routing/journey_cache.h"
 
 #include <limits>
 
@@ -100,7 +101,8 @@ void make_response(navitia::PbCreator& pb_creator,
                    const double night_bus_filter_max_factor = NightBusFilter::default_max_factor,
                    const int32_t night_bus_filter_base_factor = NightBusFilter::default_base_factor,
                    const boost::optional<uint32_t>& timeframe_duration = boost::none,
-                   const uint32_t depth = 1);
+                   const uint32_t depth = 1,
+                   JourneyCache* journey_cache = nullptr);
 
 void make_isochrone(navitia::PbCreator& pb_creator,
                     RAPTOR& raptor,
@@ -138,7 +140,8 @@ void make_pt_response(navitia::PbCreator& pb_creator,
                       const double night_bus_filter_max_factor = NightBusFilter::default_max_factor,
                       const int32_t night_bus_filter_base_factor = NightBusFilter::default_base_factor,
                       const boost::optional<uint32_t>& timeframe_duration = boost::none,
-                      const uint32_t depth = 1);
+                      const uint32_t depth = 1,
+                      JourneyCache* journey_cache = nullptr);
 
 boost::optional<routing::map_stop_point_duration> get_stop_points(const type::EntryPoint& ep,
                                                                   const type::Data& data,
@@ -66,39 +66,74 @@ inline bool is_dt_initialized(const DateTime dt) {
     return dt != DateTimeUtils::inf && dt != DateTimeUtils::min;
 }
 
+// The labels of a raptor round.
+//
+// Clearing the labels must not cost the size of the network, as most
+// queries only touch a small part of it.  Thus, each stop point is
+// stamped with the epoch of its last modification: the labels of a
+// stop point not stamped with the current epoch are the clean ones,
+// and clear() only increments the epoch.
 struct Labels {
     inline friend void swap(Labels& lhs, Labels& rhs) {
+        using std::swap;
         swap(lhs.dt_pts, rhs.dt_pts);
         swap(lhs.dt_transfers, rhs.dt_transfers);
+        swap(lhs.walking_duration_pts, rhs.walking_duration_pts);
+        swap(lhs.walking_duration_transfers, rhs.walking_duration_transfers);
+        swap(lhs.stamps, rhs.stamps);
+        swap(lhs.epoch, rhs.epoch);
+        swap(lhs.clean_dt, rhs.clean_dt);
     }
     // initialize the structure according to the number of jpp
     inline void init_inf(const std::vector<type::StopPoint*>& stops) { init(stops, DateTimeUtils::inf); }
     // initialize the structure according to the number of jpp
     inline void init_min(const std::vector<type::StopPoint*>& stops) { init(stops, DateTimeUtils::min); }
     // clear the structure according to a given structure. Same as a
-    // copy without touching the boarding_jpp fields
+    // copy of clean, but only costs a few operations
     inline void clear(const Labels& clean) {
-        dt_pts = clean.dt_pts;
-        dt_transfers = clean.dt_transfers;
-
-        walking_duration_pts = clean.walking_duration_pts;
-        walking_duration_transfers = clean.walking_duration_transfers;
+        if (stamps.size() != clean.stamps.size()) {
+            *this = clean;
+            return;
+        }
+        clean_dt = clean.clean_dt;
+        ++epoch;
+        if (epoch == 0) {
+            // overflow: the old stamps may be taken for the new epoch
+            for (auto& stamp : stamps.values()) {
+                stamp = 0;
+            }
+            epoch = 1;
+        }
+    }
+    inline DateTime dt_transfer(SpIdx sp_idx) const { return is_touched(sp_idx) ? dt_transfers[sp_idx] : clean_dt; }
+    inline DateTime dt_pt(SpIdx sp_idx) const { return is_touched(sp_idx) ? dt_pts[sp_idx] : clean_dt; }
+    inline DateTime& mut_dt_transfer(SpIdx sp_idx) {
+        touch(sp_idx);
+        return dt_transfers[sp_idx];
+    }
+    inline DateTime& mut_dt_pt(SpIdx sp_idx) {
+        touch(sp_idx);
+        return dt_pts[sp_idx];
     }
-    inline const DateTime& dt_transfer(SpIdx sp_idx) const { return dt_transfers[sp_idx]; }
-    inline const DateTime& dt_pt(SpIdx sp_idx) const { return dt_pts[sp_idx]; }
-    inline DateTime& mut_dt_transfer(SpIdx sp_idx) { return dt_transfers[sp_idx]; }
-    inline DateTime& mut_dt_pt(SpIdx sp_idx) { return dt_pts[sp_idx]; }
 
     inline bool pt_is_initialized(SpIdx sp_idx) const { return is_dt_initialized(dt_pt(sp_idx)); }
     inline bool transfer_is_initialized(SpIdx sp_idx) const { return is_dt_initialized(dt_transfer(sp_idx)); }
 
-    inline const DateTime& walking_duration_pt(SpIdx sp_idx) const { return walking_duration_pts[sp_idx]; }
-    inline const DateTime& walking_duration_transfer(SpIdx sp_idx) const { return walking_duration_transfers[sp_idx]; }
-
-    inline DateTime& mut_walking_duration_pt(SpIdx sp_idx) { return walking_duration_pts[sp_idx]; }
-    inline DateTime& mut_walking_duration_transfer(SpIdx sp_idx) { return walking_duration_transfers[sp_idx]; }
+    inline DateTime walking_duration_pt(SpIdx sp_idx) const {
+        return is_touched(sp_idx) ? walking_duration_pts[sp_idx] : DateTimeUtils::not_valid;
+    }
+    inline DateTime walking_duration_transfer(SpIdx sp_idx) const {
+        return is_touched(sp_idx) ? walking_duration_transfers[sp_idx] : DateTimeUtils::not_valid;
+    }
 
-    const IdxMap<type::StopPoint, DateTime>& get_dt_pts() { return dt_pts; }
+    inline DateTime& mut_walking_duration_pt(SpIdx sp_idx) {
+        touch(sp_idx);
+        return walking_duration_pts[sp_idx];
+    }
+    inline DateTime& mut_walking_duration_transfer(SpIdx sp_idx) {
+        touch(sp_idx);
+        return walking_duration_transfers[sp_idx];
+    }
 
 private:
     inline void init(const std::vector<type::StopPoint*>& stops, DateTime val) {
@@ -107,9 +142,28 @@ private:
 
         walking_duration_pts.assign(stops, DateTimeUtils::not_valid);
         walking_duration_transfers.assign(stops, DateTimeUtils::not_valid);
+
+        stamps.assign(stops, 0);
+        epoch = 1;
+        clean_dt = val;
     }
 
-    // All these vectors are indexed by sp_idx
+    inline bool is_touched(SpIdx sp_idx) const { return stamps[sp_idx] == epoch; }
+    // reset the labels of sp_idx if they are not of the current epoch
+    inline void touch(SpIdx sp_idx) {
+        auto& stamp = stamps[sp_idx];
+        if (stamp == epoch) {
+            return;
+        }
+        stamp = epoch;
+        dt_pts[sp_idx] = clean_dt;
+        dt_transfers[sp_idx] = clean_dt;
+        walking_duration_pts[sp_idx] = DateTimeUtils::not_valid;
+        walking_duration_transfers[sp_idx] = DateTimeUtils::not_valid;
+    }
+
+    // All these vectors are indexed by sp_idx, and are only
+    // meaningful for the stop points stamped with the current epoch
     //
     // dt_pts[stop_point] stores the earliest arrival time to stop_point.
     // More precisely, at time dt_pts[stop_point], we just alighted from
@@ -126,6 +180,12 @@ private:
     // waling_duration_transfers[stop_point] stores the total walking duration (fallback + transfers) of a
     // journey that allows to board a vehicle at stop_point at DateTime transfers_pts[stop_point]
     IdxMap<type::StopPoint, DateTime> walking_duration_transfers;
+
+    // stamps[stop_point] is the epoch of the last modification of the labels of stop_point
+    IdxMap<type::StopPoint, uint32_t> stamps;
+    uint32_t epoch = 1;
+    // value of the untouched datetime labels (inf when clockwise, min otherwise)
+    DateTime clean_dt = DateTimeUtils::inf;
 };
 
 }  // namespace routing
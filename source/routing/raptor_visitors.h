@@ -2,6 +2,8 @@
 
 #include <boost/range/iterator_range_core.hpp>
 
+#include <iterator>
+
 namespace navitia {
 namespace routing {
 struct raptor_visitor {
@@ -9,6 +11,7 @@ struct raptor_visitor {
 
     typedef std::vector<type::StopTime>::const_iterator stop_time_iterator;
     typedef boost::iterator_range<stop_time_iterator> stop_time_range;
+    typedef dataRAPTOR::JpStopTimes::const_iterator jp_stop_time_iterator;
 
     inline bool better_or_equal(const DateTime& a, const DateTime& current_dt, const type::StopTime& st) const {
         return a <= st.section_end(current_dt, !clockwise());
@@ -25,6 +28,11 @@ struct raptor_visitor {
         return boost::make_iterator_range(vj->stop_time_list.begin() + st.order().val, vj->stop_time_list.end());
     }
 
+    // Returns an iterator on the compressed stop time it, going toward the end of its vehicle journey
+    inline jp_stop_time_iterator jp_st_iterator(const dataRAPTOR::JpStopTimes::const_iterator it) const {
+        return it;
+    }
+
     template <typename T1, typename T2>
     inline bool comp(const T1& a, const T2& b) const {
         return a < b;
@@ -64,6 +72,7 @@ struct raptor_reverse_visitor {
 
     typedef std::vector<type::StopTime>::const_reverse_iterator stop_time_iterator;
     typedef boost::iterator_range<stop_time_iterator> stop_time_range;
+    typedef std::reverse_iterator<dataRAPTOR::JpStopTimes::const_iterator> jp_stop_time_iterator;
 
     inline bool better_or_equal(const DateTime& a, const DateTime& current_dt, const type::StopTime& st) const {
         return a >= st.section_end(current_dt, !clockwise());
@@ -81,6 +90,11 @@ struct raptor_reverse_visitor {
                                           vj->stop_time_list.rend());
     }
 
+    // Returns an iterator on the compressed stop time it, going toward the beginning of its vehicle journey
+    inline jp_stop_time_iterator jp_st_iterator(const dataRAPTOR::JpStopTimes::const_iterator it) const {
+        return jp_stop_time_iterator(it + 1);
+    }
+
     template <typename T1, typename T2>
     inline bool comp(const T1& a, const T2& b) const {
         return a > b;
@@ -77,9 +77,11 @@ bool use_crow_fly(const type::EntryPoint& point,
         // we want a crowfly for all main_stop_areas of an admin,
         // even if the stop_area is not in the admin
         auto admin = data.geo_ref->admins[data.geo_ref->admin_map[point.uri]];
-        auto it = find_if(begin(admin->main_stop_areas), end(admin->main_stop_areas),
-                          [stop_point](const type::StopArea* stop_area) { return stop_area == stop_point.stop_area; });
-        return it != end(admin->main_stop_areas);
+        auto it = find_if(begin(admin->main_stop_area_uris), end(admin->main_stop_area_uris),
+                          [stop_point](const std::string& sa_uri) {
+                              return stop_point.stop_area && sa_uri == stop_point.stop_area->uri;
+                          });
+        return it != end(admin->main_stop_area_uris);
     }
     // if the request is on any other type we don't want a crowfly section
     return false;
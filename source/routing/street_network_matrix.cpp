@@ -0,0 +1,230 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "street_network_matrix.h"
+
+#include "georef/contraction_hierarchy.h"
+#include "georef/dijkstra_path_finder.h"
+#include "georef/georef.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace navitia {
+namespace routing {
+
+using georef::ContractionHierarchy;
+using georef::ContractionHierarchyUpwardSearch;
+
+struct StreetNetworkMatrix::Searcher {
+    georef::DijkstraPathFinder path_finder;
+    ContractionHierarchyUpwardSearch hierarchy_search;
+    // in ticks of the hierarchy, by index of destination
+    std::vector<uint64_t> durations;
+
+    explicit Searcher(const georef::GeoRef& geo_ref) : path_finder(geo_ref) {}
+};
+
+struct StreetNetworkMatrix::Destinations {
+    // in the layer the mode arrives on
+    std::vector<georef::ProjectionData> projections;
+    // null when the mode has no contraction hierarchy
+    std::unique_ptr<georef::ContractionHierarchyBuckets> buckets;
+    const ContractionHierarchy* hierarchy = nullptr;
+};
+
+StreetNetworkMatrix::StreetNetworkMatrix(const georef::GeoRef& geo_ref,
+                                         ThreadPool* thread_pool,
+                                         georef::PriorityQueue_e priority_queue)
+    : geo_ref(geo_ref) {
+    if (thread_pool && thread_pool->size() > 1) {
+        this->thread_pool = thread_pool;
+    }
+    const size_t nb_searchers = thread_pool ? thread_pool->size() : 1;
+    for (size_t i = 0; i < nb_searchers; ++i) {
+        searchers.push_back(std::make_unique<Searcher>(geo_ref));
+        searchers.back()->path_finder.priority_queue = priority_queue;
+    }
+}
+
+StreetNetworkMatrix::~StreetNetworkMatrix() = default;
+
+void StreetNetworkMatrix::for_each_task(const size_t nb_tasks, const std::function<void(Searcher&, size_t)>& task) {
+    if (!thread_pool) {
+        for (size_t i = 0; i < nb_tasks; ++i) {
+            task(*searchers.front(), i);
+        }
+        return;
+    }
+    // at most thread_pool->size() tasks run at the same time: there is always a free searcher
+    std::mutex mutex;
+    std::vector<Searcher*> free_searchers;
+    for (auto& searcher : searchers) {
+        free_searchers.push_back(searcher.get());
+    }
+    thread_pool->parallel_for(nb_tasks, [&](const size_t i) {
+        Searcher* searcher = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            searcher = free_searchers.back();
+            free_searchers.pop_back();
+        }
+        try {
+            task(*searcher, i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_searchers.push_back(searcher);
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        free_searchers.push_back(searcher);
+    });
+}
+
+StreetNetworkMatrix::Destinations StreetNetworkMatrix::project(const std::vector<type::GeographicalCoord>& destinations,
+                                                               const type::Mode_e mode,
+                                                               const float speed_factor,
+                                                               const navitia::time_duration& max_duration) {
+    Destinations result;
+    // as in a direct path, the car arrives on foot
+    const auto layer_mode = mode == type::Mode_e::Car ? type::Mode_e::Walking : mode;
+    result.projections.resize(destinations.size());
+    for_each_task(destinations.size(), [&](Searcher&, const size_t i) {
+        result.projections[i] = geo_ref.project(destinations[i], layer_mode);
+    });
+
+    result.hierarchy = geo_ref.get_contraction_hierarchy(mode);
+    if (!result.hierarchy || destinations.empty()) {
+        return result;
+    }
+    // the hierarchy holds the durations at the speed factor 1, so do the ends of the destinations
+    auto& path_finder = searchers.front()->path_finder;
+    path_finder.init_mode(mode, 1.f);
+    std::vector<std::vector<ContractionHierarchyUpwardSearch::Endpoint>> ends(destinations.size());
+    for (size_t i = 0; i < destinations.size(); ++i) {
+        const auto& projection = result.projections[i];
+        for (const auto& end : path_finder.get_target_ends(projection)) {
+            ends[i].push_back({projection[end.first], ContractionHierarchy::edge_ticks(end.second, 1.f)});
+        }
+    }
+
+    const auto max_ticks = ContractionHierarchy::edge_ticks(max_duration, speed_factor);
+    std::vector<std::vector<ContractionHierarchyUpwardSearch::Endpoint>> settled_by_destination(destinations.size());
+    for_each_task(destinations.size(), [&](Searcher& searcher, const size_t i) {
+        settled_by_destination[i] = searcher.hierarchy_search.search(
+            *result.hierarchy, ContractionHierarchyUpwardSearch::Direction::Backward, ends[i], max_ticks);
+    });
+    result.buckets = std::make_unique<georef::ContractionHierarchyBuckets>(settled_by_destination);
+    return result;
+}
+
+std::vector<georef::RoutingElement> StreetNetworkMatrix::search_in_hierarchy(
+    Searcher& searcher,
+    const type::EntryPoint& origin,
+    const Destinations& destinations,
+    const navitia::time_duration& max_duration) const {
+    const auto& params = origin.streetnetwork_params;
+    auto& path_finder = searcher.path_finder;
+    path_finder.init_starting_edge(origin.coordinates, params.mode, params.speed_factor);
+
+    std::vector<ContractionHierarchyUpwardSearch::Endpoint> sources;
+    for (const auto& end : path_finder.get_starting_ends()) {
+        sources.push_back({path_finder.starting_edge[end.first],
+                           ContractionHierarchy::edge_ticks(end.second, params.speed_factor)});
+    }
+    const auto max_ticks = ContractionHierarchy::edge_ticks(max_duration, params.speed_factor);
+    const auto& settled = searcher.hierarchy_search.search(
+        *destinations.hierarchy, ContractionHierarchyUpwardSearch::Direction::Forward, sources, max_ticks);
+    searcher.durations.assign(destinations.projections.size(), std::numeric_limits<uint64_t>::max());
+    destinations.buckets->scan(settled, searcher.durations);
+
+    std::vector<georef::RoutingElement> result;
+    result.reserve(destinations.projections.size());
+    for (size_t i = 0; i < destinations.projections.size(); ++i) {
+        const auto& projection = destinations.projections[i];
+        if (!projection.found) {
+            result.emplace_back(navitia::time_duration(), georef::RoutingStatus_e::unknown);
+            continue;
+        }
+        // as the dijkstra, the destinations on the starting edge are reached along it
+        navitia::time_duration duration = bt::pos_infin;
+        if (georef::is_projected_on_same_edge(path_finder.starting_edge, projection)) {
+            duration = path_finder.path_duration_on_same_edge(path_finder.starting_edge, projection);
+        } else if (searcher.durations[i] != std::numeric_limits<uint64_t>::max()) {
+            const double ticks = searcher.durations[i] / double(params.speed_factor);
+            if (ticks <= max_duration.ticks()) {
+                duration = navitia::time_duration(0, 0, 0, int32_t(ticks));
+            }
+        }
+        if (duration <= max_duration) {
+            result.emplace_back(duration, georef::RoutingStatus_e::reached);
+        } else {
+            result.emplace_back(navitia::time_duration(), georef::RoutingStatus_e::unreached);
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<georef::RoutingElement>> StreetNetworkMatrix::compute(
+    const std::vector<type::EntryPoint>& origins,
+    const std::vector<type::GeographicalCoord>& destinations,
+    const navitia::time_duration& max_duration) {
+    // the destinations are projected once by mode of the origins, their searches bounded at the fastest origin
+    std::map<type::Mode_e, float> max_speed_factors;
+    for (const auto& origin : origins) {
+        auto& speed_factor = max_speed_factors[origin.streetnetwork_params.mode];
+        speed_factor = std::max(speed_factor, origin.streetnetwork_params.speed_factor);
+    }
+    std::map<type::Mode_e, Destinations> destinations_by_mode;
+    for (const auto& mode_speed_factor : max_speed_factors) {
+        destinations_by_mode.emplace(
+            mode_speed_factor.first,
+            project(destinations, mode_speed_factor.first, mode_speed_factor.second, max_duration));
+    }
+
+    std::vector<std::vector<georef::RoutingElement>> result(origins.size());
+    for_each_task(origins.size(), [&](Searcher& searcher, const size_t i) {
+        const auto& origin = origins[i];
+        const auto& params = origin.streetnetwork_params;
+        const auto& mode_destinations = destinations_by_mode.at(params.mode);
+        if (mode_destinations.buckets) {
+            result[i] = search_in_hierarchy(searcher, origin, mode_destinations, max_duration);
+            return;
+        }
+        searcher.path_finder.init(origin.coordinates, params.mode, params.speed_factor);
+        result[i] = searcher.path_finder.get_duration_with_dijkstra(max_duration, mode_destinations.projections);
+    });
+    return result;
+}
+
+}  // namespace routing
+}  // namespace navitia
@@ -0,0 +1,105 @@
+/* Copyright © 2001-2020, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "georef/path_finder.h"
+#include "thread_pool.h"
+#include "type/entry_point.h"
+#include "type/geographical_coord.h"
+#include "type/time_duration.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace navitia {
+namespace routing {
+
+/*
+ * Street network durations from many origins to many destinations, as
+ * asked by a street network routing matrix request.
+ *
+ * The destinations are projected once for all the origins.  When the data
+ * holds the contraction hierarchy of the mode of the origins, the durations
+ * are found by buckets (see georef::ContractionHierarchyBuckets): a search
+ * up the hierarchy from each destination, then one from each origin.
+ * Otherwise a dijkstra is launched from each origin.
+ *
+ * The searches are spread over the threads of a pool when there are more
+ * than one, each thread using its own path finder.  A matrix is used by one
+ * thread at a time (in practice the worker owning it).
+ */
+class StreetNetworkMatrix {
+public:
+    explicit StreetNetworkMatrix(const georef::GeoRef& geo_ref,
+                                 ThreadPool* thread_pool = nullptr,
+                                 georef::PriorityQueue_e priority_queue = georef::PriorityQueue_e::d_ary_heap);
+    ~StreetNetworkMatrix();
+
+    StreetNetworkMatrix(const StreetNetworkMatrix&) = delete;
+    StreetNetworkMatrix& operator=(const StreetNetworkMatrix&) = delete;
+
+    /*
+     * The durations from each origin to each destination, reached when not
+     * longer than max_duration.  Each origin is searched with the mode and
+     * the speed factor of its street network parameters.
+     */
+    std::vector<std::vector<georef::RoutingElement>> compute(const std::vector<type::EntryPoint>& origins,
+                                                             const std::vector<type::GeographicalCoord>& destinations,
+                                                             const navitia::time_duration& max_duration);
+
+private:
+    struct Searcher;
+    struct Destinations;
+
+    const georef::GeoRef& geo_ref;
+    /// Threads running the searches, null if they are sequential. Not owned: the pool
+    /// outlives the matrices built on the successive data
+    ThreadPool* thread_pool = nullptr;
+    /// One searcher per thread of thread_pool, only one without pool
+    std::vector<std::unique_ptr<Searcher>> searchers;
+
+    // run the tasks [0, nb_tasks) on the threads, each task with a free searcher
+    void for_each_task(size_t nb_tasks, const std::function<void(Searcher&, size_t)>& task);
+
+    Destinations project(const std::vector<type::GeographicalCoord>& destinations,
+                         type::Mode_e mode,
+                         float speed_factor,
+                         const navitia::time_duration& max_duration);
+
+    std::vector<georef::RoutingElement> search_in_hierarchy(Searcher& searcher,
+                                                            const type::EntryPoint& origin,
+                                                            const Destinations& destinations,
+                                                            const navitia::time_duration& max_duration) const;
+};
+
+}  // namespace routing
+}  // namespace navitia
@@ -83,7 +83,7 @@ BOOST_AUTO_TEST_CASE(ok_before_and_after_disruption) {
     auto data_cloned = data_manager.get_data_clone();
     data_cloned->build_raptor();
     data_cloned->build_proximity_list();
-    data_manager.set_data(data_cloned);
+    data_manager.set_data(std::move(data_cloned));
 
     // we ask for a journey, we should have the same thing
     {
@@ -2592,3 +2592,103 @@ BOOST_AUTO_TEST_CASE(freq_next_stop_time_with_distant_bounds) {
         BOOST_CHECK_EQUAL(st->stop_point->stop_area->name, spa2);
     }
 }
+
+/*
+ * The cached next stop times must give the same stop times and
+ * datetimes as the non cached ones, and report their memory
+ */
+BOOST_AUTO_TEST_CASE(cached_next_stop_time_same_as_next_stop_time) {
+    ed::builder b("20120614");
+    b.vj("A", "1111111", "", true)("stop1", "08:00:00"_t)("stop2", "08:10:00"_t)("stop3", "08:20:00"_t);
+    b.vj("A", "1111111", "", true)("stop1", "09:00:00"_t)("stop2", "09:10:00"_t)("stop3", "09:20:00"_t);
+    b.vj("A", "0101010", "", true)("stop1", "08:30:00"_t)("stop2", "08:40:00"_t)("stop3", "08:50:00"_t);
+    b.vj("A", "1111111", "", true)("stop1", "23:50:00"_t)("stop2", "24:10:00"_t)("stop3", "24:20:00"_t);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+    b.data->build_uri();
+    b.data->build_raptor();
+    NextStopTime next_st(*b.data);
+    auto& manager = *b.data->dataRaptor->cached_next_st_manager;
+
+    BOOST_CHECK_EQUAL(manager.nb_cache_builds(), 0);
+    const auto cached_next_st = manager.load(DateTimeUtils::set(1, 0), nt::RTLevel::Base, {});
+    BOOST_CHECK_EQUAL(manager.nb_cache_builds(), 1);
+    BOOST_CHECK_EQUAL(manager.cache_memory_size(), cached_next_st->memory_size());
+    BOOST_CHECK_GT(manager.cache_memory_size(), 0);
+
+    for (const std::string stop : {"stop1", "stop2", "stop3"}) {
+        const auto jpp = get_first_jpp_idx(b, stop);
+        for (DateTime hour = "07:00:00"_t; hour <= "24:00:00"_t; hour += 5 * 60) {
+            const DateTime dt = DateTimeUtils::set(1, hour);
+            for (const auto stop_event : {StopEvent::pick_up, StopEvent::drop_off}) {
+                const auto expected = next_st.earliest_stop_time(stop_event, jpp, dt, nt::RTLevel::Base, {}, false,
+                                                                 DateTimeUtils::set(3, 0));
+                const auto cached = cached_next_st->next_stop_time(stop_event, jpp, dt, true);
+                if (expected.first == nullptr) {
+                    BOOST_CHECK(cached.first == nullptr);
+                    continue;
+                }
+                BOOST_CHECK(cached.first == expected.first);
+                BOOST_CHECK_EQUAL(cached.second, expected.second);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(prefetched_next_stop_time_cache) {
+    ed::builder b("20120614");
+    b.vj("A", "1111111", "", true)("stop1", "08:00:00"_t)("stop2", "08:10:00"_t);
+    b.vj("A", "1111111", "", true)("stop1", "09:00:00"_t)("stop2", "09:10:00"_t);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+    b.data->build_uri();
+    b.data->build_raptor();
+    auto& manager = *b.data->dataRaptor->cached_next_st_manager;
+
+    const auto keys = CachedNextStopTimeManager::prefetch_keys(1);
+    BOOST_REQUIRE_EQUAL(keys.size(), 8);
+    BOOST_CHECK_EQUAL(keys.front().from, 1);
+    BOOST_CHECK(keys.front().rt_level == nt::RTLevel::Base);
+    BOOST_CHECK_EQUAL(keys.back().from, 2);
+
+    // the lru keeps 10 caches: all the keys are built, in parallel
+    BOOST_CHECK_EQUAL(manager.prefetch(keys, 3), 8);
+    BOOST_CHECK_EQUAL(manager.nb_cache_builds(), 8);
+    // already built, nothing to do
+    BOOST_CHECK_EQUAL(manager.prefetch(keys, 3), 0);
+
+    auto report = manager.take_report();
+    BOOST_CHECK_EQUAL(report.nb_hits, 0);
+    BOOST_CHECK_EQUAL(report.nb_misses, 0);
+
+    // the prefetched day is a hit, the day after tomorrow is a miss
+    manager.load(DateTimeUtils::set(1, "08:00:00"_t), nt::RTLevel::Base, {});
+    manager.load(DateTimeUtils::set(2, "08:00:00"_t), nt::RTLevel::RealTime, {});
+    manager.load(DateTimeUtils::set(3, "08:00:00"_t), nt::RTLevel::Base, {});
+    BOOST_CHECK_EQUAL(manager.nb_cache_builds(), 9);
+
+    report = manager.take_report();
+    BOOST_CHECK_EQUAL(report.nb_hits, 2);
+    BOOST_CHECK_EQUAL(report.nb_misses, 1);
+    report = manager.take_report();
+    BOOST_CHECK_EQUAL(report.nb_hits, 0);
+    BOOST_CHECK_EQUAL(report.nb_misses, 0);
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_does_not_evict_its_first_keys) {
+    ed::builder b("20120614");
+    b.vj("A", "1111111", "", true)("stop1", "08:00:00"_t)("stop2", "08:10:00"_t);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+    b.data->build_uri();
+    b.data->build_raptor(2);
+    auto& manager = *b.data->dataRaptor->cached_next_st_manager;
+
+    // only the 2 first keys fit in the lru
+    BOOST_CHECK_EQUAL(manager.prefetch(CachedNextStopTimeManager::prefetch_keys(0), 1), 2);
+    manager.load(DateTimeUtils::set(0, "08:00:00"_t), nt::RTLevel::Base, {});
+    manager.load(DateTimeUtils::set(0, "08:00:00"_t), nt::RTLevel::RealTime, {});
+    const auto report = manager.take_report();
+    BOOST_CHECK_EQUAL(report.nb_hits, 2);
+    BOOST_CHECK_EQUAL(report.nb_misses, 0);
+}
@@ -3562,3 +3562,261 @@ BOOST_AUTO_TEST_CASE(forbidden_uri_in_stay_in) {
     BOOST_CHECK_EQUAL(j.items[1].stop_points.back()->uri, "Stalingrad_2");
     BOOST_CHECK_EQUAL(j.items[2].stop_points.front()->uri, "Stalingrad_2");
 }
+
+/*
+ * Scanning only the journey patterns marked at the previous round must give
+ * exactly the same results as sweeping all the journey patterns at each round
+ */
+BOOST_AUTO_TEST_CASE(marked_jps_scan_same_as_full_sweep) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8100, 8150)("stop3", 8200, 8250);
+    b.vj("B")("stop4", 8000, 8050)("stop2", 8300, 8350)("stop5", 8400, 8450);
+    b.vj("C")("stop3", 8500, 8550)("stop6", 8600, 8650)("stop5", 8700, 8750);
+    b.vj("D")("stop1", 9000, 9050)("stop6", 9100, 9150);
+    b.vj("E")("stop7", 8000, 8050)("stop8", 8100, 8150);
+    b.connection("stop2", "stop2", 120);
+    b.connection("stop3", "stop3", 120);
+    b.connection("stop5", "stop5", 120);
+    b.connection("stop6", "stop6", 120);
+    b.data->pt_data->sort_and_index();
+    b.finish();
+    b.data->build_raptor();
+    b.data->build_uri();
+    RAPTOR marked_raptor(*b.data, true);
+    RAPTOR full_raptor(*b.data, false);
+    const type::PT_Data& d = *b.data->pt_data;
+
+    for (const bool clockwise : {true, false}) {
+        const int hour = clockwise ? 7900 : 9000;
+        const DateTime bound = clockwise ? DateTimeUtils::inf : DateTimeUtils::min;
+        auto marked_res = marked_raptor.compute(d.stop_areas_map.at("stop1"), d.stop_areas_map.at("stop5"), hour, 0,
+                                                bound, type::RTLevel::Base, 2_min, clockwise);
+        auto full_res = full_raptor.compute(d.stop_areas_map.at("stop1"), d.stop_areas_map.at("stop5"), hour, 0,
+                                            bound, type::RTLevel::Base, 2_min, clockwise);
+
+        BOOST_REQUIRE(!marked_res.empty());
+        BOOST_REQUIRE_EQUAL(marked_res.size(), full_res.size());
+        for (size_t i = 0; i < marked_res.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(marked_res[i].items.size(), full_res[i].items.size());
+            BOOST_CHECK_EQUAL(marked_res[i].items.front().departure, full_res[i].items.front().departure);
+            BOOST_CHECK_EQUAL(marked_res[i].items.back().arrival, full_res[i].items.back().arrival);
+            BOOST_CHECK_EQUAL(marked_res[i].nb_changes, full_res[i].nb_changes);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(jp_stop_times_match_stop_times) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8100, 8150)("stop3", 8200, 8250);
+    b.vj("A")("stop1", 9000, 9050)("stop2", 9100, 9150)("stop3", 9200, 9250);
+    b.vj("B")("stop3", 8000, 8050)("stop2", 8300, 8350);
+    b.frequency_vj("C", "08:00:00"_t, "18:00:00"_t, "00:10:00"_t)("stop4", "08:00:00"_t)("stop5", "08:20:00"_t);
+    b.data->pt_data->sort_and_index();
+    b.finish();
+    b.data->build_raptor();
+
+    const auto& jp_stop_times = b.data->dataRaptor->jp_stop_times;
+    for (const auto* vj : b.data->pt_data->vehicle_journeys) {
+        for (const auto& st : vj->stop_time_list) {
+            const auto& compressed_st = *jp_stop_times.get(st);
+            BOOST_CHECK_EQUAL(compressed_st.boarding_time, st.boarding_time);
+            BOOST_CHECK_EQUAL(compressed_st.alighting_time, st.alighting_time);
+            BOOST_CHECK_EQUAL(compressed_st.local_traffic_zone, st.local_traffic_zone);
+            BOOST_CHECK_EQUAL(compressed_st.pick_up_allowed, st.pick_up_allowed());
+            BOOST_CHECK_EQUAL(compressed_st.drop_off_allowed, st.drop_off_allowed());
+            for (const bool clockwise : {true, false}) {
+                BOOST_CHECK_EQUAL(compressed_st.section_end(42, clockwise), st.section_end(42, clockwise));
+                BOOST_CHECK_EQUAL(compressed_st.valid_end(clockwise), st.valid_end(clockwise));
+            }
+        }
+        // the stop times of a vehicle journey are contiguous
+        if (vj->stop_time_list.size() > 1) {
+            BOOST_CHECK(jp_stop_times.get(vj->stop_time_list.front()) + 1 == jp_stop_times.get(vj->stop_time_list[1]));
+        }
+    }
+}
+
+/*
+ * The profile query must give, for each departure of the time frame,
+ * journeys also found by a classic query at this datetime.  The
+ * journeys already found for a later departure are not given again.
+ */
+BOOST_AUTO_TEST_CASE(profile_same_as_classic_queries) {
+    ed::builder b("20120614");
+    for (const int t : {8000, 9000, 10000}) {
+        b.vj("A")("stop1", t, t)("stop2", t + 100, t + 100);
+        b.vj("B")("stop2", t + 300, t + 300)("stop3", t + 400, t + 400);
+    }
+    b.vj("C")("stop1", 8500, 8500)("stop3", 9300, 9300);
+    b.connection("stop2", "stop2", 120);
+    b.data->pt_data->sort_and_index();
+    b.finish();
+    b.data->build_raptor();
+    b.data->build_uri();
+    RAPTOR profile_raptor(*b.data);
+    RAPTOR raptor(*b.data);
+
+    routing::map_stop_point_duration departures, arrivals;
+    departures[SpIdx(*b.sps["stop1"])] = 0_s;
+    arrivals[SpIdx(*b.sps["stop3"])] = 0_s;
+    const type::AccessibiliteParams accessibilite_params;
+    profile_raptor.set_valid_jp_and_jpp(0, accessibilite_params, {}, {}, type::RTLevel::Base);
+    raptor.set_valid_jp_and_jpp(0, accessibilite_params, {}, {}, type::RTLevel::Base);
+
+    const auto profile = profile_raptor.compute_all_journeys_profile(departures, arrivals, DateTimeUtils::set(0, 7900),
+                                                                     DateTimeUtils::set(0, 9500), type::RTLevel::Base,
+                                                                     2_min);
+
+    // from the latest departure to the earliest one
+    BOOST_REQUIRE_EQUAL(profile.size(), 3);
+    BOOST_CHECK_EQUAL(profile[0].datetime, DateTimeUtils::set(0, 9000));
+    BOOST_CHECK_EQUAL(profile[1].datetime, DateTimeUtils::set(0, 8500));
+    BOOST_CHECK_EQUAL(profile[2].datetime, DateTimeUtils::set(0, 8000));
+
+    for (const auto& profile_journeys : profile) {
+        BOOST_REQUIRE_EQUAL(profile_journeys.journeys.size(), 1);
+        const auto& journey = profile_journeys.journeys.front();
+        BOOST_CHECK_EQUAL(journey.departure_dt, profile_journeys.datetime);
+
+        const auto journeys = raptor.compute_all_journeys(departures, arrivals, profile_journeys.datetime,
+                                                          type::RTLevel::Base, 2_min);
+        const auto it = boost::find_if(journeys, [&](const routing::Journey& j) {
+            return j.departure_dt == journey.departure_dt && j.arrival_dt == journey.arrival_dt
+                   && j.sections.size() == journey.sections.size();
+        });
+        BOOST_CHECK(it != journeys.end());
+    }
+    BOOST_CHECK_EQUAL(profile[0].journeys.front().arrival_dt, DateTimeUtils::set(0, 9400));
+    BOOST_CHECK_EQUAL(profile[1].journeys.front().arrival_dt, DateTimeUtils::set(0, 9300));
+    BOOST_CHECK_EQUAL(profile[2].journeys.front().arrival_dt, DateTimeUtils::set(0, 8400));
+}
+
+/*
+ * The parallel scan of the marked journey patterns must give exactly
+ * the same results as the sequential one
+ */
+BOOST_AUTO_TEST_CASE(parallel_scan_same_as_sequential_scan) {
+    ed::builder b("20120614");
+    // enough lines leaving the hub for the rounds to be scanned in parallel
+    for (int i = 0; i < 100; ++i) {
+        const auto stop = "stop" + std::to_string(i);
+        b.vj("A" + std::to_string(i))("hub", 8000 + i, 8000 + i)(stop, 8500 + 7 * i, 8500 + 7 * i);
+        b.vj("B" + std::to_string(i))(stop, 9000 + 3 * i, 9000 + 3 * i)("dest", 10000 - 5 * i, 10000 - 5 * i);
+        b.vj("C" + std::to_string(i))(stop, 9100, 9100)("stop" + std::to_string((i + 1) % 100), 9200 + i, 9200 + i);
+        b.connection(stop, stop, 120);
+    }
+    b.data->pt_data->sort_and_index();
+    b.finish();
+    b.data->build_raptor();
+    b.data->build_uri();
+    RAPTOR sequential_raptor(*b.data);
+    RAPTOR parallel_raptor(*b.data, true, 4);
+    const type::PT_Data& d = *b.data->pt_data;
+
+    for (const bool clockwise : {true, false}) {
+        const int hour = clockwise ? 7900 : 11000;
+        const DateTime bound = clockwise ? DateTimeUtils::inf : DateTimeUtils::min;
+        auto sequential_res = sequential_raptor.compute(d.stop_areas_map.at("hub"), d.stop_areas_map.at("dest"), hour,
+                                                        0, bound, type::RTLevel::Base, 2_min, clockwise);
+        auto parallel_res = parallel_raptor.compute(d.stop_areas_map.at("hub"), d.stop_areas_map.at("dest"), hour, 0,
+                                                    bound, type::RTLevel::Base, 2_min, clockwise);
+
+        BOOST_REQUIRE(!sequential_res.empty());
+        BOOST_REQUIRE_EQUAL(sequential_res.size(), parallel_res.size());
+        for (size_t i = 0; i < sequential_res.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(sequential_res[i].items.size(), parallel_res[i].items.size());
+            for (size_t j = 0; j < sequential_res[i].items.size(); ++j) {
+                BOOST_CHECK_EQUAL(sequential_res[i].items[j].departure, parallel_res[i].items[j].departure);
+                BOOST_CHECK_EQUAL(sequential_res[i].items[j].arrival, parallel_res[i].items[j].arrival);
+                BOOST_CHECK(sequential_res[i].items[j].stop_points == parallel_res[i].items[j].stop_points);
+            }
+        }
+        // the labels of the first pass, as the second passes may have been run on other label sets
+        const auto& sequential_labels = sequential_raptor.first_pass_labels;
+        const auto& parallel_labels = parallel_raptor.first_pass_labels;
+        BOOST_REQUIRE_EQUAL(sequential_labels.size(), parallel_labels.size());
+        for (size_t count = 0; count < sequential_labels.size(); ++count) {
+            for (const auto* sp : d.stop_points) {
+                BOOST_CHECK_EQUAL(sequential_labels[count].dt_pt(SpIdx(*sp)), parallel_labels[count].dt_pt(SpIdx(*sp)));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cleared_labels_are_clean) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000)("stop2", 8100);
+    b.data->pt_data->sort_and_index();
+    b.finish();
+    b.data->build_raptor();
+    b.data->build_uri();
+    const auto& data_raptor = *b.data->dataRaptor;
+    const SpIdx stop1 = SpIdx(*b.data->pt_data->stop_points_map["stop1"]);
+    const SpIdx stop2 = SpIdx(*b.data->pt_data->stop_points_map["stop2"]);
+
+    Labels labels = data_raptor.labels_const;
+    labels.mut_dt_pt(stop1) = 8100;
+    labels.mut_walking_duration_transfer(stop2) = 60;
+    BOOST_CHECK_EQUAL(labels.dt_pt(stop1), 8100);
+    BOOST_CHECK_EQUAL(labels.dt_transfer(stop1), DateTimeUtils::inf);
+    BOOST_CHECK_EQUAL(labels.walking_duration_transfer(stop2), 60);
+    BOOST_CHECK(labels.pt_is_initialized(stop1));
+    BOOST_CHECK(!labels.pt_is_initialized(stop2));
+
+    labels.clear(data_raptor.labels_const);
+    BOOST_CHECK_EQUAL(labels.dt_pt(stop1), DateTimeUtils::inf);
+    BOOST_CHECK_EQUAL(labels.walking_duration_transfer(stop2), DateTimeUtils::not_valid);
+    BOOST_CHECK(!labels.pt_is_initialized(stop1));
+
+    // a stop touched again after a clear starts from the clean labels
+    labels.mut_dt_transfer(stop1) = 8200;
+    BOOST_CHECK_EQUAL(labels.dt_pt(stop1), DateTimeUtils::inf);
+    BOOST_CHECK_EQUAL(labels.dt_transfer(stop1), 8200);
+
+    labels.clear(data_raptor.labels_const_reverse);
+    BOOST_CHECK_EQUAL(labels.dt_transfer(stop1), DateTimeUtils::min);
+    BOOST_CHECK_EQUAL(labels.dt_pt(stop2), DateTimeUtils::min);
+}
+
+// the labels and the valid journey pattern points of a query must not leak in the next ones
+BOOST_AUTO_TEST_CASE(reused_raptor_same_as_new_raptor) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000)("stop2", 8100, 8150);
+    b.vj("B")("stop2", 8200)("stop4", 9000);
+    b.vj("C")("stop1", 8000, 8050)("stop4", 18000);
+    b.vj("D")("stop3", 8000)("stop4", 8500);
+    b.data->pt_data->sort_and_index();
+    b.finish();
+    b.data->build_raptor();
+    b.data->build_uri();
+    const type::PT_Data& d = *b.data->pt_data;
+    RAPTOR reused_raptor(*b.data);
+
+    struct Query {
+        std::string from;
+        bool clockwise;
+        std::vector<std::string> forbidden;
+    };
+    const std::vector<Query> queries = {
+        {"stop1", true, {"stop2"}}, {"stop1", true, {}},  {"stop3", true, {}},
+        {"stop1", false, {"stop2"}}, {"stop1", false, {}}, {"stop1", true, {"stop2"}},
+    };
+    for (const auto& query : queries) {
+        const int hour = query.clockwise ? 7900 : 20000;
+        const DateTime bound = query.clockwise ? DateTimeUtils::inf : DateTimeUtils::min;
+        RAPTOR new_raptor(*b.data);
+        const auto reused_res = reused_raptor.compute(d.stop_areas_map.at(query.from), d.stop_areas_map.at("stop4"),
+                                                      hour, 0, bound, type::RTLevel::Base, 2_min, query.clockwise, {},
+                                                      std::numeric_limits<uint32_t>::max(), query.forbidden);
+        const auto new_res = new_raptor.compute(d.stop_areas_map.at(query.from), d.stop_areas_map.at("stop4"), hour,
+                                                0, bound, type::RTLevel::Base, 2_min, query.clockwise, {},
+                                                std::numeric_limits<uint32_t>::max(), query.forbidden);
+        BOOST_REQUIRE(!new_res.empty());
+        BOOST_REQUIRE_EQUAL(reused_res.size(), new_res.size());
+        for (size_t i = 0; i < new_res.size(); ++i) {
+            BOOST_CHECK_EQUAL(reused_res[i].items.front().departure, new_res[i].items.front().departure);
+            BOOST_CHECK_EQUAL(reused_res[i].items.back().arrival, new_res[i].items.back().arrival);
+            BOOST_CHECK_EQUAL(reused_res[i].nb_changes, new_res[i].nb_changes);
+        }
+    }
+}
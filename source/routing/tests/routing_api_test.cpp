@@ -1848,11 +1848,12 @@ BOOST_AUTO_TEST_CASE(use_crow_fly) {
     ep.uri = "admin";
     navitia::type::StopPoint sp2;
     navitia::type::StopArea sa2;
+    sa2.uri = "sa2";
     sp2.stop_area = &sa2;
     BOOST_CHECK(nr::use_crow_fly(ep, sp2, empty_sn_path, data));
     BOOST_CHECK(!nr::use_crow_fly(ep, sp2, filled_sn_path, data));
 
-    admin->main_stop_areas.push_back(&sa2);
+    admin->main_stop_area_uris.push_back(sa2.uri);
     BOOST_CHECK(nr::use_crow_fly(ep, sp2, empty_sn_path, data));
     BOOST_CHECK(nr::use_crow_fly(ep, sp2, filled_sn_path, data));
 }
@@ -3477,6 +3478,60 @@ BOOST_AUTO_TEST_CASE(journeys_with_time_frame_duration) {
     BOOST_REQUIRE_EQUAL(resp.response_type(), pbnavitia::NO_SOLUTION);
 }
 
+BOOST_AUTO_TEST_CASE(journeys_with_journey_cache) {
+    ed::builder b("20180309");
+    b.sa("stop_area:sa1")("stop_point:sa1:s1", 2.39592, 48.84848, false);
+    b.sa("stop_area:sa3")("stop_point:sa3:s1", 2.36381, 48.86650, false);
+    b.vj("A", "1", "", false, "vj1")("stop_point:sa1:s1", "08:00"_t)("stop_point:sa3:s1", "08:05"_t);
+    b.vj("A", "1", "", false, "vj2")("stop_point:sa1:s1", "08:10"_t)("stop_point:sa3:s1", "08:15"_t);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+    b.data->build_raptor();
+    b.data->build_uri();
+    b.data->build_proximity_list();
+    b.data->meta->production_date = boost::gregorian::date_period("20180309"_d, boost::gregorian::days(1));
+
+    nr::RAPTOR raptor(*(b.data));
+    navitia::type::EntryPoint origin(navitia::type::Type_e::StopPoint, "stop_point:sa1:s1");
+    navitia::type::EntryPoint destination(navitia::type::Type_e::StopPoint, "stop_point:sa3:s1");
+    ng::StreetNetwork sn_worker(*b.data->geo_ref);
+    nr::JourneyCache journey_cache(10);
+
+    auto compute = [&](const std::string& datetime) {
+        navitia::PbCreator pb_creator(b.data.get(), "20180309T070000"_dt, null_time_period);
+        make_response(pb_creator, raptor, origin, destination, {ntest::to_posix_timestamp(datetime)}, true,
+                      navitia::type::AccessibiliteParams(), {}, {}, sn_worker, nt::RTLevel::Base, 2_min,
+                      std::numeric_limits<uint32_t>::max(), 10, 0, 0, 0, boost::make_optional<uint32_t>(2), 1.5, 900,
+                      boost::none, 1, &journey_cache);
+        return pb_creator.get_response();
+    };
+
+    const auto computed = compute("20180309T075900");
+    BOOST_REQUIRE_EQUAL(computed.response_type(), pbnavitia::ITINERARY_FOUND);
+    BOOST_REQUIRE_EQUAL(computed.journeys_size(), 2);
+    BOOST_CHECK_EQUAL(journey_cache.size(), 1);
+
+    // the same request is answered by the cache, with the same response
+    const auto cached = compute("20180309T075900");
+    BOOST_CHECK_EQUAL(cached.SerializeAsString(), computed.SerializeAsString());
+    auto report = journey_cache.take_report();
+    BOOST_CHECK_EQUAL(report.nb_hits, 1);
+    BOOST_CHECK_EQUAL(report.nb_misses, 1);
+
+    // another datetime is another entry
+    BOOST_CHECK_EQUAL(compute("20180309T080500").journeys_size(), 1);
+    BOOST_CHECK_EQUAL(journey_cache.size(), 2);
+
+    // new data invalidates the cache
+    b.data->data_identifier += 1;
+    const auto recomputed = compute("20180309T075900");
+    BOOST_CHECK_EQUAL(recomputed.SerializeAsString(), computed.SerializeAsString());
+    BOOST_CHECK_EQUAL(journey_cache.size(), 1);
+    report = journey_cache.take_report();
+    BOOST_CHECK_EQUAL(report.nb_hits, 0);
+    BOOST_CHECK_EQUAL(report.nb_misses, 2);
+}
+
 // basic journey without min_nb_journey nor timeframe_limit
 BOOST_AUTO_TEST_CASE(keep_going_tests_simple) {
     // no solution found: stop the search
@@ -529,7 +529,7 @@ struct routing_api_data {
         b.data->pt_data->codes.add(sa, "UIC8", "80142281");
 
         // Add a main stop area to our admin
-        admin->main_stop_areas.push_back(b.data->pt_data->stop_areas_map["stopC"]);
+        admin->main_stop_area_uris.push_back("stopC");
 
         // Add a fare_zone in stop point A
         b.sps.begin()->second->fare_zone = "2";
@@ -0,0 +1,233 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE street_network_matrix_test
+
+#include "routing/street_network_matrix.h"
+#include "georef/dijkstra_path_finder.h"
+#include "georef/georef.h"
+#include "type/entry_point.h"
+#include "utils/logger.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+struct logger_initialized {
+    logger_initialized() { navitia::init_logger(); }
+};
+BOOST_GLOBAL_FIXTURE(logger_initialized);
+
+using namespace navitia;
+using navitia::georef::RoutingElement;
+using navitia::georef::RoutingStatus_e;
+
+namespace {
+
+/*
+ * A square of side vertices 10 meters apart in each layer, the edges of
+ * the car layer missing on some ways, with a parking to leave the car
+ */
+void build_square(georef::GeoRef& geo_ref, size_t side) {
+    for (size_t i = 0; i < side; ++i) {
+        for (size_t j = 0; j < side; ++j) {
+            boost::add_vertex(georef::Vertex(i * 10., j * 10., true), geo_ref.graph);
+        }
+    }
+    geo_ref.init();
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < side; ++i) {
+        for (size_t j = 0; j < side; ++j) {
+            const georef::vertex_t v = i * side + j;
+            std::vector<georef::vertex_t> neighbours;
+            if (j + 1 < side) {
+                neighbours.push_back(v + 1);
+            }
+            if (i + 1 < side) {
+                neighbours.push_back(v + side);
+            }
+            for (const auto w : neighbours) {
+                for (const auto mode : {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car}) {
+                    const auto offset = geo_ref.offsets[mode];
+                    if (mode == type::Mode_e::Car && rng() % 4 == 0) {
+                        continue;
+                    }
+                    const int min_duration = std::ceil(10. / georef::default_speed[mode]);
+                    boost::add_edge(v + offset, w + offset,
+                                    georef::Edge(v, navitia::seconds(min_duration + rng() % 10)), geo_ref.graph);
+                    boost::add_edge(w + offset, v + offset,
+                                    georef::Edge(v, navitia::seconds(min_duration + rng() % 10)), geo_ref.graph);
+                }
+            }
+        }
+    }
+    geo_ref.build_proximity_list();
+    type::GeographicalCoord parking;
+    parking.set_xy(51., 72.);
+    BOOST_REQUIRE(geo_ref.add_parking_edges(parking));
+}
+
+type::GeographicalCoord random_coord(std::mt19937& rng, size_t side) {
+    type::GeographicalCoord coord;
+    coord.set_xy(rng() % (10 * (side - 1)), rng() % (10 * (side - 1)));
+    return coord;
+}
+
+// the matrix computed by a dijkstra from each origin, as it used to be
+std::vector<std::vector<RoutingElement>> dijkstra_matrix(const georef::GeoRef& geo_ref,
+                                                         const std::vector<type::EntryPoint>& origins,
+                                                         const std::vector<type::GeographicalCoord>& destinations,
+                                                         const navitia::time_duration& max_duration) {
+    georef::DijkstraPathFinder path_finder(geo_ref);
+    std::vector<std::vector<RoutingElement>> result;
+    for (const auto& origin : origins) {
+        path_finder.init(origin.coordinates, origin.streetnetwork_params.mode,
+                         origin.streetnetwork_params.speed_factor);
+        const auto durations = path_finder.get_duration_with_dijkstra(max_duration, destinations);
+        result.emplace_back();
+        for (const auto& destination : destinations) {
+            result.back().push_back(durations.at(destination.uri()));
+        }
+    }
+    return result;
+}
+
+void check_same_matrix(const std::vector<std::vector<RoutingElement>>& matrix,
+                       const std::vector<std::vector<RoutingElement>>& expected,
+                       const int tolerance_in_seconds) {
+    BOOST_REQUIRE_EQUAL(matrix.size(), expected.size());
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(matrix[i].size(), expected[i].size());
+        for (size_t j = 0; j < matrix[i].size(); ++j) {
+            BOOST_CHECK(matrix[i][j].routing_status == expected[i][j].routing_status);
+            const auto difference = matrix[i][j].time_duration - expected[i][j].time_duration;
+            BOOST_CHECK_LE(std::abs(difference.total_seconds()), tolerance_in_seconds);
+        }
+    }
+}
+
+}  // namespace
+
+/*
+ * The matrices by foot (dijkstra from each origin), bike and car (buckets
+ * in the contraction hierarchies) give the durations of a dijkstra from
+ * each origin, sequentially or on several threads
+ */
+BOOST_AUTO_TEST_CASE(matrix_same_durations_as_dijkstra) {
+    georef::GeoRef geo_ref;
+    const size_t side = 20;
+    build_square(geo_ref, side);
+    geo_ref.build_contraction_hierarchies();
+    BOOST_REQUIRE(geo_ref.get_contraction_hierarchy(type::Mode_e::Bike));
+    BOOST_REQUIRE(geo_ref.get_contraction_hierarchy(type::Mode_e::Car));
+
+    std::mt19937 rng(5);
+    std::vector<type::GeographicalCoord> destinations;
+    for (int i = 0; i < 15; ++i) {
+        destinations.push_back(random_coord(rng, side));
+    }
+
+    routing::StreetNetworkMatrix sequential_matrix(geo_ref);
+    routing::ThreadPool thread_pool(3);
+    routing::StreetNetworkMatrix parallel_matrix(geo_ref, &thread_pool);
+    const std::vector<navitia::time_duration> max_durations = {navitia::minutes(1), navitia::hours(1)};
+    size_t nb_reached = 0, nb_unreached = 0;
+    for (const auto mode : {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car}) {
+        // with a speed factor, the durations are rounded edge by edge by the dijkstra
+        for (const float speed_factor : {1.f, 1.5f}) {
+            for (const auto& max_duration : max_durations) {
+                if (speed_factor != 1.f && max_duration < navitia::hours(1)) {
+                    // the rounding could change the status of the destinations near the bound
+                    continue;
+                }
+                std::vector<type::EntryPoint> origins(12);
+                for (auto& origin : origins) {
+                    origin.coordinates = random_coord(rng, side);
+                    origin.streetnetwork_params.mode = mode;
+                    origin.streetnetwork_params.speed_factor = speed_factor;
+                }
+                // an origin on a destination
+                origins.back().coordinates = destinations.front();
+
+                const auto expected = dijkstra_matrix(geo_ref, origins, destinations, max_duration);
+                const int tolerance = speed_factor == 1.f ? 0 : 2;
+                const auto sequential = sequential_matrix.compute(origins, destinations, max_duration);
+                check_same_matrix(sequential, expected, tolerance);
+                const auto parallel = parallel_matrix.compute(origins, destinations, max_duration);
+                check_same_matrix(parallel, sequential, 0);
+
+                for (const auto& row : expected) {
+                    for (const auto& element : row) {
+                        nb_reached += element.routing_status == RoutingStatus_e::reached;
+                        nb_unreached += element.routing_status == RoutingStatus_e::unreached;
+                    }
+                }
+            }
+        }
+    }
+    BOOST_CHECK_GT(nb_reached, 100);
+    BOOST_CHECK_GT(nb_unreached, 100);
+}
+
+/*
+ * Without contraction hierarchies, the matrices by bike and car are
+ * searched by dijkstra as well
+ */
+BOOST_AUTO_TEST_CASE(matrix_without_hierarchy) {
+    georef::GeoRef geo_ref;
+    const size_t side = 10;
+    build_square(geo_ref, side);
+    BOOST_REQUIRE(!geo_ref.get_contraction_hierarchy(type::Mode_e::Bike));
+
+    std::mt19937 rng(8);
+    std::vector<type::GeographicalCoord> destinations;
+    std::vector<type::EntryPoint> origins(5);
+    for (auto& origin : origins) {
+        origin.coordinates = random_coord(rng, side);
+        origin.streetnetwork_params.mode = type::Mode_e::Bike;
+        destinations.push_back(random_coord(rng, side));
+    }
+    // an origin by car in the same matrix
+    origins.back().streetnetwork_params.mode = type::Mode_e::Car;
+
+    routing::ThreadPool thread_pool(2);
+    routing::StreetNetworkMatrix matrix(geo_ref, &thread_pool);
+    const auto max_duration = navitia::minutes(10);
+    check_same_matrix(matrix.compute(origins, destinations, max_duration),
+                      dijkstra_matrix(geo_ref, origins, destinations, max_duration), 0);
+    const auto without_destination = matrix.compute(origins, {}, max_duration);
+    BOOST_REQUIRE_EQUAL(without_destination.size(), origins.size());
+    for (const auto& row : without_destination) {
+        BOOST_CHECK(row.empty());
+    }
+}
@@ -0,0 +1,122 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "thread_pool.h"
+
+namespace navitia {
+namespace routing {
+
+ThreadPool::ThreadPool(size_t nb_threads) {
+    for (size_t i = 1; i < nb_threads; ++i) {
+        threads.emplace_back([this] { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run_tasks(Batch& b) {
+    for (size_t i = b.next_task++; i < b.nb_tasks; i = b.next_task++) {
+        try {
+            b.task(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+}
+
+void ThreadPool::work() {
+    size_t last_generation = 0;
+    while (true) {
+        Batch* current = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [&] { return stopping || generation != last_generation; });
+            if (stopping) {
+                return;
+            }
+            last_generation = generation;
+            // a thread waking up after the end of the parallel_for finds no batch
+            if (!batch) {
+                continue;
+            }
+            current = batch;
+            ++nb_running;
+        }
+        run_tasks(*current);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --nb_running;
+        }
+        work_done.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& t) {
+    if (threads.empty() || n <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            t(i);
+        }
+        return;
+    }
+    Batch current(t, n);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch = &current;
+        ++generation;
+    }
+    work_available.notify_all();
+
+    run_tasks(current);
+
+    // all the tasks have been claimed, we wait for the threads having taken the batch
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&] { return nb_running == 0; });
+    batch = nullptr;
+    if (error) {
+        auto e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+}  // namespace routing
+}  // namespace navitia
@@ -0,0 +1,101 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace navitia {
+namespace routing {
+
+/*
+ * Small pool of threads used to spread the work of a single query.
+ *
+ * The only operation is parallel_for: the tasks [0, nb_tasks) are
+ * claimed one by one by the threads of the pool and by the calling
+ * thread, so an idle thread always steals the next remaining task.
+ * It returns when all the tasks are done.  If a task throws, the
+ * exception is rethrown by parallel_for once the running tasks are
+ * done.
+ *
+ * A pool is not reentrant, and must be used by one thread at a time
+ * (in practice, the one owning the RAPTOR object).
+ */
+class ThreadPool {
+public:
+    /// nb_threads includes the calling thread, thus nb_threads - 1 threads are created
+    explicit ThreadPool(size_t nb_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of threads working on a parallel_for, calling thread included
+    size_t size() const { return threads.size() + 1; }
+
+    void parallel_for(size_t nb_tasks, const std::function<void(size_t)>& task);
+
+private:
+    // a parallel_for, living on the stack of its caller
+    struct Batch {
+        const std::function<void(size_t)>& task;
+        const size_t nb_tasks;
+        std::atomic<size_t> next_task{0};
+
+        Batch(const std::function<void(size_t)>& task, size_t nb_tasks) : task(task), nb_tasks(nb_tasks) {}
+    };
+
+    void run_tasks(Batch& batch);
+    void work();
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    // current batch, protected by mutex. The threads take it with the generation, and
+    // parallel_for waits for all the threads having taken it before resetting it
+    Batch* batch = nullptr;
+    size_t nb_running = 0;
+    std::exception_ptr error;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+}  // namespace routing
+}  // namespace navitia
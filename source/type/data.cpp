@@ -36,6 +36,8 @@ www.navitia.io
 #include "lz4_filter/filter.h"
 #include "pt_data.h"
 #include "routing/dataraptor.h"
+#include "type/datetime.h"
+#include "type/flat_nav.h"
 #include "type/meta_data.h"
 #include "type/serialization.h"
 #include "type/base_pt_objects.h"
@@ -60,11 +62,13 @@ www.navitia.io
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/range/algorithm/find.hpp>
 #include <boost/range/algorithm_ext/push_back.hpp>
+#include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/variant.hpp>
 #include <eos_portable_archive/portable_iarchive.hpp>
 #include <eos_portable_archive/portable_oarchive.hpp>
 
 #include <fstream>
+#include <future>
 #include <thread>
 
 namespace pt = boost::posix_time;
@@ -72,7 +76,7 @@ namespace pt = boost::posix_time;
 namespace navitia {
 namespace type {
 
-const unsigned int Data::data_version = 7;  //< *INCREMENT* every time serialized data are modified
+const unsigned int Data::data_version = 8;  //< *INCREMENT* every time serialized data are modified
 
 Data::Data(size_t data_identifier)
     : _last_rt_data_loaded(boost::posix_time::not_a_date_time),
@@ -80,9 +84,9 @@ Data::Data(size_t data_identifier)
       data_identifier(data_identifier),
       meta(std::make_unique<MetaData>()),
       pt_data(std::make_unique<PT_Data>()),
-      geo_ref(std::make_unique<navitia::georef::GeoRef>()),
+      geo_ref(std::make_shared<navitia::georef::GeoRef>()),
       dataRaptor(std::make_unique<navitia::routing::dataRAPTOR>()),
-      fare(std::make_unique<navitia::fare::Fare>()),
+      fare(std::make_shared<navitia::fare::Fare>()),
       find_admins([&](const GeographicalCoord& c, georef::AdminRtree& admin_tree) {
           return geo_ref->find_admins(c, admin_tree);
       }),
@@ -142,6 +146,7 @@ void Data::load_nav(const std::string& filename) {
         LOG4CPLUS_INFO(logger, boost::format("stopTimes : %d nb foot path : %d Nombre de stop points : %d")
                                    % pt_data->nb_stop_times() % pt_data->stop_point_connections.size()
                                    % pt_data->stop_points.size());
+        load_flat_nav(flat_nav_filename(filename));
     } catch (const std::exception& ex) {
         LOG4CPLUS_ERROR(logger, "Data loading failed: " + std::string(ex.what()));
         throw navitia::data::data_loading_error("Data loading failed: " + std::string(ex.what()));
@@ -152,7 +157,58 @@ void Data::load_nav(const std::string& filename) {
     LOG4CPLUS_DEBUG(logger, "Finished to load nav");
 }
 
+// identifies the .nav a flat nav has been written with
+static boost::optional<int64_t> get_nav_id(const MetaData& meta) {
+    if (meta.publication_date.is_special()) {
+        return boost::none;
+    }
+    return (meta.publication_date - navitia::posix_epoch).total_microseconds();
+}
+
+bool Data::load_flat_nav(const std::string& filename) {
+    log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
+    flat_nav.reset();
+    if (!boost::filesystem::exists(filename)) {
+        LOG4CPLUS_INFO(logger, "No flat nav " << filename << ", the data will be built");
+        return false;
+    }
+    const auto nav_id = get_nav_id(*meta);
+    try {
+        auto flat = FlatNav::open(filename);
+        if (!nav_id || flat->data_version() != version || flat->nav_id() != *nav_id) {
+            LOG4CPLUS_WARN(logger, "The flat nav " << filename << " has not been written with the loaded data, "
+                                                   << "it is ignored");
+            return false;
+        }
+        flat_nav = std::move(flat);
+    } catch (const navitia::exception& e) {
+        LOG4CPLUS_WARN(logger, "The flat nav is ignored: " << e.what());
+        return false;
+    }
+    LOG4CPLUS_INFO(logger, "Flat nav " << filename << " mapped");
+    return true;
+}
+
+void Data::save_flat_nav(const std::string& filename) const {
+    const auto nav_id = get_nav_id(*meta);
+    if (!nav_id) {
+        throw navitia::exception("Unable to write a flat nav for data without publication date");
+    }
+    FlatNavWriter writer;
+    pt_data->save_flat(writer);
+    geo_ref->save_flat(writer);
+    writer.write(filename, data_version, *nav_id);
+}
+
 void Data::load(std::istream& ifs) {
+    if (lz4_frame::is_frame(ifs)) {
+        // the blocks are decompressed in parallel, batch by batch, as they are deserialized
+        lz4_frame::Reader in(ifs);
+        eos::portable_iarchive ia(in);
+        ia >> *this;
+        return;
+    }
+    // stream format, written before the framed one
     boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
     in.push(LZ4Decompressor(2048 * 500), 8192 * 500, 8192 * 500);
     in.push(ifs);
@@ -202,11 +258,19 @@ void Data::load_disruptions(const std::string& database, const std::vector<std::
  *
  * @param cache_size Selected LRU size to optimize cache miss
  */
-void Data::build_raptor(size_t cache_size) {
+void Data::build_raptor(size_t cache_size, const Data* previous) {
     // Add logger
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
-    LOG4CPLUS_DEBUG(logger, "Start to build data Raptor");
-    dataRaptor->load(*this->pt_data, cache_size);
+    // the raptor data of previous must be up to date with its pt_data
+    if (previous && previous->pt_data->modified_meta_vjs.empty()) {
+        LOG4CPLUS_DEBUG(logger, "Start to rebuild data Raptor for " << pt_data->modified_meta_vjs.size()
+                                                                    << " modified meta vehicle journeys");
+        dataRaptor->load(*this->pt_data, *previous->dataRaptor, pt_data->modified_meta_vjs, cache_size);
+    } else {
+        LOG4CPLUS_DEBUG(logger, "Start to build data Raptor");
+        dataRaptor->load(*this->pt_data, cache_size);
+    }
+    pt_data->modified_meta_vjs.clear();
     LOG4CPLUS_DEBUG(logger, "Finished to build data Raptor");
 }
 
@@ -254,11 +318,14 @@ void Data::save(const std::string& filename) const {
 }
 
 void Data::save(std::ostream& ofs) const {
-    boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
-    out.push(LZ4Compressor(2048 * 500), 1024 * 500, 1024 * 500);
-    out.push(ofs);
-    eos::portable_oarchive oa(out);
-    oa << *this;
+    lz4_frame::Writer writer(ofs);
+    {
+        boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
+        out.push(writer.sink(), 1024 * 500, 1024 * 500);
+        eos::portable_oarchive oa(out);
+        oa << *this;
+    }
+    writer.finish();
 }
 
 void Data::build_uri() {
@@ -271,8 +338,15 @@ void Data::build_uri() {
 }
 
 void Data::build_proximity_list() {
-    this->pt_data->build_proximity_list();
-    this->geo_ref->build_proximity_list();
+    // the lists and the projections shared by a clone are still valid, as
+    // realtime neither adds nor moves stop points, and a shared street
+    // network must not be modified
+    if (is_geo_ref_shared) {
+        return;
+    }
+    auto pt_lists = std::async(std::launch::async, [&]() { this->pt_data->build_proximity_list(flat_nav); });
+    this->geo_ref->build_proximity_list(flat_nav);
+    pt_lists.get();
     this->geo_ref->project_stop_points(this->pt_data->stop_points);
 }
 
@@ -325,7 +399,7 @@ void Data::build_administrative_regions() {
     for (const auto* sa : pt_data->stop_areas) {
         for (auto admin : sa->admin_list) {
             if (!admin->from_original_dataset) {
-                admin->main_stop_areas.push_back(sa);
+                admin->main_stop_area_uris.push_back(sa->uri);
             }
         }
     }
@@ -338,7 +412,9 @@ void Data::build_autocomplete() {
 
 void Data::build_autocomplete_partial() {
     pt_data->build_autocomplete(*geo_ref);
-    pt_data->compute_score_autocomplete(*geo_ref);
+    // the scores of the street network objects only depend on the stop
+    // points, that realtime never adds: they are kept when shared
+    pt_data->compute_score_autocomplete(*geo_ref, !is_geo_ref_shared);
 }
 
 ValidityPattern* Data::get_similar_validity_pattern(ValidityPattern* vp) const {
@@ -437,17 +513,56 @@ static void build_companies(navitia::type::VehicleJourney* vj) {
     }
 }
 
-void Data::build_relations() {
+static void build_vj_relations(navitia::type::VehicleJourney* vj) {
+    build_datasets(vj);
+    build_route_and_stop_point_relations(vj);
+    if (!vj->physical_mode || !vj->route || !vj->route->line) {
+        return;
+    }
+    build_companies(vj);
     // physical_mode_list of line
+    if (!navitia::contains(vj->route->line->physical_mode_list, vj->physical_mode)) {
+        vj->route->line->physical_mode_list.push_back(vj->physical_mode);
+    }
+}
+
+void Data::build_relations() {
     for (auto* vj : pt_data->vehicle_journeys) {
-        build_datasets(vj);
-        build_route_and_stop_point_relations(vj);
-        if (!vj->physical_mode || !vj->route || !vj->route->line) {
+        build_vj_relations(vj);
+    }
+}
+
+void Data::build_relations(const std::set<std::string>& meta_vjs) {
+    std::set<Route*> routes;
+    for (const auto& uri : meta_vjs) {
+        if (!pt_data->meta_vjs.exists(uri)) {
             continue;
         }
-        build_companies(vj);
-        if (!navitia::contains(vj->route->line->physical_mode_list, vj->physical_mode)) {
-            vj->route->line->physical_mode_list.push_back(vj->physical_mode);
+        pt_data->meta_vjs.get_mut(uri)->for_all_vjs([&](VehicleJourney& vj) {
+            build_vj_relations(&vj);
+            if (vj.route) {
+                routes.insert(vj.route);
+            }
+        });
+    }
+
+    // the removed vjs may have left stop points on their route
+    for (auto* route : routes) {
+        for (auto* sp : route->stop_point_list) {
+            sp->route_list.erase(route);
+        }
+        for (auto* sa : route->stop_area_list) {
+            if (sa) {
+                sa->route_list.erase(route);
+            }
+        }
+        route->stop_point_list.clear();
+        route->stop_area_list.clear();
+        for (auto* vj : route->discrete_vehicle_journey_list) {
+            build_route_and_stop_point_relations(vj);
+        }
+        for (auto* vj : route->frequency_vehicle_journey_list) {
+            build_route_and_stop_point_relations(vj);
         }
     }
 }
@@ -479,7 +594,7 @@ void Data::aggregate_odt() {
     // we first store the stops in a set not to have duplicates
     for (const auto& p : odt_stops_by_admin) {
         for (const auto& sp : p.second) {
-            p.first->odt_stop_points.push_back(sp);
+            p.first->odt_stop_point_uris.push_back(sp->uri);
         }
     }
 }
@@ -818,11 +933,46 @@ struct Pipe {
     Pipe& operator=(const Pipe&&) = delete;
     ~Pipe() { sbuf.close(); }
 };
+
+// Returns the objects corresponding to the ones of set in a clone
+template <typename T>
+boost::container::flat_set<T*> clone_set(const boost::container::flat_set<T*>& set, const std::vector<T*>& objects) {
+    std::vector<T*> cloned;
+    cloned.reserve(set.size());
+    for (const auto* obj : set) {
+        cloned.push_back(obj ? objects[obj->idx] : nullptr);
+    }
+    return boost::container::flat_set<T*>(cloned.begin(), cloned.end());
+}
+
+// The relations built by Data::build_relations are not serialized, they
+// are copied from the source of the clone for build_relations to only
+// handle the vjs modified by realtime.
+void clone_relations(const PT_Data& from, PT_Data& to) {
+    for (const auto* route : from.routes) {
+        auto* to_route = to.routes[route->idx];
+        to_route->stop_point_list = clone_set(route->stop_point_list, to.stop_points);
+        to_route->stop_area_list = clone_set(route->stop_area_list, to.stop_areas);
+    }
+    for (const auto* sp : from.stop_points) {
+        to.stop_points[sp->idx]->route_list = clone_set(sp->route_list, to.routes);
+    }
+    for (const auto* sa : from.stop_areas) {
+        to.stop_areas[sa->idx]->route_list = clone_set(sa->route_list, to.routes);
+    }
+    for (const auto* dataset : from.datasets) {
+        to.datasets[dataset->idx]->vehiclejourney_list = clone_set(dataset->vehiclejourney_list, to.vehicle_journeys);
+    }
+}
 }  // anonymous namespace
 
-// We want to do a deep clone of a Data.  The problem is that there is a
-// lot of pointers that point to each other, and thus writing a copy
-// assignment operator is really tricky.
+// We want to clone a Data for realtime.  Realtime only modifies the
+// public transport data, thus the street network and the fares, which
+// are the biggest part of a Data, are shared with the cloned data.
+//
+// For the public transport data, we need a deep clone.  The problem is
+// that there is a lot of pointers that point to each other, and thus
+// writing a copy assignment operator is really tricky.
 //
 // But we already have a framework that allow this deep clone: boost
 // serialize.  Maybe we can write a dedicated Archive that clone the
@@ -830,17 +980,79 @@ struct Pipe {
 // stream the source object in a binary_oarchive, and then stream it
 // in our object.  To avoid having the whole binary_oarchive in
 // memory, we construct a pipe between 2 threads.
+//
+// Streaming the stop points and the stop areas also copies the admins
+// they are in: these copies are replaced by the shared admins.  As
+// realtime neither adds nor moves stop points, their proximity lists
+// are also shared.
 void Data::clone_from(const Data& from) {
     Pipe p;
     std::thread write([&]() {
         boost::archive::binary_oarchive oa(p.out);
-        oa << from;
+        oa << from.pt_data << from.meta;
     });
     {
         boost::archive::binary_iarchive ia(p.in);
-        ia >> *this;
+        ia >> pt_data >> meta;
     }
     write.join();
+
+    version = from.version;
+    loaded = from.loaded.load();
+    last_load_at = from.last_load_at;
+    last_load_succeeded = from.last_load_succeeded;
+    is_connected_to_rabbitmq = from.is_connected_to_rabbitmq.load();
+    is_realtime_loaded = from.is_realtime_loaded.load();
+    disruption_error = from.disruption_error.load();
+
+    geo_ref = from.geo_ref;
+    fare = from.fare;
+    is_geo_ref_shared = true;
+    // the clone has the same base data, thus it can still use the flat nav
+    flat_nav = from.flat_nav;
+    pt_data->stop_area_proximity_list.share_index(from.pt_data->stop_area_proximity_list);
+    pt_data->stop_point_proximity_list.share_index(from.pt_data->stop_point_proximity_list);
+    clone_relations(*from.pt_data, *pt_data);
+
+    std::set<const georef::Admin*> copies;
+    std::set<const georef::Admin*> kept;
+    auto share = [&](std::vector<georef::Admin*>& admin_list) {
+        for (auto& admin : admin_list) {
+            copies.insert(admin);
+            if (admin->idx < geo_ref->admins.size() && geo_ref->admins[admin->idx]->uri == admin->uri) {
+                admin = geo_ref->admins[admin->idx];
+            } else {
+                // should not happen, but in this case the copy is kept
+                kept.insert(admin);
+            }
+        }
+    };
+    for (auto* sp : pt_data->stop_points) {
+        share(sp->admin_list);
+    }
+    for (auto* sa : pt_data->stop_areas) {
+        share(sa->admin_list);
+    }
+    // the parents of the copies have also been copied
+    auto add_parents = [](std::set<const georef::Admin*>& admins) {
+        std::vector<const georef::Admin*> to_visit(admins.begin(), admins.end());
+        while (!to_visit.empty()) {
+            const auto* admin = to_visit.back();
+            to_visit.pop_back();
+            for (const auto* parent : admin->admin_list) {
+                if (admins.insert(parent).second) {
+                    to_visit.push_back(parent);
+                }
+            }
+        }
+    };
+    add_parents(copies);
+    add_parents(kept);
+    for (const auto* admin : copies) {
+        if (!kept.count(admin)) {
+            delete admin;
+        }
+    }
 }
 
 void Data::set_last_rt_data_loaded(const boost::posix_time::ptime& p) const {
@@ -45,15 +45,19 @@ www.navitia.io
 #include <set>
 
 // workaround missing "is_trivially_copyable" in g++ < 5.0
+#ifndef IS_TRIVIALLY_COPYABLE
 #if __GNUG__ && __GNUC__ < 5
 #define IS_TRIVIALLY_COPYABLE(T) __has_trivial_copy(T)
 #else
 #define IS_TRIVIALLY_COPYABLE(T) std::is_trivially_copyable<T>::value
 #endif
+#endif
 
 namespace navitia {
 namespace type {
 
+class FlatNav;
+
 template <typename T>
 struct ContainerTrait {
     typedef std::vector<T*> vect_type;
@@ -129,13 +133,22 @@ public:
     // public transport (PT) referential
     std::unique_ptr<PT_Data> pt_data;
 
-    std::unique_ptr<navitia::georef::GeoRef> geo_ref;
+    // The street network and the fares are shared with the data cloned
+    // from this one (see clone_from), they must not be modified once shared
+    std::shared_ptr<navitia::georef::GeoRef> geo_ref;
 
     // precomputed data for raptor (public transport routing algorithm)
     std::unique_ptr<navitia::routing::dataRAPTOR> dataRaptor;
 
     // Fare data
-    std::unique_ptr<navitia::fare::Fare> fare;
+    std::shared_ptr<navitia::fare::Fare> fare;
+
+    // geo_ref and fare come from the data this one has been cloned from,
+    // the stop points proximity lists and projections are also shared
+    bool is_geo_ref_shared = false;
+
+    // read-only mapping of the flat nav loaded along the .nav, if any
+    std::shared_ptr<const FlatNav> flat_nav;
 
     // functor to find admins
     std::function<std::vector<georef::Admin*>(const GeographicalCoord&, georef::AdminRtree&)> find_admins;
@@ -202,13 +215,29 @@ public:
     // Loading methods
     void load_nav(const std::string& filename);
     void load_disruptions(const std::string& database, const std::vector<std::string>& contributors = {});
-    void build_raptor(size_t cache_size = 10);
+    // Builds the raptor data.  If previous is given, it must be the data
+    // this one has been cloned from, and only the journey patterns of the
+    // meta vjs modified since the clone are rebuilt.
+    void build_raptor(size_t cache_size = 10, const Data* previous = nullptr);
 
     void warmup(const Data& other);
 
     /** Save data */
     void save(const std::string& filename) const;
 
+    /** Save the immutable bulk in a flat nav file, see type/flat_nav.h
+     *
+     * The proximity lists must be built.
+     */
+    void save_flat_nav(const std::string& filename) const;
+
+    /** Map the flat nav file, if it has been written with the loaded .nav
+     *
+     * Returns false when the file is missing or doesn't match, the data
+     * are then built as usual.
+     */
+    bool load_flat_nav(const std::string& filename);
+
     /** Build ExternalCode index */
     void build_uri();
 
@@ -223,6 +252,9 @@ public:
 
     void aggregate_odt();
     void build_relations();
+    // Builds the relations of the vjs of the given meta vjs, the ones of
+    // the other vjs being already built (see clone_from)
+    void build_relations(const std::set<std::string>& meta_vjs);
 
     void build_grid_validity_pattern();
 
@@ -244,7 +276,8 @@ public:
     /** Save data in a compressed binary file using LZ4*/
     void save(std::ostream& ofs) const;
 
-    // Deep clone from the given Data.
+    // Clone from the given Data: the public transport data are deep
+    // copied, the street network and the fares are shared.
     void clone_from(const Data&);
 
     void set_last_rt_data_loaded(const boost::posix_time::ptime&) const;
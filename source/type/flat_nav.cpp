@@ -0,0 +1,194 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "type/flat_nav.h"
+
+#include "utils/exception.h"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace navitia {
+namespace type {
+
+namespace {
+
+const char magic[8] = {'N', 'A', 'V', 'F', 'L', 'A', 'T', '\0'};
+// *INCREMENT* every time the layout of the file is modified
+const uint32_t format_version = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t data_version;
+    int64_t nav_id;
+    uint64_t nb_sections;
+};
+
+struct SectionHeader {
+    char name[48];
+    uint64_t offset;
+    uint64_t elt_size;
+    uint64_t nb_elts;
+};
+
+uint64_t align(uint64_t offset) {
+    const uint64_t alignment = FlatNav::section_alignment;
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+std::string flat_nav_filename(const std::string& nav_filename) {
+    // data.nav.lz4 -> data.nav.flat
+    if (boost::algorithm::ends_with(nav_filename, ".lz4")) {
+        return nav_filename.substr(0, nav_filename.size() - 4) + ".flat";
+    }
+    return nav_filename + ".flat";
+}
+
+void FlatNavWriter::write(const std::string& filename, uint32_t data_version, int64_t nav_id) const {
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.format_version = format_version;
+    header.data_version = data_version;
+    header.nav_id = nav_id;
+    header.nb_sections = sections.size();
+
+    std::vector<SectionHeader> section_headers;
+    uint64_t offset = align(sizeof(Header) + sections.size() * sizeof(SectionHeader));
+    for (const auto& name_section : sections) {
+        if (name_section.first.size() >= sizeof(SectionHeader::name)) {
+            throw navitia::exception("flat nav section name too long: " + name_section.first);
+        }
+        SectionHeader section_header{};
+        std::strncpy(section_header.name, name_section.first.c_str(), sizeof(section_header.name) - 1);
+        section_header.offset = offset;
+        section_header.elt_size = name_section.second.elt_size;
+        section_header.nb_elts = name_section.second.nb_elts;
+        section_headers.push_back(section_header);
+        offset = align(offset + section_header.elt_size * section_header.nb_elts);
+    }
+
+    try {
+        std::ofstream ofs(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        ofs.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(section_headers.data()),
+                  section_headers.size() * sizeof(SectionHeader));
+        auto section_header = section_headers.begin();
+        for (const auto& name_section : sections) {
+            // padding up to the aligned offset of the section
+            const std::vector<char> padding(section_header->offset - static_cast<uint64_t>(ofs.tellp()), 0);
+            ofs.write(padding.data(), padding.size());
+            ofs.write(static_cast<const char*>(name_section.second.data),
+                      name_section.second.elt_size * name_section.second.nb_elts);
+            ++section_header;
+        }
+    } catch (const std::ofstream::failure& e) {
+        throw navitia::exception("Unable to write flat nav file " + filename + ": " + e.what());
+    }
+}
+
+std::shared_ptr<const FlatNav> FlatNav::open(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw navitia::exception("Unable to open flat nav file " + filename + ": " + std::strerror(errno));
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) == -1) {
+        const std::string error = std::strerror(errno);
+        ::close(fd);
+        throw navitia::exception("Unable to stat flat nav file " + filename + ": " + error);
+    }
+    const size_t size = st.st_size;
+    if (size < sizeof(Header)) {
+        ::close(fd);
+        throw navitia::exception("Invalid flat nav file " + filename + ": file too short");
+    }
+    // MAP_SHARED: the krakens mapping the same file share its pages
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping keeps its own reference on the file
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw navitia::exception("Unable to map flat nav file " + filename + ": " + std::strerror(errno));
+    }
+
+    // from now on, the mapping is released by the destructor
+    std::shared_ptr<FlatNav> flat_nav(new FlatNav());
+    flat_nav->mapping = mapping;
+    flat_nav->mapping_size = size;
+
+    const auto* begin = static_cast<const char*>(mapping);
+    const auto* header = reinterpret_cast<const Header*>(begin);
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0) {
+        throw navitia::exception("Invalid flat nav file " + filename + ": bad magic number");
+    }
+    if (header->format_version != format_version) {
+        throw navitia::exception("Invalid flat nav file " + filename + ": format version "
+                                 + std::to_string(header->format_version) + " instead of "
+                                 + std::to_string(format_version));
+    }
+    if (header->nb_sections > (size - sizeof(Header)) / sizeof(SectionHeader)) {
+        throw navitia::exception("Invalid flat nav file " + filename + ": truncated section table");
+    }
+    flat_nav->_data_version = header->data_version;
+    flat_nav->_nav_id = header->nav_id;
+
+    const auto* section_header = reinterpret_cast<const SectionHeader*>(begin + sizeof(Header));
+    for (uint64_t i = 0; i < header->nb_sections; ++i, ++section_header) {
+        const std::string name(section_header->name, strnlen(section_header->name, sizeof(section_header->name)));
+        const uint64_t nb_bytes = section_header->elt_size * section_header->nb_elts;
+        if (section_header->offset % section_alignment != 0 || section_header->offset > size
+            || nb_bytes > size - section_header->offset) {
+            throw navitia::exception("Invalid flat nav file " + filename + ": section " + name + " out of the file");
+        }
+        flat_nav->sections[name] = Section{begin + section_header->offset, section_header->elt_size,
+                                           section_header->nb_elts};
+    }
+    return flat_nav;
+}
+
+FlatNav::~FlatNav() {
+    if (mapping) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+}  // namespace type
+}  // namespace navitia
@@ -0,0 +1,148 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+channel `#navitia` on riot https://riot.im/app/#/room/#navitia:matrix.org
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <boost/utility.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// workaround missing "is_trivially_copyable" in g++ < 5.0 (as in data.h)
+#ifndef IS_TRIVIALLY_COPYABLE
+#if __GNUG__ && __GNUC__ < 5
+#define IS_TRIVIALLY_COPYABLE(T) __has_trivial_copy(T)
+#else
+#define IS_TRIVIALLY_COPYABLE(T) std::is_trivially_copyable<T>::value
+#endif
+#endif
+
+namespace navitia {
+namespace type {
+
+/*
+ * The flat nav file holds the immutable bulk of a Data as raw arrays.
+ *
+ * Kraken maps it read-only and uses the arrays in place: nothing is
+ * deserialized nor copied on the heap, and the pages are shared by all
+ * the krakens of a host mapping the same file.  It is written by ed2nav
+ * next to the classic .nav.lz4 (see flat_nav_filename), and is only
+ * used along the .nav it has been written with.
+ *
+ * Layout (native endianness and alignment: the file is not portable
+ * across architectures):
+ *   Header | SectionHeader x nb_sections | the sections, each aligned on section_alignment
+ */
+
+/// read-only view on an array
+template <typename T>
+class FlatArray {
+    const T* ptr = nullptr;
+    size_t nb = 0;
+
+public:
+    FlatArray() = default;
+    FlatArray(const T* ptr, size_t nb) : ptr(ptr), nb(nb) {}
+    explicit FlatArray(const std::vector<T>& v) : ptr(v.data()), nb(v.size()) {}
+
+    const T* data() const { return ptr; }
+    size_t size() const { return nb; }
+    bool empty() const { return nb == 0; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + nb; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+};
+
+/// the file name of the flat nav written along a .nav.lz4 file
+std::string flat_nav_filename(const std::string& nav_filename);
+
+class FlatNavWriter {
+    struct Section {
+        const void* data;
+        uint64_t elt_size;
+        uint64_t nb_elts;
+    };
+    std::map<std::string, Section> sections;
+
+public:
+    /// the array must not be modified until the file is written
+    template <typename T>
+    void add(const std::string& name, FlatArray<T> array) {
+        static_assert(IS_TRIVIALLY_COPYABLE(T), "only raw data can be used in place");
+        sections[name] = Section{array.data(), sizeof(T), array.size()};
+    }
+
+    /// write the sections, tagged with the identity of the .nav they come with
+    void write(const std::string& filename, uint32_t data_version, int64_t nav_id) const;
+};
+
+class FlatNav : boost::noncopyable {
+    struct Section {
+        const char* data;
+        uint64_t elt_size;
+        uint64_t nb_elts;
+    };
+
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    uint32_t _data_version = 0;
+    int64_t _nav_id = 0;
+    std::map<std::string, Section> sections;
+
+    FlatNav() = default;
+
+public:
+    static const size_t section_alignment = 64;
+
+    /// map the file.  Throw a navitia::exception if it is not a valid flat nav file
+    static std::shared_ptr<const FlatNav> open(const std::string& filename);
+    ~FlatNav();
+
+    uint32_t data_version() const { return _data_version; }
+    int64_t nav_id() const { return _nav_id; }
+
+    /// the section as an array of T, none if it is missing or not made of T
+    template <typename T>
+    boost::optional<FlatArray<T>> get(const std::string& name) const {
+        const auto it = sections.find(name);
+        if (it == sections.end() || it->second.elt_size != sizeof(T)) {
+            return boost::none;
+        }
+        return FlatArray<T>(reinterpret_cast<const T*>(it->second.data), it->second.nb_elts);
+    }
+};
+
+}  // namespace type
+}  // namespace navitia
@@ -116,6 +116,8 @@ void cleanup_useless_vj_link(const nt::VehicleJourney* vj, nt::PT_Data& pt_data)
 }  // anonymous namespace
 
 void MetaVehicleJourney::clean_up_useless_vjs(nt::PT_Data& pt_data) {
+    // the vps of the vjs are modified before their clean up
+    pt_data.modified_meta_vjs.insert(uri);
     std::vector<std::pair<RTLevel, size_t>> vj_idx_to_remove;
     for (const auto rt_vjs : rtlevel_to_vjs_map) {
         auto& vjs = rt_vjs.second;
@@ -265,6 +267,7 @@ void MetaVehicleJourney::cancel_vj(RTLevel level,
                                    const std::vector<boost::posix_time::time_period>& periods,
                                    nt::PT_Data& pt_data,
                                    const Route* filtering_route) {
+    pt_data.modified_meta_vjs.insert(uri);
     for (auto vj_level : reverse_enum_range_from<RTLevel>(level)) {
         for (auto& vj : rtlevel_to_vjs_map[vj_level]) {
             // for each vj, we want to cancel vp at all levels above cancel level
@@ -551,7 +551,13 @@ void PbCreator::Filler::fill_pb_object(const ng::Admin* adm, pbnavitia::Administ
     if (depth > 1) {
         // for the admin we add the main stop area, but with the minimum vital information
         auto minimum_filler = Filler(0, {DumpMessage::No, DumpLineSectionMessage::No}, pb_creator);
-        for (const auto& sa : adm->main_stop_areas) {
+        const auto& stop_areas_map = pb_creator.data->pt_data->stop_areas_map;
+        for (const auto& sa_uri : adm->main_stop_area_uris) {
+            const auto it = stop_areas_map.find(sa_uri);
+            if (it == stop_areas_map.end()) {
+                continue;
+            }
+            const auto* sa = it->second;
             auto* pb_sa = admin->add_main_stop_areas();
 
             minimum_filler.fill_pb_object(sa, pb_sa);
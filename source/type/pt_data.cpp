@@ -305,29 +305,41 @@ void PT_Data::build_autocomplete(const navitia::georef::GeoRef& georef) {
     this->route_autocomplete.build();
 }
 
-void PT_Data::compute_score_autocomplete(navitia::georef::GeoRef& georef) {
-    // Compute admin score using stop_point count in each admin
-    georef.fl_admin.compute_score((*this), georef, type::Type_e::Admin);
-    // use the score of each admin for it's objects like "POI", "way" and "stop_point"
-    georef.fl_way.compute_score((*this), georef, type::Type_e::Way);
-    georef.fl_poi.compute_score((*this), georef, type::Type_e::POI);
+void PT_Data::compute_score_autocomplete(navitia::georef::GeoRef& georef, bool with_georef) {
+    if (with_georef) {
+        // Compute admin score using stop_point count in each admin
+        georef.fl_admin.compute_score((*this), georef, type::Type_e::Admin);
+        // use the score of each admin for it's objects like "POI", "way" and "stop_point"
+        georef.fl_way.compute_score((*this), georef, type::Type_e::Way);
+        georef.fl_poi.compute_score((*this), georef, type::Type_e::POI);
+    }
     this->stop_point_autocomplete.compute_score((*this), georef, type::Type_e::StopPoint);
     // Compute stop_area score using it's stop_point count
     this->stop_area_autocomplete.compute_score((*this), georef, type::Type_e::StopArea);
 }
 
-void PT_Data::build_proximity_list() {
-    this->stop_area_proximity_list.clear();
-    for (const StopArea* stop_area : this->stop_areas) {
-        this->stop_area_proximity_list.add(stop_area->coord, stop_area->idx);
+void PT_Data::build_proximity_list(const std::shared_ptr<const FlatNav>& flat_nav) {
+    if (!flat_nav || !this->stop_area_proximity_list.build_from_flat(flat_nav, "pt.stop_areas", stop_areas.size())) {
+        this->stop_area_proximity_list.clear();
+        for (const StopArea* stop_area : this->stop_areas) {
+            this->stop_area_proximity_list.add(stop_area->coord, stop_area->idx);
+        }
+        this->stop_area_proximity_list.build();
     }
-    this->stop_area_proximity_list.build();
 
-    this->stop_point_proximity_list.clear();
-    for (const StopPoint* stop_point : this->stop_points) {
-        this->stop_point_proximity_list.add(stop_point->coord, stop_point->idx);
+    if (!flat_nav
+        || !this->stop_point_proximity_list.build_from_flat(flat_nav, "pt.stop_points", stop_points.size())) {
+        this->stop_point_proximity_list.clear();
+        for (const StopPoint* stop_point : this->stop_points) {
+            this->stop_point_proximity_list.add(stop_point->coord, stop_point->idx);
+        }
+        this->stop_point_proximity_list.build();
     }
-    this->stop_point_proximity_list.build();
+}
+
+void PT_Data::save_flat(FlatNavWriter& writer) const {
+    stop_area_proximity_list.save_flat(writer, "pt.stop_areas");
+    stop_point_proximity_list.save_flat(writer, "pt.stop_points");
 }
 
 void PT_Data::build_admins_stop_areas() {
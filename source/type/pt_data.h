@@ -43,6 +43,7 @@ www.navitia.io
 #include "headsign_handler.h"
 #include "type/timezone_manager.h"
 #include <memory>
+#include <set>
 
 namespace navitia {
 template <>
@@ -75,6 +76,10 @@ public:
     // meta vj factory
     navitia::ObjFactory<MetaVehicleJourney> meta_vjs;
 
+    // uris of the meta vjs whose vjs have been added, modified or removed
+    // since the last build of the raptor data (see Data::build_raptor)
+    std::set<std::string> modified_meta_vjs;
+
     // associated cal for vj
     std::vector<AssociatedCalendar*> associated_calendars;
 
@@ -122,11 +127,13 @@ public:
     /** Construit l'indexe Autocomplete */
     void build_autocomplete(const navitia::georef::GeoRef&);
 
-    /** Calcul le score des objectTC */
-    void compute_score_autocomplete(navitia::georef::GeoRef&);
+    /** Calcul le score des objectTC, and the one of the street network objects if with_georef */
+    void compute_score_autocomplete(navitia::georef::GeoRef&, bool with_georef = true);
 
-    /** Construit l'indexe ProximityList */
-    void build_proximity_list();
+    /** Construit l'indexe ProximityList, from the lists of the flat nav when given */
+    void build_proximity_list(const std::shared_ptr<const FlatNav>& flat_nav = nullptr);
+    /// add the proximity lists to the flat nav
+    void save_flat(FlatNavWriter& writer) const;
     void build_admins_stop_areas();
     /// sort the collections and set the corresponding idx field
     void sort_and_index();
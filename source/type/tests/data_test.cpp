@@ -34,14 +34,27 @@ www.navitia.io
 // Boost
 #include <boost/test/unit_test.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <eos_portable_archive/portable_iarchive.hpp>
+#include <eos_portable_archive/portable_oarchive.hpp>
 
 // Std
+#include <fstream>
+#include <sstream>
 #include <string>
 
 #include "utils/functions.h"  // absolute_path function
 
 // Data to test
 #include "type/data.h"
+#include "type/datetime.h"
+#include "type/flat_nav.h"
+#include "type/meta_data.h"
+#include "type/pt_data.h"
+#include "ed/build_helper.h"
+#include "georef/adminref.h"
+#include "georef/georef.h"
+#include "lz4_filter/filter.h"
 
 using namespace navitia;
 
@@ -75,6 +88,138 @@ BOOST_AUTO_TEST_CASE(load_data) {
     boost::filesystem::remove(fake_data_path);
 }
 
+BOOST_AUTO_TEST_CASE(load_stream_format_nav) {
+    ed::builder b("20180309");
+    b.sa("stop_area:sa1", 2.39592, 48.84848, false)("stop_point:sa1:s1", 2.39592, 48.84848, false);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+
+    // the files written before the framed format can still be loaded
+    const std::string data_path = navitia::absolute_path() + fake_data_file;
+    {
+        std::ofstream ofs(data_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
+        out.push(LZ4Compressor(2048 * 500), 1024 * 500, 1024 * 500);
+        out.push(ofs);
+        eos::portable_oarchive oa(out);
+        const navitia::type::Data& saved = *b.data;
+        oa << saved;
+    }
+    {
+        std::ifstream ifs(data_path, std::ios::in | std::ios::binary);
+        BOOST_CHECK(!lz4_frame::is_frame(ifs));
+    }
+
+    navitia::type::Data data(1);
+    data.load_nav(data_path);
+    BOOST_CHECK_EQUAL(data.pt_data->stop_points.size(), 1);
+    BOOST_CHECK_EQUAL(data.pt_data->stop_points[0]->uri, "stop_point:sa1:s1");
+
+    // and are now written in the framed format
+    data.save(data_path);
+    {
+        std::ifstream ifs(data_path, std::ios::in | std::ios::binary);
+        BOOST_CHECK(lz4_frame::is_frame(ifs));
+    }
+    navitia::type::Data framed_data(2);
+    framed_data.load_nav(data_path);
+    BOOST_CHECK_EQUAL(framed_data.pt_data->stop_points.size(), 1);
+
+    boost::filesystem::remove(data_path);
+}
+
+BOOST_AUTO_TEST_CASE(load_flat_nav) {
+    ed::builder b("20180309");
+    b.sa("stop_area:sa1", 2.39592, 48.84848, false)("stop_point:sa1:s1", 2.39592, 48.84848, false);
+    b.sa("stop_area:sa2", 2.36381, 48.86650, false)("stop_point:sa2:s1", 2.36381, 48.86650, false);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+    b.data->build_proximity_list();
+    b.data->meta->publication_date = "20180309T120000"_dt;
+
+    const std::string data_path = navitia::absolute_path() + fake_data_file;
+    const std::string flat_nav_path = navitia::type::flat_nav_filename(data_path);
+    b.data->save(data_path);
+    b.data->save_flat_nav(flat_nav_path);
+
+    navitia::type::Data data(1);
+    data.load_nav(data_path);
+    BOOST_REQUIRE(data.flat_nav);
+
+    // the proximity lists are read in place from the flat nav
+    data.build_proximity_list();
+    const auto& stop_point_pl = data.pt_data->stop_point_proximity_list;
+    BOOST_CHECK(stop_point_pl.flat_nav);
+    BOOST_CHECK(stop_point_pl.items.empty());
+    BOOST_CHECK_EQUAL(stop_point_pl.get_items().size(), 2);
+    const navitia::type::GeographicalCoord coord(2.39592, 48.84848);
+    const auto expected = b.data->pt_data->stop_point_proximity_list.find_within(coord, 3000);
+    const auto found = stop_point_pl.find_within(coord, 3000);
+    BOOST_REQUIRE_EQUAL(found.size(), 2);
+    BOOST_REQUIRE_EQUAL(found.size(), expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        BOOST_CHECK_EQUAL(found[i].first, expected[i].first);
+    }
+
+    // serialized again, the list has the mapped items
+    std::stringstream archive;
+    {
+        eos::portable_oarchive oa(archive);
+        oa << stop_point_pl;
+    }
+    navitia::proximitylist::ProximityList<navitia::type::idx_t> loaded_pl;
+    {
+        eos::portable_iarchive ia(archive);
+        ia >> loaded_pl;
+    }
+    BOOST_CHECK_EQUAL(loaded_pl.items.size(), 2);
+
+    // a flat nav written with another .nav is ignored
+    b.data->meta->publication_date += boost::posix_time::seconds(1);
+    b.data->save(data_path);
+    navitia::type::Data other_data(2);
+    other_data.load_nav(data_path);
+    BOOST_CHECK(!other_data.flat_nav);
+
+    boost::filesystem::remove(data_path);
+    boost::filesystem::remove(flat_nav_path);
+}
+
+BOOST_AUTO_TEST_CASE(clone_data_shares_street_network) {
+    ed::builder b("20180309");
+    b.sa("stop_area:sa1", 2.39592, 48.84848, false)("stop_point:sa1:s1", 2.39592, 48.84848, false);
+    b.finish();
+    b.data->pt_data->sort_and_index();
+
+    auto* region = new navitia::georef::Admin(0, "admin:region", "Region", 4, "", "Region", {}, {});
+    auto* city = new navitia::georef::Admin(1, "admin:city", "City", 8, "75056", "City", {}, {});
+    city->admin_list.push_back(region);
+    b.data->geo_ref->admins = {region, city};
+    auto* sp = b.data->pt_data->stop_points_map["stop_point:sa1:s1"];
+    sp->admin_list.push_back(city);
+    sp->stop_area->admin_list.push_back(city);
+    b.data->build_proximity_list();
+
+    navitia::type::Data clone(1);
+    clone.clone_from(*b.data);
+    clone.build_proximity_list();
+    clone.build_autocomplete_partial();
+
+    BOOST_CHECK(clone.is_geo_ref_shared);
+    BOOST_CHECK_EQUAL(clone.geo_ref.get(), b.data->geo_ref.get());
+    BOOST_CHECK_EQUAL(clone.fare.get(), b.data->fare.get());
+
+    // the public transport data are copied, and point to the shared admins
+    const auto* cloned_sp = clone.pt_data->stop_points_map.at("stop_point:sa1:s1");
+    BOOST_CHECK_NE(cloned_sp, sp);
+    BOOST_REQUIRE_EQUAL(cloned_sp->admin_list.size(), 1);
+    BOOST_CHECK_EQUAL(cloned_sp->admin_list[0], city);
+    BOOST_REQUIRE_EQUAL(cloned_sp->stop_area->admin_list.size(), 1);
+    BOOST_CHECK_EQUAL(cloned_sp->stop_area->admin_list[0], city);
+    BOOST_REQUIRE_EQUAL(city->admin_list.size(), 1);
+    BOOST_CHECK_EQUAL(city->admin_list[0], region);
+}
+
 BOOST_AUTO_TEST_CASE(load_disruptions_fail) {
     navitia::type::Data data(0);
 